@@ -0,0 +1,291 @@
+// Author: Kevin Imlay
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define ACCEL_X86
+#endif
+
+#include "accel.h"
+#include "cpu.h"
+
+/* ----- Private Definitions ----- */
+
+#define NOT_ACCELERATED (ACCEL_MAX_EXITS + 1)
+
+
+/* ----- Private Types ----- */
+
+/*
+An exit search returns the index of the first symbol at or after begin that is one of the exit symbols
+or is not a valid symbol, or length if there is none.
+*/
+typedef unsigned int (*FindExit)(const unsigned int *input, unsigned int begin, unsigned int length,
+                                 const unsigned int *exits, unsigned int symbol_count);
+
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int findExitScalar(const unsigned int *input, unsigned int begin, unsigned int length,
+                                   const unsigned int *exits, unsigned int symbol_count);
+
+#ifdef ACCEL_X86
+static unsigned int findExitSSE2(const unsigned int *input, unsigned int begin, unsigned int length,
+                                 const unsigned int *exits, unsigned int symbol_count);
+static unsigned int findExitAVX2(const unsigned int *input, unsigned int begin, unsigned int length,
+                                 const unsigned int *exits, unsigned int symbol_count);
+#endif
+
+static FindExit selectFindExit(void);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Accelerated Table
+Actions:
+  • freeze the machine into a state table
+  • collect the exit symbols of each state, giving up on a state once it has too many
+  • a state is only accelerated if it loops back on more than half of the symbols
+*/
+FSM_STATUS initAccel(AccelTable *accel, FSM *fsm) {
+  FSM_STATUS fsm_status;
+
+  // validate inputs
+  if (accel == NULL || fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+
+  fsm_status = initStateTable(&accel->table, fsm);
+  if (fsm_status != FSM_OK)
+    return fsm_status;
+
+  // allocate
+  accel->exit_count = malloc(fsm->Qc * sizeof(unsigned char));
+  accel->exits = malloc((size_t)fsm->Qc * ACCEL_MAX_EXITS * sizeof(unsigned int));
+  if (accel->exit_count == NULL || accel->exits == NULL) {
+    freeAccel(accel);
+    return FSM_ALLOC_ERR;
+  }
+
+  // find exit symbols
+  const StateTable *table = &accel->table;
+  accel->accelerated_count = 0;
+  for (unsigned int state = 0; state < table->Qc; state++) {
+    const unsigned int *row = &table->next[(size_t)state * table->Ec];
+    unsigned int *exits = &accel->exits[(size_t)state * ACCEL_MAX_EXITS];
+    unsigned int count = 0;
+
+    for (unsigned int symbol = 0; symbol < table->Ec && count <= ACCEL_MAX_EXITS; symbol++) {
+      if (row[symbol] != state) {
+        if (count < ACCEL_MAX_EXITS)
+          exits[count] = symbol;
+        count++;
+      }
+    }
+
+    if (count > ACCEL_MAX_EXITS || 2 * count >= table->Ec) {
+      accel->exit_count[state] = NOT_ACCELERATED;
+      continue;
+    }
+
+    // pad unused entries, a state without exit symbols only stops on invalid symbols
+    for (unsigned int i = count; i < ACCEL_MAX_EXITS; i++)
+      exits[i] = (count > 0) ? exits[0] : table->Ec;
+    accel->exit_count[state] = (unsigned char)count;
+    accel->accelerated_count++;
+  }
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Accelerated Table
+Actions:
+  • free the state table and exit symbols
+*/
+void freeAccel(AccelTable *accel) {
+  if (accel == NULL)
+    return;
+
+  freeStateTable(&accel->table);
+  free(accel->exit_count);
+  free(accel->exits);
+  accel->exit_count = NULL;
+  accel->exits = NULL;
+}
+
+
+/*
+Run Accelerated
+Actions:
+  • in an accelerated state, search ahead for the next exit symbol
+  • transition on that symbol through the table, as in any other state
+*/
+INTERP_STATUS runAccel(const AccelTable *accel, const unsigned int *input, unsigned int input_length,
+                       unsigned int *end_state, unsigned int *consumed) {
+  // validate inputs
+  if (accel == NULL || accel->exit_count == NULL)
+    return INTERP_NO_MACHINE;
+  if (accel->table.start == TABLE_NO_STATE)
+    return INTERP_MACHINE_NO_START;
+
+  const StateTable *table = &accel->table;
+  FindExit findExit = selectFindExit();
+  unsigned int state = table->start;
+  unsigned int i = 0;
+
+  while (i < input_length) {
+    // skip the self-loop
+    if (accel->exit_count[state] != NOT_ACCELERATED) {
+      i = findExit(input, i, input_length, &accel->exits[(size_t)state * ACCEL_MAX_EXITS], table->Ec);
+      if (i == input_length)
+        break;
+    }
+
+    unsigned int symbol = input[i];
+    if (symbol >= table->Ec) {
+      *end_state = state;
+      *consumed = i;
+      return INTERP_SYMB_ERR;
+    }
+
+    unsigned int next = table->next[(size_t)state * table->Ec + symbol];
+    if (next == TABLE_NO_STATE) {
+      *end_state = state;
+      *consumed = i;
+      return INTERP_TRANS_ERR;
+    }
+
+    state = next;
+    i++;
+  }
+
+  *end_state = state;
+  *consumed = input_length;
+
+  // check accept state
+  if (isAccepting(table, state))
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Find Exit Scalar
+Actions:
+  • compares one symbol at a time
+*/
+static unsigned int findExitScalar(const unsigned int *input, unsigned int begin, unsigned int length,
+                                   const unsigned int *exits, unsigned int symbol_count) {
+  for (unsigned int i = begin; i < length; i++) {
+    unsigned int symbol = input[i];
+    if (symbol == exits[0] || symbol == exits[1] || symbol == exits[2] || symbol == exits[3] ||
+        symbol >= symbol_count)
+      return i;
+  }
+  return length;
+}
+
+
+/*
+Select Find Exit
+Actions:
+  • picks the widest exit search the CPU supports on the first call and keeps it
+  • kept in an atomic, as threads may select at once, and they all store the same search
+*/
+static FindExit selectFindExit(void) {
+#ifdef ACCEL_X86
+  static _Atomic(FindExit) find_exit = NULL;
+
+  FindExit selected = atomic_load_explicit(&find_exit, memory_order_relaxed);
+  if (selected == NULL) {
+    selected = cpuHasAVX2() ? findExitAVX2 : findExitSSE2;
+    atomic_store_explicit(&find_exit, selected, memory_order_relaxed);
+  }
+  return selected;
+#else
+  return findExitScalar;
+#endif
+}
+
+
+#ifdef ACCEL_X86
+
+/*
+Find Exit SSE2
+Actions:
+  • compares 4 symbols at a time against every exit symbol
+  • SSE2 has no unsigned compare, so the range check flips the sign bits and compares signed
+*/
+static unsigned int findExitSSE2(const unsigned int *input, unsigned int begin, unsigned int length,
+                                 const unsigned int *exits, unsigned int symbol_count) {
+  const __m128i sign = _mm_set1_epi32(INT_MIN);
+  const __m128i limit = _mm_set1_epi32((int)((symbol_count - 1) ^ 0x80000000u));
+  const __m128i e0 = _mm_set1_epi32((int)exits[0]);
+  const __m128i e1 = _mm_set1_epi32((int)exits[1]);
+  const __m128i e2 = _mm_set1_epi32((int)exits[2]);
+  const __m128i e3 = _mm_set1_epi32((int)exits[3]);
+
+  unsigned int i = begin;
+  for (; i + 4 <= length; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(input + i));
+    __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(v, e0), _mm_cmpeq_epi32(v, e1)),
+                               _mm_or_si128(_mm_cmpeq_epi32(v, e2), _mm_cmpeq_epi32(v, e3)));
+    hit = _mm_or_si128(hit, _mm_cmpgt_epi32(_mm_xor_si128(v, sign), limit));
+
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(hit));
+    if (mask != 0)
+      return i + (unsigned int)__builtin_ctz((unsigned int)mask);
+  }
+
+  return findExitScalar(input, i, length, exits, symbol_count);
+}
+
+
+/*
+Find Exit AVX2
+Actions:
+  • compares 16 symbols at a time, in two vectors of 8, against every exit symbol
+*/
+__attribute__((target("avx2")))
+static unsigned int findExitAVX2(const unsigned int *input, unsigned int begin, unsigned int length,
+                                 const unsigned int *exits, unsigned int symbol_count) {
+  const __m256i limit = _mm256_set1_epi32((int)(symbol_count - 1));
+  const __m256i e0 = _mm256_set1_epi32((int)exits[0]);
+  const __m256i e1 = _mm256_set1_epi32((int)exits[1]);
+  const __m256i e2 = _mm256_set1_epi32((int)exits[2]);
+  const __m256i e3 = _mm256_set1_epi32((int)exits[3]);
+
+  unsigned int i = begin;
+  for (; i + 16 <= length; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(input + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(input + i + 8));
+
+    // unsigned x > limit is max(x, limit) != limit
+    __m256i hit_a = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(a, e0), _mm256_cmpeq_epi32(a, e1)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi32(a, e2), _mm256_cmpeq_epi32(a, e3)));
+    __m256i hit_b = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(b, e0), _mm256_cmpeq_epi32(b, e1)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi32(b, e2), _mm256_cmpeq_epi32(b, e3)));
+    __m256i ok_a = _mm256_cmpeq_epi32(_mm256_max_epu32(a, limit), limit);
+    __m256i ok_b = _mm256_cmpeq_epi32(_mm256_max_epu32(b, limit), limit);
+    hit_a = _mm256_or_si256(hit_a, _mm256_xor_si256(ok_a, _mm256_set1_epi32(-1)));
+    hit_b = _mm256_or_si256(hit_b, _mm256_xor_si256(ok_b, _mm256_set1_epi32(-1)));
+
+    unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(hit_a)) |
+                        ((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(hit_b)) << 8);
+    if (mask != 0)
+      return i + (unsigned int)__builtin_ctz(mask);
+  }
+
+  return findExitSSE2(input, i, length, exits, symbol_count);
+}
+
+#endif
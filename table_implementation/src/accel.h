@@ -0,0 +1,107 @@
+// Author: Kevin Imlay
+
+/*
+Self-loop acceleration. Many states transition back to themselves on nearly every symbol and only leave
+on a few exit symbols, such as the inside of a quoted string that is only left on a quote or a
+backslash. While in such a state, the input does not need to be looked up in the table symbol by symbol:
+it is enough to search ahead for the next exit symbol, which is done several symbols at a time with SSE2
+or AVX2 compares.
+
+A state is accelerated if it has at most ACCEL_MAX_EXITS exit symbols. An exit symbol is any symbol
+whose transition does not lead back to the state, including symbols with no transition at all.
+No actions are run by the accelerated run.
+*/
+
+#ifndef ACCEL_H
+#define ACCEL_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Most exit symbols an accelerated state may have.
+*/
+#define ACCEL_MAX_EXITS 4
+
+
+/* ----- Structures ----- */
+
+/*
+Accelerated machine.
+*/
+typedef struct {
+  // frozen transition table of the machine
+  StateTable table;
+
+  // count of exit symbols of each state, or ACCEL_MAX_EXITS + 1 if the state is not accelerated
+  unsigned char *exit_count;
+
+  // exit symbols of each state, ACCEL_MAX_EXITS per state (continuous array for 2d array)
+  // Note: unused entries repeat an exit symbol, so searches can always compare all of them.
+  unsigned int *exits;
+
+  // count of accelerated states
+  unsigned int accelerated_count;
+
+} AccelTable;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Accelerated Table
+Freezes a machine's transition table and finds its self-looping states and their exit symbols.
+
+Arguments:
+  • accel - pointer to the accelerated table to initialize.
+  • fsm - pointer to an initialized FSM.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either the table or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initAccel(AccelTable *accel, FSM *fsm);
+
+
+/*
+Free Accelerated Table
+Releases the memory held by an accelerated table.
+
+Arguments:
+  • accel - pointer to the accelerated table.
+      Note: may be null.
+*/
+void freeAccel(AccelTable *accel);
+
+
+/*
+Run Accelerated
+Runs the input from the machine's start state, skipping ahead to the next exit symbol while in an
+accelerated state.
+
+Arguments:
+  • accel - pointer to the accelerated table.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+  • end_state - [pass back] ID of the state the run ended in.
+      Note: on an error, the state the failing symbol was read in.
+  • consumed - [pass back] count of symbols transitioned on.
+      Note: on an error, the index of the failing symbol.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+  • INTERP_NO_MACHINE - if the table provided is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS runAccel(const AccelTable *accel, const unsigned int *input, unsigned int input_length,
+                       unsigned int *end_state, unsigned int *consumed);
+
+#endif
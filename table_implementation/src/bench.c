@@ -0,0 +1,2305 @@
+// Author: Kevin Imlay
+
+/*
+Benchmark harness for the table implementation. Each benchmark builds its own machine and input, times
+its runs and prints the rate per symbol. Run with no arguments to run every benchmark, or with the names
+of the benchmarks to run.
+
+Run with -c to count hardware events (cycles, cache, branch and TLB misses) around each run timed by
+timeInterpreter(), printed per symbol under its rate, for example:
+  ./bench -c reorder
+Events the system does not allow counting are left out. The perf benchmark sweeps table sizes with the
+counters open.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "accel.h"
+#include "bulk.h"
+#include "chart.h"
+#include "checkpoint.h"
+#include "build.h"
+#include "comb.h"
+#include "counter.h"
+#include "cpu.h"
+#include "defrow.h"
+#include "incremental.h"
+#include "interpreter.h"
+#include "packed.h"
+#include "perf.h"
+#include "recognize.h"
+#include "reorder.h"
+#include "replica.h"
+#include "scan.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "trace.h"
+#include "transducer.h"
+#include "unicode.h"
+
+/* ----- Private Definitions ----- */
+
+#define BENCH_REPEATS 3
+
+
+/* ----- Private Structures ----- */
+
+/*
+Named benchmark.
+*/
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} Benchmark;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static double nowSeconds(void);
+static unsigned long long nextRandom(unsigned long long *seed);
+static void reportRate(const char *label, unsigned long long symbols, double seconds);
+static void reportCounts(const PerfCounters *counters, unsigned long long symbols);
+static void countAction(void);
+static void buildChainMachine(FSM *fsm, unsigned int state_count, unsigned int symbol_count,
+                              unsigned long long seed);
+static unsigned int *buildChainInput(unsigned int length, unsigned int symbol_count, unsigned int hot_percent,
+                                     unsigned long long seed);
+static double timeInterpreter(FSM *fsm, unsigned int *input, unsigned int length);
+static void buildSparseMachine(FSM *fsm, unsigned int state_count, unsigned int symbol_count,
+                               unsigned int transitions_per_state, unsigned long long seed);
+static unsigned int *buildWalkInput(FSM *fsm, unsigned int length, unsigned long long seed);
+
+static void benchReorder(void);
+static void benchStream(void);
+static void benchScan(void);
+static void benchAccel(void);
+static void benchRecognize(void);
+static void benchComb(void);
+static void benchDefault(void);
+static void benchTotal(void);
+static void benchBuild(void);
+static void benchPages(void);
+static void benchReplica(void);
+static void benchPacked(void);
+static void benchUnicode(void);
+static void benchScheduler(void);
+static void benchTimer(void);
+static void expireBenchTimer(Timer *timer);
+static void benchChart(void);
+static unsigned int walkChart(const Chart *chart, unsigned int leaf, unsigned int symbol,
+                              unsigned long long *actions);
+static void benchTrace(void);
+static void benchMunch(void);
+static void benchIncremental(void);
+static void benchTransducer(void);
+static void emitAction(void);
+static void benchCounter(void);
+static void benchPerf(void);
+static void benchBulk(void);
+
+
+/* ----- Private Variables ----- */
+
+static unsigned long long action_calls = 0;
+
+// wheel the timer benchmark runs, and its timers that expired off their tick
+static TimerWheel *bench_wheel = NULL;
+static unsigned long long late_timers = 0;
+
+// counters opened by -c, null without it, and whether the counts of the last timed run are yet to print
+static PerfCounters *bench_counters = NULL;
+static int counts_pending = 0;
+
+// buffer the transducer benchmark's actions write to, and the interpreter running them
+static unsigned int *emit_buffer = NULL;
+static size_t emit_count = 0;
+static const Interpreter *emit_interp = NULL;
+
+static const Benchmark benchmarks[] = {
+  {"reorder", benchReorder},
+  {"stream", benchStream},
+  {"scan", benchScan},
+  {"accel", benchAccel},
+  {"recognize", benchRecognize},
+  {"comb", benchComb},
+  {"defrow", benchDefault},
+  {"total", benchTotal},
+  {"build", benchBuild},
+  {"pages", benchPages},
+  {"numa", benchReplica},
+  {"packed", benchPacked},
+  {"unicode", benchUnicode},
+  {"sched", benchScheduler},
+  {"timer", benchTimer},
+  {"chart", benchChart},
+  {"trace", benchTrace},
+  {"munch", benchMunch},
+  {"incr", benchIncremental},
+  {"transduce", benchTransducer},
+  {"counter", benchCounter},
+  {"perf", benchPerf},
+  {"bulk", benchBulk},
+};
+
+
+/* ----- Main ----- */
+
+int main(int argc, char *argv[]) {
+  unsigned int benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+  // counters
+  PerfCounters counters;
+  int first_name = 1;
+  if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+    first_name = 2;
+    if (initPerfCounters(&counters) > 0)
+      bench_counters = &counters;
+    else
+      printf("no performance counters available, running without\n\n");
+  }
+
+  for (unsigned int i = 0; i < benchmark_count; i++) {
+    int selected = (argc <= first_name);
+    for (int j = first_name; j < argc; j++)
+      if (strcmp(argv[j], benchmarks[i].name) == 0)
+        selected = 1;
+    if (!selected)
+      continue;
+
+    printf("== %s ==\n", benchmarks[i].name);
+    benchmarks[i].run();
+    printf("\n");
+  }
+
+  freePerfCounters(bench_counters);
+  return 0;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Now Seconds
+Actions:
+  • reads the monotonic clock
+*/
+static double nowSeconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+/*
+Next Random
+Actions:
+  • xorshift64 step, so benchmark machines are the same on every run
+*/
+static unsigned long long nextRandom(unsigned long long *seed) {
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+
+/*
+Report Rate
+Actions:
+  • prints time per symbol and symbols per second
+*/
+static void reportRate(const char *label, unsigned long long symbols, double seconds) {
+  printf("  %-32s %8.3f ns/symbol %10.1f Msymbols/s\n", label, seconds * 1e9 / (double)symbols,
+         (double)symbols / seconds * 1e-6);
+  if (counts_pending) {
+    reportCounts(bench_counters, symbols);
+    counts_pending = 0;
+  }
+}
+
+
+/*
+Report Counts
+Actions:
+  • prints each counted event of the last measured run per symbol, marking open events never scheduled
+*/
+static void reportCounts(const PerfCounters *counters, unsigned long long symbols) {
+  printf("    per symbol:");
+  for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++) {
+    if (!perfCounterOpen(counters, event))
+      continue;
+    double rate = perfPerSymbol(counters, event, symbols);
+    if (rate < 0.0)
+      printf(" %s not scheduled", perfEventName(event));
+    else
+      printf(" %s %.4g", perfEventName(event), rate);
+  }
+  printf("\n");
+}
+
+
+/*
+Count Action
+Actions:
+  • counts its calls, so benchmarked actions are not optimized away
+*/
+static void countAction(void) {
+  action_calls++;
+}
+
+
+/*
+Build Chain Machine
+Actions:
+  • symbol 0 moves along one long cycle through all states, in a random order of IDs
+  • every other symbol moves to a random state
+  • state 0 is the start state, every state is complete so runs never fail
+*/
+static void buildChainMachine(FSM *fsm, unsigned int state_count, unsigned int symbol_count,
+                              unsigned long long seed) {
+  unsigned int *cycle = malloc(state_count * sizeof(unsigned int));
+
+  initFSM(fsm, state_count, symbol_count);
+  confState(fsm, 0, START_STATE, NULL);
+
+  // shuffled cycle of state IDs
+  for (unsigned int i = 0; i < state_count; i++)
+    cycle[i] = i;
+  for (unsigned int i = state_count - 1; i > 0; i--) {
+    unsigned int j = nextRandom(&seed) % (i + 1);
+    unsigned int temp = cycle[i];
+    cycle[i] = cycle[j];
+    cycle[j] = temp;
+  }
+
+  for (unsigned int i = 0; i < state_count; i++) {
+    addTrans(fsm, cycle[i], cycle[(i + 1) % state_count], 0);
+    for (unsigned int symbol = 1; symbol < symbol_count; symbol++)
+      addTrans(fsm, cycle[i], nextRandom(&seed) % state_count, symbol);
+  }
+
+  free(cycle);
+}
+
+
+/*
+Build Chain Input
+Actions:
+  • hot_percent of symbols are symbol 0, the rest are random symbols
+*/
+static unsigned int *buildChainInput(unsigned int length, unsigned int symbol_count, unsigned int hot_percent,
+                                     unsigned long long seed) {
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+
+  for (unsigned int i = 0; i < length; i++) {
+    if (nextRandom(&seed) % 100 < hot_percent)
+      input[i] = 0;
+    else
+      input[i] = nextRandom(&seed) % symbol_count;
+  }
+
+  return input;
+}
+
+
+/*
+Time Interpreter
+Actions:
+  • runs the input through runInterpreter() from the start state, best of a few repeats
+  • with counters open, counts each run and keeps the counts of the best for reportRate() to print
+*/
+static double timeInterpreter(FSM *fsm, unsigned int *input, unsigned int length) {
+  double best = 0.0;
+  unsigned long long best_counts[PERF_EVENT_COUNT];
+  int best_counted[PERF_EVENT_COUNT];
+
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    Interpreter interp;
+    initInterpreter(&interp, fsm);
+
+    double start = nowSeconds();
+    if (bench_counters != NULL)
+      runMeasured(&interp, bench_counters, input, length);
+    else
+      runInterpreter(&interp, input, length);
+    double elapsed = nowSeconds() - start;
+
+    if (r == 0 || elapsed < best) {
+      best = elapsed;
+      if (bench_counters != NULL) {
+        memcpy(best_counts, bench_counters->values, sizeof(best_counts));
+        memcpy(best_counted, bench_counters->counted, sizeof(best_counted));
+      }
+    }
+  }
+
+  if (bench_counters != NULL) {
+    memcpy(bench_counters->values, best_counts, sizeof(best_counts));
+    memcpy(bench_counters->counted, best_counted, sizeof(best_counted));
+    counts_pending = 1;
+  }
+  return best;
+}
+
+
+/*
+Build Sparse Machine
+Actions:
+  • gives every state a few transitions on random symbols to random states
+  • state 0 is the start state, odd states are accepting
+*/
+static void buildSparseMachine(FSM *fsm, unsigned int state_count, unsigned int symbol_count,
+                               unsigned int transitions_per_state, unsigned long long seed) {
+  initFSM(fsm, state_count, symbol_count);
+  confState(fsm, 0, START_STATE, NULL);
+  for (unsigned int state = 1; state < state_count; state += 2)
+    confState(fsm, state, ACCEPT_STATE, NULL);
+
+  for (unsigned int state = 0; state < state_count; state++)
+    for (unsigned int i = 0; i < transitions_per_state; i++)
+      addTrans(fsm, state, nextRandom(&seed) % state_count, nextRandom(&seed) % symbol_count);
+}
+
+
+/*
+Build Walk Input
+Actions:
+  • walks the machine from its start state, picking a random existing transition at each step
+*/
+static unsigned int *buildWalkInput(FSM *fsm, unsigned int length, unsigned long long seed) {
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  unsigned int *symbols = malloc(fsm->Ec * sizeof(unsigned int));
+  State *state = fsm->Qs;
+
+  for (unsigned int i = 0; i < length; i++) {
+    State **row = &fsm->D[(size_t)state->id * fsm->Ec];
+    unsigned int n = 0;
+    for (unsigned int symbol = 0; symbol < fsm->Ec; symbol++)
+      if (row[symbol] != NULL)
+        symbols[n++] = symbol;
+    input[i] = symbols[nextRandom(&seed) % n];
+    state = row[input[i]];
+  }
+
+  free(symbols);
+  return input;
+}
+
+
+/*
+Bench Reorder
+Actions:
+  • runs a large machine whose hot path is scattered across the table
+  • renumbers it in BFS and profiled frequency order and runs it again
+*/
+static void benchReorder(void) {
+  const unsigned int state_count = 1u << 20;
+  const unsigned int symbol_count = 8;
+  const unsigned int length = 1u << 23;
+  FSM machine, renumbered;
+
+  buildChainMachine(&machine, state_count, symbol_count, 0x9E3779B97F4A7C15ULL);
+  unsigned int *input = buildChainInput(length, symbol_count, 95, 0xD1B54A32D192ED03ULL);
+  unsigned int *old_to_new = malloc(state_count * sizeof(unsigned int));
+  unsigned long long *counts = calloc((size_t)state_count * symbol_count, sizeof(unsigned long long));
+
+  printf("  %u states, %u symbols, %u symbols of input\n", state_count, symbol_count, length);
+  reportRate("original numbering", length, timeInterpreter(&machine, input, length));
+
+  orderStates(&machine, ORDER_BFS, NULL, old_to_new);
+  renumberFSM(&machine, &renumbered, old_to_new);
+  reportRate("BFS order", length, timeInterpreter(&renumbered, input, length));
+  freeFSM(&renumbered);
+
+  double start = nowSeconds();
+  profileTransitions(&machine, input, length, counts);
+  orderStates(&machine, ORDER_FREQUENCY, counts, old_to_new);
+  renumberFSM(&machine, &renumbered, old_to_new);
+  printf("  profile and renumber took %.3f s\n", nowSeconds() - start);
+  reportRate("profiled frequency order", length, timeInterpreter(&renumbered, input, length));
+  freeFSM(&renumbered);
+
+  freeFSM(&machine);
+  free(input);
+  free(old_to_new);
+  free(counts);
+}
+
+
+/*
+Bench Stream
+Actions:
+  • runs a cache resident machine with runInterpreter() in one call
+  • runs the same input through the streaming API in chunks of several sizes
+*/
+static void benchStream(void) {
+  const unsigned int state_count = 1024;
+  const unsigned int symbol_count = 8;
+  const unsigned int length = 1u << 24;
+  const unsigned int chunk_sizes[] = {1, 16, 1500, 65536};
+  FSM machine;
+
+  buildChainMachine(&machine, state_count, symbol_count, 0x9E3779B97F4A7C15ULL);
+  unsigned int *input = buildChainInput(length, symbol_count, 50, 0xD1B54A32D192ED03ULL);
+
+  reportRate("runInterpreter, one call", length, timeInterpreter(&machine, input, length));
+
+  for (unsigned int c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+    double best = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+      Interpreter interp;
+      initInterpreter(&interp, &machine);
+
+      double start = nowSeconds();
+      beginInterpreter(&interp);
+      for (unsigned int i = 0; i < length; i += chunk_sizes[c]) {
+        unsigned int chunk_length = (length - i < chunk_sizes[c]) ? length - i : chunk_sizes[c];
+        feedInterpreter(&interp, &input[i], chunk_length);
+      }
+      endInterpreter(&interp);
+      double elapsed = nowSeconds() - start;
+
+      if (r == 0 || elapsed < best)
+        best = elapsed;
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "feedInterpreter, chunks of %u", chunk_sizes[c]);
+    reportRate(label, length, best);
+  }
+
+  freeFSM(&machine);
+  free(input);
+}
+
+
+/*
+Bench Scan
+Actions:
+  • builds a filter that accepts inputs containing a short pattern and rejects inputs containing a
+      rare forbidden symbol, whichever comes first
+  • runs many random inputs with runInterpreter() and with scanInput()
+*/
+static void benchScan(void) {
+  const unsigned int pattern[] = {1, 2};
+  const unsigned int pattern_length = 2;
+  const unsigned int symbol_count = 16;
+  const unsigned int forbidden = 15;
+  const unsigned int accept_id = pattern_length;
+  const unsigned int reject_id = pattern_length + 1;
+  const unsigned int input_count = 256;
+  const unsigned int length = 1u << 16;
+  unsigned long long seed = 0x2545F4914F6CDD1DULL;
+  FSM machine;
+  Scanner scanner;
+
+  // states 0 to pattern_length - 1 count matched pattern symbols
+  initFSM(&machine, pattern_length + 2, symbol_count);
+  confState(&machine, 0, START_STATE, NULL);
+  confState(&machine, accept_id, ACCEPT_STATE, NULL);
+  for (unsigned int state = 0; state < pattern_length; state++) {
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+      if (symbol == forbidden)
+        addTrans(&machine, state, reject_id, symbol);
+      else if (symbol == pattern[state])
+        addTrans(&machine, state, state + 1, symbol);
+      else
+        addTrans(&machine, state, (symbol == pattern[0]) ? 1 : 0, symbol);
+    }
+  }
+  for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+    addTrans(&machine, accept_id, accept_id, symbol);
+    addTrans(&machine, reject_id, reject_id, symbol);
+  }
+  initScanner(&scanner, &machine);
+
+  unsigned int *inputs = malloc((size_t)input_count * length * sizeof(unsigned int));
+  for (size_t i = 0; i < (size_t)input_count * length; i++) {
+    if (nextRandom(&seed) % 1000 == 0)
+      inputs[i] = forbidden;
+    else
+      inputs[i] = nextRandom(&seed) % (symbol_count - 1);
+  }
+
+  // full runs
+  unsigned int accepted = 0;
+  double start = nowSeconds();
+  for (unsigned int i = 0; i < input_count; i++) {
+    Interpreter interp;
+    initInterpreter(&interp, &machine);
+    if (runInterpreter(&interp, &inputs[(size_t)i * length], length) == INTERP_ACCEPT)
+      accepted++;
+  }
+  reportRate("runInterpreter", (unsigned long long)input_count * length, nowSeconds() - start);
+
+  // early exit
+  unsigned long long consumed = 0;
+  unsigned int scan_accepted = 0;
+  start = nowSeconds();
+  for (unsigned int i = 0; i < input_count; i++) {
+    ScanResult result;
+    if (scanInput(&scanner, &inputs[(size_t)i * length], length, &result) == INTERP_ACCEPT)
+      scan_accepted++;
+    consumed += result.consumed;
+  }
+  reportRate("scanInput (per input symbol)", (unsigned long long)input_count * length, nowSeconds() - start);
+  printf("  accepted %u/%u (scan %u/%u), %.1f symbols read per input\n", accepted, input_count,
+         scan_accepted, input_count, (double)consumed / input_count);
+
+  freeScanner(&scanner);
+  freeFSM(&machine);
+  free(inputs);
+}
+
+
+/*
+Bench Accel
+Actions:
+  • builds a byte machine for text with quoted strings and backslash escapes
+  • runs random text with rare quotes with runInterpreter(), a plain table walk and runAccel()
+*/
+static void benchAccel(void) {
+  enum { CODE_ID = 0, STRING_ID, ESCAPE_ID };
+  const unsigned int symbol_count = 256;
+  const unsigned int quote = '"';
+  const unsigned int backslash = '\\';
+  const unsigned int length = 1u << 24;
+  unsigned long long seed = 0x853C49E6748FEA9BULL;
+  FSM machine;
+  AccelTable accel;
+
+  initFSM(&machine, 3, symbol_count);
+  confState(&machine, CODE_ID, START_STATE, NULL);
+  for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+    addTrans(&machine, CODE_ID, (symbol == quote) ? STRING_ID : CODE_ID, symbol);
+    if (symbol == quote)
+      addTrans(&machine, STRING_ID, CODE_ID, symbol);
+    else
+      addTrans(&machine, STRING_ID, (symbol == backslash) ? ESCAPE_ID : STRING_ID, symbol);
+    addTrans(&machine, ESCAPE_ID, STRING_ID, symbol);
+  }
+  initAccel(&accel, &machine);
+
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++) {
+    unsigned int roll = nextRandom(&seed) % 1000;
+    if (roll < 4)
+      input[i] = quote;
+    else if (roll < 5)
+      input[i] = backslash;
+    else
+      input[i] = 'a' + nextRandom(&seed) % 26;
+  }
+
+  reportRate("runInterpreter", length, timeInterpreter(&machine, input, length));
+
+  // plain walk of the same table, for reference
+  const StateTable *table = &accel.table;
+  unsigned int walk_state = table->start;
+  double start = nowSeconds();
+  for (unsigned int i = 0; i < length; i++)
+    walk_state = table->next[(size_t)walk_state * table->Ec + input[i]];
+  reportRate("state table walk", length, nowSeconds() - start);
+
+  unsigned int end_state = 0, consumed;
+  double best = 0.0;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    start = nowSeconds();
+    runAccel(&accel, input, length, &end_state, &consumed);
+    double elapsed = nowSeconds() - start;
+    if (r == 0 || elapsed < best)
+      best = elapsed;
+  }
+  reportRate("runAccel", length, best);
+  printf("  runAccel: %.2f GB/s of 32-bit symbols, %u accelerated states, results %s\n",
+         (double)length * sizeof(unsigned int) / best * 1e-9, accel.accelerated_count,
+         (walk_state == end_state) ? "agree" : "DISAGREE");
+
+  freeAccel(&accel);
+  freeFSM(&machine);
+  free(input);
+}
+
+
+/*
+Bench Recognize
+Actions:
+  • runs a cache resident machine without actions with runInterpreter() and recognizeInput()
+  • gives every state an action and runs it with runInterpreter() and in deferred batches
+*/
+static void benchRecognize(void) {
+  const unsigned int state_count = 1024;
+  const unsigned int symbol_count = 8;
+  const unsigned int length = 1u << 24;
+  const unsigned int batch = 4096;
+  FSM machine;
+  StateTable table;
+
+  buildChainMachine(&machine, state_count, symbol_count, 0x9E3779B97F4A7C15ULL);
+  for (unsigned int i = 1; i < state_count; i += 2)
+    confState(&machine, i, ACCEPT_STATE, NULL);
+  initStateTable(&table, &machine);
+  unsigned int *input = buildChainInput(length, symbol_count, 50, 0xD1B54A32D192ED03ULL);
+  unsigned int *entered = malloc(batch * sizeof(unsigned int));
+
+  // recognition only
+  reportRate("runInterpreter, no actions", length, timeInterpreter(&machine, input, length));
+  double start = nowSeconds();
+  recognizeInput(&table, input, length);
+  reportRate("recognizeInput", length, nowSeconds() - start);
+
+  // with actions
+  for (unsigned int i = 1; i < state_count; i++)
+    confState(&machine, i, machine.Q[i].type, countAction);
+  reportRate("runInterpreter, actions", length, timeInterpreter(&machine, input, length));
+
+  Interpreter interp;
+  initInterpreter(&interp, &machine);
+  start = nowSeconds();
+  for (unsigned int i = 0; i < length; ) {
+    unsigned int entered_count;
+    runDeferred(&interp, &table, &input[i], length - i, entered, batch, &entered_count);
+    runDeferredActions(&interp, entered, entered_count);
+    i += entered_count;
+  }
+  reportRate("runDeferred, actions batched", length, nowSeconds() - start);
+
+  freeStateTable(&table);
+  freeFSM(&machine);
+  free(input);
+  free(entered);
+}
+
+
+/*
+Bench Comb
+Actions:
+  • builds a large machine with a few transitions per state over a byte sized alphabet
+  • reports the comb table's build time, fill ratio and size against the dense state table
+  • walks the machine through both tables
+*/
+static void benchComb(void) {
+  const unsigned int state_count = 1u << 16;
+  const unsigned int symbol_count = 256;
+  const unsigned int length = 1u << 23;
+  FSM machine;
+  StateTable table;
+  CombTable comb;
+
+  buildSparseMachine(&machine, state_count, symbol_count, 6, 0x9E3779B97F4A7C15ULL);
+  unsigned int *input = buildWalkInput(&machine, length, 0xD1B54A32D192ED03ULL);
+  initStateTable(&table, &machine);
+
+  double start = nowSeconds();
+  initCombTable(&comb, &machine);
+  double build = nowSeconds() - start;
+
+  size_t dense_bytes = (size_t)state_count * symbol_count * sizeof(unsigned int);
+  size_t comb_bytes = comb.size * 2 * sizeof(unsigned int) + (size_t)state_count * sizeof(size_t);
+  printf("  %u states, %u symbols, %zu transitions\n", state_count, symbol_count, comb.transitions);
+  printf("  comb build %.3f s, fill ratio %.3f, %zu slots\n", build, combFillRatio(&comb), comb.size);
+  printf("  dense table %.1f MiB, comb table %.1f MiB\n", dense_bytes / 1048576.0, comb_bytes / 1048576.0);
+
+  INTERP_STATUS dense_status = INTERP_OK, comb_status = INTERP_OK;
+  start = nowSeconds();
+  dense_status = recognizeInput(&table, input, length);
+  reportRate("recognizeInput, dense table", length, nowSeconds() - start);
+  start = nowSeconds();
+  comb_status = recognizeComb(&comb, input, length);
+  reportRate("recognizeComb", length, nowSeconds() - start);
+  printf("  results %s\n", (dense_status == comb_status) ? "agree" : "DISAGREE");
+
+  freeCombTable(&comb);
+  freeStateTable(&table);
+  freeFSM(&machine);
+  free(input);
+}
+
+
+/*
+Bench Default
+Actions:
+  • builds a large machine where each state sends every symbol to one state, with a few exceptions,
+      and every other state repeats the row of the state before it with one change
+  • reports the size of the default row table against the dense state table
+  • walks random input through both tables
+*/
+static void benchDefault(void) {
+  const unsigned int state_count = 1u << 16;
+  const unsigned int symbol_count = 256;
+  const unsigned int length = 1u << 23;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  FSM machine;
+  StateTable table;
+  DefaultTable defrow;
+
+  initFSM(&machine, state_count, symbol_count);
+  confState(&machine, 0, START_STATE, NULL);
+  for (unsigned int state = 1; state < state_count; state += 2)
+    confState(&machine, state, ACCEPT_STATE, NULL);
+  for (unsigned int state = 0; state < state_count; state += 2) {
+    unsigned int target = nextRandom(&seed) % state_count;
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+      addTrans(&machine, state, target, symbol);
+    for (unsigned int i = 0; i < 3; i++)
+      addTrans(&machine, state, nextRandom(&seed) % state_count, nextRandom(&seed) % symbol_count);
+
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+      addTrans(&machine, state + 1, machine.D[(size_t)state * symbol_count + symbol]->id, symbol);
+    addTrans(&machine, state + 1, nextRandom(&seed) % state_count, nextRandom(&seed) % symbol_count);
+  }
+
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++)
+    input[i] = nextRandom(&seed) % symbol_count;
+
+  initStateTable(&table, &machine);
+  double start = nowSeconds();
+  initDefaultTable(&defrow, &machine);
+  double build = nowSeconds() - start;
+
+  size_t dense_bytes = (size_t)state_count * symbol_count * sizeof(unsigned int);
+  size_t defrow_bytes = (size_t)state_count * (sizeof(unsigned int) + sizeof(size_t)) +
+                        defrow.offset[state_count] * 2 * sizeof(unsigned int);
+  printf("  %u states, %u symbols, %zu exceptions, %u template rows, build %.3f s\n", state_count,
+         symbol_count, defrow.exceptions, defrow.templates, build);
+  printf("  dense table %.1f MiB, default row table %.2f MiB\n", dense_bytes / 1048576.0,
+         defrow_bytes / 1048576.0);
+
+  start = nowSeconds();
+  INTERP_STATUS dense_status = recognizeInput(&table, input, length);
+  reportRate("recognizeInput, dense table", length, nowSeconds() - start);
+  start = nowSeconds();
+  INTERP_STATUS defrow_status = recognizeDefault(&defrow, input, length);
+  reportRate("recognizeDefault", length, nowSeconds() - start);
+  printf("  results %s\n", (dense_status == defrow_status) ? "agree" : "DISAGREE");
+
+  freeDefaultTable(&defrow);
+  freeStateTable(&table);
+  freeFSM(&machine);
+  free(input);
+}
+
+
+/*
+Bench Total
+Actions:
+  • runs a cache resident sparse machine with runInterpreter(), with an action on each state
+  • without actions, runs it with runInterpreter() and walks its table checking each symbol and transition
+  • totalizes it, walks its table with no checks, and runs it with runTotalized() without and with the
+    actions, checking the final states
+  • breaks the input with a symbol that has no transition and checks where the sink state is found
+*/
+static void benchTotal(void) {
+  const unsigned int state_count = 1024;
+  const unsigned int symbol_count = 16;
+  const unsigned int length = 1u << 24;
+  FSM machine;
+
+  buildSparseMachine(&machine, state_count, symbol_count, 4, 0x9E3779B97F4A7C15ULL);
+  for (unsigned int i = 1; i < state_count; i++)
+    confState(&machine, i, machine.Q[i].type, countAction);
+  unsigned int *input = buildWalkInput(&machine, length, 0xD1B54A32D192ED03ULL);
+
+  reportRate("runInterpreter, actions", length, timeInterpreter(&machine, input, length));
+
+  // without actions, so the saving on the missing transition check is not hidden by the calls
+  for (unsigned int i = 1; i < state_count; i++)
+    confState(&machine, i, machine.Q[i].type, NULL);
+  reportRate("runInterpreter, no actions", length, timeInterpreter(&machine, input, length));
+
+  unsigned int walked = 0, sink_id = 0;
+  for (int total = 0; total <= 1; total++) {
+    if (total)
+      totalizeFSM(&machine, &sink_id);
+    double best = 0.0;
+    unsigned int ended = 0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+      double start = nowSeconds();
+      State *state = machine.Qs;
+      if (total) {
+        // every symbol is in range and every transition exists, as the input is a walk
+        for (unsigned int i = 0; i < length; i++)
+          state = machine.D[(size_t)state->id * symbol_count + input[i]];
+      } else {
+        for (unsigned int i = 0; i < length; i++) {
+          if (input[i] >= symbol_count)
+            break;
+          State *next = machine.D[(size_t)state->id * symbol_count + input[i]];
+          if (next == NULL)
+            break;
+          state = next;
+        }
+      }
+      double elapsed = nowSeconds() - start;
+
+      ended = state->id;
+      if (r == 0 || elapsed < best)
+        best = elapsed;
+    }
+    if (!total)
+      walked = ended;
+    char label[64];
+    snprintf(label, sizeof(label), "%s table walk%s", total ? "totalized, unchecked" : "checked",
+             (ended == walked) ? "" : ", WRONG");
+    reportRate(label, length, best);
+  }
+
+  unsigned int sink_position = 0;
+  for (int with_actions = 0; with_actions <= 1; with_actions++) {
+    for (unsigned int i = 1; i < state_count; i++)
+      confState(&machine, i, machine.Q[i].type, with_actions ? countAction : NULL);
+    unsigned int ended = 0;
+    double best = 0.0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+      Interpreter interp;
+      initInterpreter(&interp, &machine);
+
+      double start = nowSeconds();
+      runTotalized(&interp, input, length, &sink_position);
+      double elapsed = nowSeconds() - start;
+
+      ended = interp.current_state->id;
+      if (r == 0 || elapsed < best)
+        best = elapsed;
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "runTotalized, %s%s", with_actions ? "actions" : "no actions",
+             (ended == walked) ? "" : ", WRONG");
+    reportRate(label, length, best);
+  }
+
+  // break the input part way through, on a symbol the state reached there has no transition on
+  unsigned int broken = length / 3 + 17;
+  State *state = machine.Qs;
+  for (unsigned int i = 0; i < broken; i++)
+    state = machine.D[(size_t)state->id * symbol_count + input[i]];
+  for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+    if (machine.D[(size_t)state->id * symbol_count + symbol]->id == sink_id)
+      input[broken] = symbol;
+
+  Interpreter interp;
+  initInterpreter(&interp, &machine);
+  INTERP_STATUS status = runTotalized(&interp, input, length, &sink_position);
+  printf("  sink entered at %u, expected %u: %s\n", sink_position, broken,
+         (status == INTERP_TRANS_ERR && sink_position == broken && interp.current_state == state) ? "ok" : "WRONG");
+
+  freeFSM(&machine);
+  free(input);
+}
+
+/*
+Bench Build
+Actions:
+  • generates the states and edges of a machine with millions of states
+  • builds it with confState() and addTrans(), then with confStates() and addTransitions() on a few
+    thread counts
+  • checks every build has the same transition table
+*/
+static void benchBuild(void) {
+  const unsigned int state_count = 1u << 21;
+  const unsigned int symbol_count = 8;
+  const size_t edge_count = (size_t)state_count * 4;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  FSM serial, bulk;
+
+  STATE_TYPE *types = malloc(state_count * sizeof(STATE_TYPE));
+  unsigned int *from = malloc(edge_count * sizeof(unsigned int));
+  unsigned int *symbols = malloc(edge_count * sizeof(unsigned int));
+  unsigned int *to = malloc(edge_count * sizeof(unsigned int));
+  for (unsigned int i = 0; i < state_count; i++)
+    types[i] = (i == 0) ? START_STATE : ((i & 1) ? ACCEPT_STATE : NORMAL_STATE);
+  for (size_t i = 0; i < edge_count; i++) {
+    from[i] = nextRandom(&seed) % state_count;
+    symbols[i] = nextRandom(&seed) % symbol_count;
+    to[i] = nextRandom(&seed) % state_count;
+  }
+
+  // one call per state and edge
+  initFSM(&serial, state_count, symbol_count);
+  double start = nowSeconds();
+  for (unsigned int i = 0; i < state_count; i++)
+    confState(&serial, i, types[i], NULL);
+  for (size_t i = 0; i < edge_count; i++)
+    addTrans(&serial, from[i], to[i], symbols[i]);
+  double elapsed = nowSeconds() - start;
+  printf("  %u states, %zu edges\n", state_count, edge_count);
+  printf("  %-44s %8.3f s\n", "confState + addTrans", elapsed);
+
+  // bulk, on one thread, a few threads, and every CPU
+  unsigned int thread_counts[] = {1, 4, 16, 0};
+  int same = 1;
+  for (unsigned int r = 0; r < 4; r++) {
+    unsigned int bad_state;
+    size_t bad_edge;
+    initFSM(&bulk, state_count, symbol_count);
+    start = nowSeconds();
+    confStates(&bulk, types, NULL, thread_counts[r], &bad_state);
+    addTransitions(&bulk, from, symbols, to, edge_count, thread_counts[r], &bad_edge);
+    elapsed = nowSeconds() - start;
+    char label[64];
+    if (thread_counts[r] == 0)
+      snprintf(label, sizeof(label), "confStates + addTransitions, every CPU");
+    else
+      snprintf(label, sizeof(label), "confStates + addTransitions, %u thread%s", thread_counts[r], (thread_counts[r] == 1) ? "" : "s");
+    printf("  %-44s %8.3f s\n", label, elapsed);
+
+    for (size_t i = 0; i < (size_t)state_count * symbol_count; i++) {
+      unsigned int serial_id = (serial.D[i] == NULL) ? TABLE_NO_STATE : serial.D[i]->id;
+      unsigned int bulk_id = (bulk.D[i] == NULL) ? TABLE_NO_STATE : bulk.D[i]->id;
+      if (serial_id != bulk_id)
+        same = 0;
+    }
+    freeFSM(&bulk);
+  }
+  printf("  tables %s\n", same ? "agree" : "DISAGREE");
+
+  freeFSM(&serial);
+  free(types);
+  free(from);
+  free(symbols);
+  free(to);
+}
+
+/*
+Bench Pages
+Actions:
+  • builds a machine with a transition table far larger than the TLB covers, on each kind of page
+  • runs random input through it, so nearly every lookup is to a different page
+*/
+static void benchPages(void) {
+  const unsigned int state_count = 1u << 20;
+  const unsigned int symbol_count = 64;
+  const unsigned int length = 1u << 22;
+  const TABLE_PAGES requested[] = {PAGES_SMALL, PAGES_TRANSPARENT, PAGES_HUGE};
+  const char *names[] = {"small", "thp", "hugetlb"};
+
+  unsigned long long seed = 0xD1B54A32D192ED03ULL;
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++)
+    input[i] = nextRandom(&seed) % symbol_count;
+
+  printf("  %u states, %u symbols, %.0f MiB table\n", state_count, symbol_count,
+         (double)state_count * symbol_count * sizeof(State*) / 1048576.0);
+  for (unsigned int r = 0; r < 3; r++) {
+    FSM machine;
+    if (initFSMPages(&machine, state_count, symbol_count, requested[r]) != FSM_OK) {
+      printf("  %s pages: allocation failed\n", names[r]);
+      continue;
+    }
+
+    seed = 0x9E3779B97F4A7C15ULL;
+    confState(&machine, 0, START_STATE, NULL);
+    for (unsigned int state = 0; state < state_count; state++)
+      for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+        addTrans(&machine, state, nextRandom(&seed) % state_count, symbol);
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s pages, got %s", names[r], names[machine.Dpages - PAGES_SMALL]);
+    reportRate(label, length, timeInterpreter(&machine, input, length));
+    freeFSM(&machine);
+  }
+
+  free(input);
+}
+
+/*
+Bench Replica
+Actions:
+  • replicates a machine with a table far larger than the caches onto each NUMA node
+  • binds to the first node and runs random input on its local replica and on the last node's replica
+  • on a single node system, simulates two nodes, where both replicas are local and should match
+  • checks every replica's transitions lead to its own copy of the states
+*/
+static void benchReplica(void) {
+  const unsigned int state_count = 1u << 18;
+  const unsigned int symbol_count = 64;
+  const unsigned int length = 1u << 22;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  FSM machine;
+  ReplicaSet set;
+
+  initFSM(&machine, state_count, symbol_count);
+  confState(&machine, 0, START_STATE, NULL);
+  for (unsigned int state = 0; state < state_count; state++)
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+      addTrans(&machine, state, nextRandom(&seed) % state_count, symbol);
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++)
+    input[i] = nextRandom(&seed) % symbol_count;
+
+  initReplicas(&set, &machine, 0);
+  if (set.node_count < 2) {
+    freeReplicas(&set);
+    initReplicas(&set, &machine, 2);
+    printf("  single node, simulating 2 nodes: both replicas are local\n");
+  }
+  else
+    printf("  %u nodes, replicas %s\n", set.node_count, set.placed ? "bound to their nodes" : "NOT bound");
+
+  bindThreadToNode(&set, 0);
+  Interpreter interp;
+  initLocalInterpreter(&interp, &set);
+  printf("  local interpreter uses replica %u\n", (unsigned int)(interp.fsm - set.replicas));
+
+  // every transition of every replica leads to its own states
+  unsigned int remote = 0;
+  for (unsigned int node = 0; node < set.node_count; node++) {
+    FSM *replica = &set.replicas[node];
+    for (size_t i = 0; i < (size_t)state_count * symbol_count; i++)
+      if (replica->D[i]->id != machine.D[i]->id || replica->D[i] - replica->Q >= state_count ||
+          replica->D[i] < replica->Q)
+        remote++;
+  }
+  printf("  replica transitions off their own states: %u\n", remote);
+
+  reportRate("source machine", length, timeInterpreter(&machine, input, length));
+  reportRate("local replica", length, timeInterpreter(&set.replicas[0], input, length));
+  reportRate("remote replica", length, timeInterpreter(&set.replicas[set.node_count - 1], input, length));
+
+  freeReplicas(&set);
+  freeFSM(&machine);
+  free(input);
+}
+
+/*
+Bench Packed
+Actions:
+  • builds machines whose state IDs need 10 and 13 bits
+  • walks random input through the state table, a table of 16-bit fields, and the packed table with
+      shifts and masks and with BMI2
+*/
+static void benchPacked(void) {
+  const unsigned int state_counts[] = {600, 5000};
+  const unsigned int symbol_count = 64;
+  const unsigned int length = 1u << 24;
+
+  unsigned int *input = buildChainInput(length, symbol_count, 0, 0xD1B54A32D192ED03ULL);
+  for (unsigned int m = 0; m < 2; m++) {
+    FSM machine;
+    StateTable table;
+    PackedTable packed;
+
+    buildChainMachine(&machine, state_counts[m], symbol_count, 0x9E3779B97F4A7C15ULL);
+    initStateTable(&table, &machine);
+    initPackedTable(&packed, &machine);
+
+    // byte aligned fields, the narrowest whole byte width for these machines
+    size_t cells = (size_t)state_counts[m] * symbol_count;
+    unsigned short *narrow = malloc(cells * sizeof(unsigned short));
+    for (size_t i = 0; i < cells; i++)
+      narrow[i] = (unsigned short)table.next[i];
+
+    printf("  %u states, %u symbols: 32-bit %.0f KiB, 16-bit %.0f KiB, packed %u-bit %.0f KiB\n",
+           state_counts[m], symbol_count, cells * 4 / 1024.0, cells * 2 / 1024.0, packed.bits,
+           packed.word_count * 8 / 1024.0);
+
+    double start = nowSeconds();
+    unsigned int expected = recognizeInput(&table, input, length);
+    reportRate("recognizeInput, 32-bit", length, nowSeconds() - start);
+
+    unsigned int state = table.start;
+    start = nowSeconds();
+    for (unsigned int i = 0; i < length; i++)
+      state = narrow[(size_t)state * symbol_count + input[i]];
+    reportRate("16-bit fields", length, nowSeconds() - start);
+    int agree = (isAccepting(&table, state) == (expected == INTERP_ACCEPT));
+
+    state = packed.start;
+    start = nowSeconds();
+    for (unsigned int i = 0; i < length; i++)
+      state = packedNext(&packed, state, input[i]);
+    reportRate("packedNext, shifts and masks", length, nowSeconds() - start);
+    agree &= (isAccepting(&table, state) == (expected == INTERP_ACCEPT));
+
+    start = nowSeconds();
+    agree &= (recognizePacked(&packed, input, length) == expected);
+    reportRate(cpuHasBMI2() ? "recognizePacked, BMI2" : "recognizePacked", length, nowSeconds() - start);
+    printf("  results %s\n", agree ? "agree" : "DISAGREE");
+
+    free(narrow);
+    freePackedTable(&packed);
+    freeStateTable(&table);
+    freeFSM(&machine);
+  }
+
+  free(input);
+}
+
+/*
+Bench Unicode
+Actions:
+  • builds a class map of letters, digits, space, Greek, CJK and emoji, and a machine over the classes
+  • generates mostly ASCII and mostly CJK UTF-8 text
+  • runs each with runUTF8(), and by decoding it to an array of classes first for runInterpreter()
+*/
+static void benchUnicode(void) {
+  const unsigned int class_count = 7;
+  const unsigned int state_count = 4;
+  const size_t length = 1u << 24;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  ClassMap map;
+  FSM machine;
+
+  initClassMap(&map, class_count);
+  setClassRange(&map, 'a', 'z', 1);
+  setClassRange(&map, 'A', 'Z', 1);
+  setClassRange(&map, '0', '9', 2);
+  setClassRange(&map, ' ', ' ', 3);
+  setClassRange(&map, 0x0370, 0x03FF, 4);
+  setClassRange(&map, 0x4E00, 0x9FFF, 5);
+  setClassRange(&map, 0x1F300, 0x1FAFF, 6);
+  double start = nowSeconds();
+  freezeClassMap(&map);
+  printf("  class map frozen in %.3f s, %u distinct pages, %.1f KiB\n", nowSeconds() - start, map.page_count,
+         (CLASS_PAGE_COUNT * 2 + map.page_count * 512.0) / 1024.0);
+
+  initFSM(&machine, state_count, class_count);
+  confState(&machine, 0, START_STATE, NULL);
+  confState(&machine, 1, ACCEPT_STATE, countAction);
+  for (unsigned int state = 0; state < state_count; state++)
+    for (unsigned int symbol_class = 0; symbol_class < class_count; symbol_class++)
+      addTrans(&machine, state, (state + symbol_class) % state_count, symbol_class);
+
+  unsigned char *text = malloc(length + 4);
+  unsigned int *classes = malloc(length * sizeof(unsigned int));
+  for (unsigned int kind = 0; kind < 2; kind++) {
+    // mostly ASCII words, or mostly CJK with some Greek and emoji
+    size_t size = 0;
+    while (size < length) {
+      unsigned int pick = nextRandom(&seed) % 100;
+      unsigned int code_point;
+      if (kind == 0)
+        code_point = (pick < 85) ? 'a' + pick % 26 : ((pick < 95) ? ' ' : 0x4E00 + pick);
+      else
+        code_point = (pick < 80) ? 0x4E00 + (unsigned int)(nextRandom(&seed) % 0x5200) :
+                     ((pick < 90) ? 0x03B1 + pick % 20 : ((pick < 95) ? 0x1F600 + pick : ' '));
+
+      if (code_point < 0x80)
+        text[size++] = (unsigned char)code_point;
+      else if (code_point < 0x800) {
+        text[size++] = (unsigned char)(0xC0 | (code_point >> 6));
+        text[size++] = (unsigned char)(0x80 | (code_point & 0x3F));
+      }
+      else if (code_point < 0x10000) {
+        text[size++] = (unsigned char)(0xE0 | (code_point >> 12));
+        text[size++] = (unsigned char)(0x80 | ((code_point >> 6) & 0x3F));
+        text[size++] = (unsigned char)(0x80 | (code_point & 0x3F));
+      }
+      else {
+        text[size++] = (unsigned char)(0xF0 | (code_point >> 18));
+        text[size++] = (unsigned char)(0x80 | ((code_point >> 12) & 0x3F));
+        text[size++] = (unsigned char)(0x80 | ((code_point >> 6) & 0x3F));
+        text[size++] = (unsigned char)(0x80 | (code_point & 0x3F));
+      }
+    }
+    printf("  %s text, %.0f MiB\n", (kind == 0) ? "mostly ASCII" : "mostly CJK", size / 1048576.0);
+
+    Interpreter interp;
+    size_t error_offset;
+    initInterpreter(&interp, &machine);
+    start = nowSeconds();
+    INTERP_STATUS direct_status = runUTF8(&interp, &map, text, size, &error_offset);
+    double elapsed = nowSeconds() - start;
+    size_t code_points = interp.position;
+    reportRate("runUTF8, per code point", code_points, elapsed);
+
+    // decode to an array first, with the same class map
+    start = nowSeconds();
+    unsigned int count = 0;
+    for (size_t i = 0; i < size; ) {
+      unsigned int lead = text[i], code_point;
+      if (lead < 0x80)
+        code_point = text[i++];
+      else if (lead < 0xE0) {
+        code_point = ((lead & 0x1F) << 6) | (text[i + 1] & 0x3F);
+        i += 2;
+      }
+      else if (lead < 0xF0) {
+        code_point = ((lead & 0x0F) << 12) | ((text[i + 1] & 0x3F) << 6) | (text[i + 2] & 0x3F);
+        i += 3;
+      }
+      else {
+        code_point = ((lead & 0x07) << 18) | ((text[i + 1] & 0x3F) << 12) | ((text[i + 2] & 0x3F) << 6) |
+                     (text[i + 3] & 0x3F);
+        i += 4;
+      }
+      classes[count++] = classOf(&map, code_point);
+    }
+    initInterpreter(&interp, &machine);
+    INTERP_STATUS array_status = runInterpreter(&interp, classes, count);
+    reportRate("decode to array + runInterpreter", count, nowSeconds() - start);
+    printf("  results %s\n", (direct_status == array_status && count == code_points) ? "agree" : "DISAGREE");
+  }
+
+  freeClassMap(&map);
+  freeFSM(&machine);
+  free(text);
+  free(classes);
+}
+
+/*
+Bench Scheduler
+Actions:
+  • gives thousands of instances a backlog each, where 1% of the instances hold half of the symbols
+  • runs them on 1 to 64 worker threads
+  • checks every instance ends in the state a plain run of its backlog ends in
+  • checks a scheduler rejects instances past its max_instances
+*/
+static void benchScheduler(void) {
+  const unsigned int instance_count = 4096;
+  const unsigned int heavy_count = instance_count / 100;
+  const unsigned int length = 1u << 23;
+  const unsigned int symbol_count = 8;
+  FSM machine;
+  StateTable table;
+
+  buildChainMachine(&machine, 1024, symbol_count, 0x9E3779B97F4A7C15ULL);
+  initStateTable(&table, &machine);
+  unsigned int *input = buildChainInput(length, symbol_count, 50, 0xD1B54A32D192ED03ULL);
+
+  // backlog of each instance, a slice of the input
+  unsigned int *offset = malloc((instance_count + 1) * sizeof(unsigned int));
+  unsigned int *expected = malloc(instance_count * sizeof(unsigned int));
+  unsigned int heavy_share = length / 2 / heavy_count;
+  unsigned int light_share = (length - heavy_share * heavy_count) / (instance_count - heavy_count);
+  offset[0] = 0;
+  for (unsigned int i = 0; i < instance_count; i++)
+    offset[i + 1] = offset[i] + ((i < heavy_count) ? heavy_share : light_share);
+  for (unsigned int i = 0; i < instance_count; i++) {
+    unsigned int state = table.start;
+    for (unsigned int j = offset[i]; j < offset[i + 1]; j++)
+      state = table.next[(size_t)state * symbol_count + input[j]];
+    expected[i] = state;
+  }
+  printf("  %u instances, %u symbols, %u instances hold half\n", instance_count, offset[instance_count],
+         heavy_count);
+
+  Instance *instances = malloc(instance_count * sizeof(Instance));
+  for (unsigned int threads = 1; threads <= SCHEDULER_MAX_THREADS; threads *= 2) {
+    Scheduler scheduler;
+    initScheduler(&scheduler, threads, 256, instance_count);
+    for (unsigned int i = 0; i < instance_count; i++) {
+      initInstance(&instances[i], &machine);
+      postSymbols(&scheduler, &instances[i], &input[offset[i]], offset[i + 1] - offset[i]);
+    }
+
+    double start = nowSeconds();
+    runScheduler(&scheduler);
+    double elapsed = nowSeconds() - start;
+
+    unsigned long long steals = 0;
+    for (unsigned int t = 0; t < threads; t++)
+      steals += scheduler.workers[t].steals;
+    unsigned int wrong = 0;
+    for (unsigned int i = 0; i < instance_count; i++) {
+      if (instances[i].interp.current_state->id != expected[i])
+        wrong++;
+      freeInstance(&instances[i]);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%2u threads, %llu steals%s", threads, steals, wrong ? ", WRONG" : "");
+    reportRate(label, offset[instance_count], elapsed);
+    freeScheduler(&scheduler);
+  }
+
+  // a scheduler full of runnable instances rejects another, and takes it once one has run
+  Scheduler small;
+  initScheduler(&small, 1, 256, 2);
+  for (unsigned int i = 0; i < 3; i++)
+    initInstance(&instances[i], &machine);
+  postSymbols(&small, &instances[0], input, 16);
+  postSymbols(&small, &instances[1], input, 16);
+  INTERP_STATUS over = postSymbols(&small, &instances[2], input, 16);
+  runScheduler(&small);
+  INTERP_STATUS after = postSymbols(&small, &instances[2], input, 16);
+  printf("  max_instances 2, third post %s, after a run %s\n",
+         (over == INTERP_ALLOC_ERR) ? "rejected" : "NOT REJECTED",
+         (after == INTERP_OK) ? "taken" : "NOT TAKEN");
+  runScheduler(&small);
+  for (unsigned int i = 0; i < 3; i++)
+    freeInstance(&instances[i]);
+  freeScheduler(&small);
+
+  free(instances);
+  free(offset);
+  free(expected);
+  free(input);
+  freeStateTable(&table);
+  freeFSM(&machine);
+}
+/*
+Bench Timer
+Actions:
+  • arms millions of timers spread over a million ticks, cancels half, and expires the rest, checking
+    each expires on its tick
+  • runs a million timed interpreters whose waiting state times out after 500 ticks of no events, and
+    checks the timeouts taken against a count of the gaps between events
+*/
+static void benchTimer(void) {
+  const unsigned int timer_count = 1u << 22;
+  const unsigned int span = 1u << 20;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+  // raw wheel
+  TimerWheel *wheel = malloc(sizeof(TimerWheel));
+  Timer *timers = malloc(timer_count * sizeof(Timer));
+  unsigned long long *due = malloc(timer_count * sizeof(unsigned long long));
+  initWheel(wheel, 0);
+  bench_wheel = wheel;
+  late_timers = 0;
+  for (unsigned int i = 0; i < timer_count; i++) {
+    initTimer(&timers[i], expireBenchTimer);
+    due[i] = 1 + nextRandom(&seed) % span;
+  }
+  printf("  %u timers over %u ticks\n", timer_count, span);
+
+  double start = nowSeconds();
+  for (unsigned int i = 0; i < timer_count; i++)
+    armTimer(wheel, &timers[i], due[i]);
+  reportRate("arm", timer_count, nowSeconds() - start);
+
+  start = nowSeconds();
+  for (unsigned int i = 0; i < timer_count; i += 2)
+    cancelTimer(wheel, &timers[i]);
+  reportRate("cancel", timer_count / 2, nowSeconds() - start);
+
+  start = nowSeconds();
+  unsigned long long expired = advanceWheel(wheel, span);
+  double elapsed = nowSeconds() - start;
+  char label[64];
+  snprintf(label, sizeof(label), "expire, %llu late%s", late_timers,
+           (expired == timer_count / 2 && wheel->armed == 0) ? "" : ", WRONG");
+  reportRate(label, expired, elapsed);
+
+  for (unsigned int i = 1; i < timer_count; i += 2)
+    if (timers[i].expires != due[i] - 1)
+      late_timers++;
+  free(timers);
+  free(due);
+
+  // timed interpreters, event moves idle (0) to waiting (1), waiting times out back to idle
+  const unsigned int instance_count = 1u << 20;
+  const unsigned int tick_count = 4096;
+  const unsigned int events_per_tick = 1024;
+  const unsigned int timeout = 500;
+  FSM machine;
+  Timeouts timeouts;
+  initFSM(&machine, 2, 2);
+  confState(&machine, 0, START_STATE, countAction);
+  addTrans(&machine, 0, 1, 0);
+  addTrans(&machine, 1, 1, 0);
+  addTrans(&machine, 1, 0, 1);
+  initTimeouts(&timeouts, &machine);
+  setTimeout(&timeouts, 1, timeout, 1);
+
+  TimedInterpreter *instances = malloc(instance_count * sizeof(TimedInterpreter));
+  unsigned long long *last_event = malloc(instance_count * sizeof(unsigned long long));
+  initWheel(wheel, 0);
+  for (unsigned int i = 0; i < instance_count; i++) {
+    initTimedInterpreter(&instances[i], &machine, &timeouts, wheel);
+    last_event[i] = 0;
+  }
+
+  // an event at tick t arms an expiry on tick t + timeout - 1, so a gap of timeout ticks times out
+  unsigned long long expected = 0;
+  action_calls = 0;
+  start = nowSeconds();
+  for (unsigned int t = 1; t <= tick_count; t++) {
+    for (unsigned int e = 0; e < events_per_tick; e++) {
+      unsigned int i = nextRandom(&seed) % instance_count;
+      if (last_event[i] != 0 && t - last_event[i] >= timeout)
+        expected++;
+      last_event[i] = t;
+      timedTransition(&instances[i], 0);
+    }
+    advanceWheel(wheel, 1);
+  }
+  elapsed = nowSeconds() - start;
+  for (unsigned int i = 0; i < instance_count; i++)
+    if (last_event[i] != 0 && tick_count + 1 - last_event[i] >= timeout)
+      expected++;
+
+  snprintf(label, sizeof(label), "timed, %llu timeouts%s", action_calls,
+           (action_calls == expected && late_timers == 0) ? "" : ", WRONG");
+  reportRate(label, (unsigned long long)tick_count * events_per_tick + action_calls, elapsed);
+
+  for (unsigned int i = 0; i < instance_count; i++)
+    stopTimedInterpreter(&instances[i]);
+  free(instances);
+  free(last_event);
+  freeTimeouts(&timeouts);
+  freeFSM(&machine);
+  free(wheel);
+  bench_wheel = NULL;
+}
+
+
+/*
+Expire Bench Timer
+Actions:
+  • counts timers expiring on a tick other than the one they were armed for
+*/
+static void expireBenchTimer(Timer *timer) {
+  if (timer->expires != bench_wheel->now - 1)
+    late_timers++;
+}
+
+
+/*
+Bench Chart
+Actions:
+  • builds a chart 4 levels deep with 8 children per parent, where every node has an entry and exit
+    action and random transitions, and the top node has a transition on every symbol
+  • runs random input through the flattened chart, and through a walk of the hierarchy per symbol
+  • checks both end in the same state having run the same number of actions
+*/
+static void benchChart(void) {
+  const unsigned int fanout = 8;
+  const unsigned int levels = 4;
+  const unsigned int symbol_count = 8;
+  const unsigned int length = 1u << 22;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+  // nodes numbered level by level, node 0 holds everything
+  unsigned int node_count = 1, level_size = 1;
+  for (unsigned int l = 0; l < levels; l++) {
+    level_size *= fanout;
+    node_count += level_size;
+  }
+  Chart chart;
+  initChart(&chart, node_count, symbol_count);
+  for (unsigned int n = 1; n < node_count; n++) {
+    unsigned int parent = (n - 1) / fanout;
+    confNode(&chart, n, parent, NORMAL_STATE, countAction, countAction);
+    if ((n - 1) % fanout == 0)
+      setInitial(&chart, parent, n);
+  }
+  confNode(&chart, 0, CHART_NO_NODE, START_STATE, countAction, countAction);
+  for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+    addChartTrans(&chart, 0, nextRandom(&seed) % node_count, symbol);
+  for (unsigned int n = 1; n < node_count; n++)
+    if (nextRandom(&seed) % 2)
+      addChartTrans(&chart, n, nextRandom(&seed) % node_count, nextRandom(&seed) % symbol_count);
+
+  double start = nowSeconds();
+  FlatChart flat;
+  FSM_STATUS status = flattenChart(&chart, &flat);
+  double elapsed = nowSeconds() - start;
+  printf("  %u nodes, %u leaves, %zu actions in sequences, flattened in %.1f ms%s\n", node_count,
+         flat.fsm.Qc, flat.first[(size_t)flat.fsm.Qc * symbol_count + 1], elapsed * 1e3,
+         status == FSM_OK ? "" : ", FAILED");
+
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++)
+    input[i] = nextRandom(&seed) % symbol_count;
+
+  // flat
+  Interpreter interp;
+  action_calls = 0;
+  initChartInterpreter(&interp, &flat);
+  start = nowSeconds();
+  runChart(&interp, &flat, input, length);
+  elapsed = nowSeconds() - start;
+  unsigned long long flat_actions = action_calls;
+  unsigned int flat_node = flat.state_node[interp.current_state->id];
+  reportRate("flattened table", length, elapsed);
+
+  // hierarchy walk, starting from the same entry actions
+  unsigned long long walk_actions = flat.first[(size_t)flat.fsm.Qc * symbol_count + 1] -
+                                    flat.first[(size_t)flat.fsm.Qc * symbol_count];
+  unsigned int leaf = flat.state_node[flat.fsm.Qs->id];
+  start = nowSeconds();
+  for (unsigned int i = 0; i < length; i++)
+    leaf = walkChart(&chart, leaf, input[i], &walk_actions);
+  elapsed = nowSeconds() - start;
+
+  char label[64];
+  snprintf(label, sizeof(label), "hierarchy walk%s",
+           (leaf == flat_node && walk_actions == flat_actions) ? "" : ", WRONG");
+  reportRate(label, length, elapsed);
+
+  free(input);
+  freeFlatChart(&flat);
+  freeChart(&chart);
+}
+
+
+/*
+Walk Chart
+Actions:
+  • finds the innermost node containing the leaf with a transition on the symbol
+  • enters initial children down from the target to a leaf
+  • counts the exits and entries up to and down from the nearest node containing both source and
+    target, moving out one level if that is the source or target itself
+*/
+static unsigned int walkChart(const Chart *chart, unsigned int leaf, unsigned int symbol,
+                              unsigned long long *actions) {
+  unsigned int source = leaf;
+  while (chart->trans[(size_t)source * chart->symbol_count + symbol] == CHART_NO_NODE)
+    source = chart->parent[source];
+  unsigned int target = chart->trans[(size_t)source * chart->symbol_count + symbol];
+  unsigned int next = target;
+  while (chart->initial[next] != CHART_NO_NODE)
+    next = chart->initial[next];
+
+  unsigned int domain = source;
+  for (;;) {
+    unsigned int n = target;
+    while (n != CHART_NO_NODE && n != domain)
+      n = chart->parent[n];
+    if (n == domain && domain != source && domain != target)
+      break;
+    if (domain == CHART_NO_NODE)
+      break;
+    domain = chart->parent[domain];
+  }
+
+  for (unsigned int n = leaf; n != domain; n = chart->parent[n])
+    (*actions)++;
+  for (unsigned int n = next; n != domain; n = chart->parent[n])
+    (*actions)++;
+  return next;
+}
+
+
+/*
+Bench Trace
+Actions:
+  • steps four interleaved instances through a machine, with and without recording each transition
+  • records the same transitions with nothing else in the loop, to time the encoder alone
+  • replays a ring too small for the whole run, which keeps only the latest transitions
+  • replays a trace of the whole run, checking every transition is reproduced
+*/
+static void benchTrace(void) {
+  const unsigned int instance_count = 4;
+  const unsigned int length = 1u << 23;
+  const unsigned int symbol_count = 8;
+  FSM machine;
+
+  buildChainMachine(&machine, 1024, symbol_count, 0x9E3779B97F4A7C15ULL);
+  unsigned int *input = buildChainInput(length, symbol_count, 50, 0xD1B54A32D192ED03ULL);
+  State **table = machine.D;
+  size_t ec = machine.Ec;
+
+  // untraced
+  unsigned int state[4] = {0, 0, 0, 0};
+  double best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    double start = nowSeconds();
+    for (unsigned int i = 0; i < length; i++) {
+      unsigned int instance = i % instance_count;
+      state[instance] = table[state[instance] * ec + input[i]]->id;
+    }
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+  action_calls += state[0] + state[1] + state[2] + state[3];
+  reportRate("untraced", length, best);
+
+  // traced into a ring already written once, as a long running log would be
+  TraceLog log;
+  double traced = 1e30;
+  initTraceLog(&log, 4u << 20, NULL);
+  for (unsigned int r = 0; r <= BENCH_REPEATS; r++) {
+    for (unsigned int k = 0; k < instance_count; k++)
+      state[k] = 0;
+    double start = nowSeconds();
+    for (unsigned int i = 0; i < length; i++) {
+      unsigned int instance = i % instance_count;
+      state[instance] = table[state[instance] * ec + input[i]]->id;
+      traceRecord(&log, instance, input[i], state[instance]);
+    }
+    double elapsed = nowSeconds() - start;
+    if (r > 0 && elapsed < traced)
+      traced = elapsed;
+  }
+  char label[64];
+  snprintf(label, sizeof(label), "traced, %.2f bytes/record",
+           (double)((log.block->sequence - 1) * TRACE_BLOCK_SIZE) / (double)log.records);
+  reportRate(label, length, traced);
+  printf("  %-32s %8.3f ns/symbol\n", "added by recording", (traced - best) * 1e9 / length);
+
+  // the encoder alone, on the same records worked out beforehand
+  unsigned int *states = malloc(length * sizeof(unsigned int));
+  for (unsigned int k = 0; k < instance_count; k++)
+    state[k] = 0;
+  for (unsigned int i = 0; i < length; i++) {
+    unsigned int instance = i % instance_count;
+    state[instance] = table[state[instance] * ec + input[i]]->id;
+    states[i] = state[instance];
+  }
+  double encoded = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    double start = nowSeconds();
+    for (unsigned int i = 0; i < length; i++)
+      traceRecord(&log, i % instance_count, input[i], states[i]);
+    double elapsed = nowSeconds() - start;
+    if (elapsed < encoded)
+      encoded = elapsed;
+  }
+  free(states);
+  reportRate("traceRecord alone", length, encoded);
+
+  // the ring keeps the latest transitions, all of the last run
+  TraceReader reader;
+  unsigned long long replayed = 0;
+  openTrace(&reader, log.data, traceBytes(&log));
+  INTERP_STATUS status = replayTrace(&reader, &machine, instance_count, 0, &replayed);
+  printf("  4 MiB ring kept the last %llu transitions%s\n", replayed, status == INTERP_OK ? "" : ", WRONG");
+  freeTraceLog(&log);
+
+  // replay a log holding the whole run
+  initTraceLog(&log, (size_t)length * TRACE_RECORD_MAX / 2, NULL);
+  for (unsigned int k = 0; k < instance_count; k++)
+    state[k] = 0;
+  for (unsigned int i = 0; i < length; i++) {
+    unsigned int instance = i % instance_count;
+    state[instance] = table[state[instance] * ec + input[i]]->id;
+    traceRecord(&log, instance, input[i], state[instance]);
+  }
+  openTrace(&reader, log.data, traceBytes(&log));
+  double start = nowSeconds();
+  status = replayTrace(&reader, &machine, instance_count, 0, &replayed);
+  double elapsed = nowSeconds() - start;
+  snprintf(label, sizeof(label), "replay%s", (status == INTERP_OK && replayed == length) ? "" : ", WRONG");
+  reportRate(label, replayed, elapsed);
+  freeTraceLog(&log);
+
+  free(input);
+  freeFSM(&machine);
+}
+
+
+/*
+Bench Munch
+Actions:
+  • tokenizes random input with a machine where some transitions are missing and a quarter of the
+    states accept, taking the longest accepted prefix each time and skipping a symbol when none is
+  • compares rewinding to the last accepting position, one token per call and many, with running each
+    token again from the start
+*/
+static void benchMunch(void) {
+  const unsigned int state_count = 64;
+  const unsigned int symbol_count = 8;
+  const unsigned int length = 1u << 23;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  FSM machine;
+
+  initFSM(&machine, state_count, symbol_count);
+  confState(&machine, 0, START_STATE, NULL);
+  for (unsigned int state = 1; state < state_count; state++)
+    confState(&machine, state, (state % 4 == 0) ? ACCEPT_STATE : NORMAL_STATE, NULL);
+  for (unsigned int state = 0; state < state_count; state++)
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+      if (nextRandom(&seed) % 100 < 85)
+        addTrans(&machine, state, 1 + nextRandom(&seed) % (state_count - 1), symbol);
+
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++)
+    input[i] = nextRandom(&seed) % symbol_count;
+
+  // rewind with a checkpoint
+  Interpreter interp;
+  unsigned long long tokens = 0, matched = 0, steps = 0;
+  double best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    tokens = 0;
+    matched = 0;
+    double start = nowSeconds();
+    for (size_t i = 0; i < length;) {
+      size_t match_length;
+      initInterpreter(&interp, &machine);
+      if (longestMatch(&interp, &input[i], length - i, &match_length) == INTERP_ACCEPT && match_length > 0) {
+        tokens++;
+        matched += match_length;
+        i += match_length;
+      } else {
+        i++;
+      }
+    }
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+  printf("  %llu tokens, %.1f symbols per token\n", tokens, (double)matched / (double)tokens);
+  reportRate("longestMatch per token", length, best);
+
+  // many tokens per call
+  size_t ends[4096];
+  unsigned int ids[4096];
+  unsigned long long batch_tokens = 0, batch_matched = 0;
+  best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    batch_tokens = 0;
+    batch_matched = 0;
+    double start = nowSeconds();
+    for (size_t i = 0; i < length;) {
+      size_t count, consumed;
+      INTERP_STATUS status = munchTokens(&machine, &input[i], length - i, ends, ids, 4096, &count, &consumed);
+      batch_tokens += count;
+      batch_matched += consumed;
+      i += consumed + (status == INTERP_NO_ACCEPT);
+    }
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+  char label[64];
+  snprintf(label, sizeof(label), "munchTokens%s", (batch_tokens == tokens && batch_matched == matched) ? "" : ", WRONG");
+  reportRate(label, length, best);
+
+  // run forward to find the length, then again from the start to get the state
+  unsigned long long rerun_tokens = 0, rerun_matched = 0;
+  State **table = machine.D;
+  size_t ec = machine.Ec;
+  best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    rerun_tokens = 0;
+    rerun_matched = 0;
+    steps = 0;
+    double start = nowSeconds();
+    for (size_t i = 0; i < length;) {
+      State *state = machine.Qs;
+      size_t accept_length = 0;
+      for (size_t j = i; j < length; j++) {
+        state = table[state->id * ec + input[j]];
+        if (state == NULL)
+          break;
+        if (state->type == ACCEPT_STATE)
+          accept_length = j + 1 - i;
+      }
+      if (accept_length == 0) {
+        i++;
+        continue;
+      }
+      state = machine.Qs;
+      for (size_t j = i; j < i + accept_length; j++)
+        state = table[state->id * ec + input[j]];
+      action_calls += state->id;
+      rerun_tokens++;
+      rerun_matched += accept_length;
+      steps += accept_length;
+      i += accept_length;
+    }
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+
+  snprintf(label, sizeof(label), "re-run from start%s",
+           (rerun_tokens == tokens && rerun_matched == matched) ? "" : ", WRONG");
+  reportRate(label, length, best);
+  printf("  re-running steps %llu symbols again, %.0f%% of the input\n", steps, 100.0 * steps / length);
+
+  free(input);
+  freeFSM(&machine);
+}
+
+
+/*
+Bench Incremental
+Actions:
+  • runs a lexer like machine, where a separator symbol returns to the start state, over a large input
+  • makes thousands of small random edits, bringing an incremental run up to date after each
+  • compares the time per edit with running the whole input again, checking the result every so often
+*/
+static void benchIncremental(void) {
+  const unsigned int state_count = 256;
+  const unsigned int symbol_count = 16;
+  const unsigned int length = 1u << 24;
+  const unsigned int edit_count = 10000;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  FSM machine;
+
+  initFSM(&machine, state_count, symbol_count);
+  confState(&machine, 0, START_STATE, NULL);
+  for (unsigned int state = 1; state < state_count; state++)
+    confState(&machine, state, (state % 4 == 0) ? ACCEPT_STATE : NORMAL_STATE, NULL);
+  for (unsigned int state = 0; state < state_count; state++) {
+    addTrans(&machine, state, 0, 0);
+    for (unsigned int symbol = 1; symbol < symbol_count; symbol++)
+      addTrans(&machine, state, nextRandom(&seed) % state_count, symbol);
+  }
+
+  // one symbol in ten is the separator
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int i = 0; i < length; i++)
+    input[i] = (nextRandom(&seed) % 10 == 0) ? 0 : 1 + nextRandom(&seed) % (symbol_count - 1);
+
+  double start = nowSeconds();
+  IncrementalRun run;
+  initIncremental(&run, &machine, 256, input, length);
+  double full = nowSeconds() - start;
+  printf("  %u symbols, %zu recorded states\n", length, run.count);
+  reportRate("full run, recording", length, full);
+
+  unsigned long long stepped = 0;
+  unsigned int wrong = 0, checked = 0;
+  double edits = 0;
+  for (unsigned int e = 0; e < edit_count; e++) {
+    size_t size = 1 + nextRandom(&seed) % 16;
+    size_t offset = nextRandom(&seed) % (length - size);
+    for (size_t i = offset; i < offset + size; i++)
+      input[i] = (nextRandom(&seed) % 10 == 0) ? 0 : 1 + nextRandom(&seed) % (symbol_count - 1);
+
+    size_t edit_stepped;
+    start = nowSeconds();
+    editIncremental(&run, input, offset, size, size, &edit_stepped);
+    edits += nowSeconds() - start;
+    stepped += edit_stepped;
+
+    if (e % 1000 == 0) {
+      IncrementalRun check;
+      initIncremental(&check, &machine, 256, input, length);
+      wrong += (check.final_state != run.final_state);
+      checked++;
+      freeIncremental(&check);
+    }
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "edit, %.0f symbols run%s", (double)stepped / edit_count, wrong ? ", WRONG" : "");
+  printf("  %-32s %8.3f us/edit, %u results checked\n", label, edits * 1e6 / edit_count, checked);
+  printf("  %-32s %8.3f us/edit\n", "full run per edit", full * 1e6);
+
+  freeIncremental(&run);
+  free(input);
+  freeFSM(&machine);
+}
+
+
+/*
+Bench Transducer
+Actions:
+  • writes the ID of each state entered, from an action per state and from transduce()
+  • writes mixed length outputs per transition and state with transduce(), into a large and a small buffer
+  • checks the outputs against a walk of the machine
+*/
+static void benchTransducer(void) {
+  const unsigned int state_count = 64;
+  const unsigned int symbol_count = 16;
+  const unsigned int length = 1u << 24;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+  FSM machine;
+
+  buildChainMachine(&machine, state_count, symbol_count, seed);
+  unsigned int *input = buildChainInput(length, symbol_count, 50, seed + 1);
+  unsigned int *output = malloc(3 * (size_t)length * sizeof(unsigned int));
+  unsigned int *emitted = malloc(((size_t)length + 1) * sizeof(unsigned int));
+  emit_buffer = emitted;
+
+  // IDs of the states entered, by a walk
+  unsigned long long walk_sum = 0;
+  unsigned int walked = 0;
+  for (unsigned int i = 0; i < length; i++) {
+    walked = machine.D[(size_t)walked * symbol_count + input[i]]->id;
+    walk_sum += walked * (i + 1ULL);
+  }
+
+  // the ID of each state entered, through an action
+  for (unsigned int state = 0; state < state_count; state++)
+    machine.Q[state].action = emitAction;
+  double best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    Interpreter interp;
+    initInterpreter(&interp, &machine);
+    emit_interp = &interp;
+    emit_count = 0;
+    double start = nowSeconds();
+    runInterpreter(&interp, input, length);
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+  emit_interp = NULL;
+  unsigned long long sum = 0;
+  for (size_t k = 1; k < emit_count; k++)
+    sum += emitted[k] * (unsigned long long)k;
+  char label[64];
+  snprintf(label, sizeof(label), "action per state%s",
+           (emit_count == (size_t)length + 1 && sum == walk_sum) ? "" : ", WRONG");
+  reportRate(label, length, best);
+  for (unsigned int state = 0; state < state_count; state++)
+    machine.Q[state].action = NULL;
+
+  // the ID of each state entered, through the state outputs
+  Transducer transducer;
+  initTransducer(&transducer, &machine);
+  for (unsigned int state = 0; state < state_count; state++)
+    setStateOutput(&transducer, state, &state, 1);
+  size_t written = 0, consumed = 0;
+  best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    Interpreter interp;
+    initInterpreter(&interp, &machine);
+    double start = nowSeconds();
+    transduce(&interp, &transducer, input, length, output, 3 * (size_t)length, &written, &consumed);
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+  sum = 0;
+  for (size_t k = 0; k < written; k++)
+    sum += output[k] * (k + 1ULL);
+  snprintf(label, sizeof(label), "transduce, state outputs%s", (written == length && sum == walk_sum) ? "" : ", WRONG");
+  reportRate(label, length, best);
+
+  // 0 to 2 symbols per transition and 0 or 1 per state
+  for (unsigned int state = 0; state < state_count; state++) {
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+      unsigned int out[2] = {state, symbol};
+      setTransOutput(&transducer, state, symbol, out, nextRandom(&seed) % 3);
+    }
+    setStateOutput(&transducer, state, &state, nextRandom(&seed) % 2);
+  }
+  unsigned long long expected_count = 0, expected_sum = 0;
+  unsigned int current = 0;
+  for (unsigned int i = 0; i < length; i++) {
+    size_t index = (size_t)current * symbol_count + input[i];
+    unsigned int next = machine.D[index]->id;
+    for (unsigned int k = 0; k < transducer.trans[index].length; k++)
+      expected_sum += transducer.pool[transducer.trans[index].first + k] * (expected_count++ + 1);
+    for (unsigned int k = 0; k < transducer.state[next].length; k++)
+      expected_sum += transducer.pool[transducer.state[next].first + k] * (expected_count++ + 1);
+    current = next;
+  }
+  printf("  %.2f output symbols per input symbol\n", (double)expected_count / length);
+
+  const size_t capacities[2] = {3 * (size_t)length, 4096};
+  for (unsigned int c = 0; c < 2; c++) {
+    unsigned long long count = 0;
+    sum = 0;
+    best = 1e30;
+    for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+      Interpreter interp;
+      initInterpreter(&interp, &machine);
+      count = 0;
+      sum = 0;
+      double start = nowSeconds();
+      for (size_t i = 0; i < length; i += consumed) {
+        transduce(&interp, &transducer, &input[i], length - i, output, capacities[c], &written, &consumed);
+        if (c == 1)
+          for (size_t k = 0; k < written; k++)
+            sum += output[k] * (count + k + 1);
+        count += written;
+      }
+      double elapsed = nowSeconds() - start;
+      if (elapsed < best)
+        best = elapsed;
+    }
+    if (c == 0)
+      for (size_t k = 0; k < count; k++)
+        sum += output[k] * (k + 1);
+    int right = (count == expected_count && sum == expected_sum);
+    snprintf(label, sizeof(label), "transduce, mixed, %zu buffer%s", capacities[c], right ? "" : ", WRONG");
+    reportRate(label, length, best);
+  }
+
+  freeTransducer(&transducer);
+  free(emitted);
+  free(output);
+  free(input);
+  freeFSM(&machine);
+  emit_buffer = NULL;
+}
+
+
+/*
+Emit Action
+Actions:
+  • writes the ID of the state entered to the benchmark's output buffer, as an action emitting a token would
+*/
+static void emitAction(void) {
+  emit_buffer[emit_count++] = emit_interp->current_state->id;
+}
+
+
+/*
+Bench Counter
+Actions:
+  • recognizes runs of 1 to N of symbol 0, each ended by symbol 1, with a chain of N states and with one
+    counting state
+  • steps the counting machine one symbol at a time and with runCounted(), for long and short runs
+*/
+static void benchCounter(void) {
+  const unsigned int bound = 10000;
+  const unsigned int length = 1u << 24;
+  const unsigned int longest[2] = {bound, 8};
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+  // chain, state i has seen i symbols 0
+  FSM chain;
+  initFSM(&chain, bound + 1, 2);
+  confState(&chain, 0, START_STATE, NULL);
+  for (unsigned int state = 1; state <= bound; state++) {
+    confState(&chain, state, NORMAL_STATE, NULL);
+    addTrans(&chain, state, 0, 1);
+  }
+  for (unsigned int state = 0; state < bound; state++)
+    addTrans(&chain, state, state + 1, 0);
+
+  // counting state
+  FSM counted;
+  CounterTable counters;
+  initFSM(&counted, 2, 2);
+  confState(&counted, 0, START_STATE, NULL);
+  confState(&counted, 1, NORMAL_STATE, NULL);
+  addTrans(&counted, 0, 1, 0);
+  addTrans(&counted, 1, 1, 0);
+  addTrans(&counted, 1, 0, 1);
+  initCounters(&counters, &counted);
+  setCounter(&counters, 1, 1, bound);
+  setCounterOps(&counters, 0, 0, COUNT_RESET | COUNT_INCREMENT);
+  setCounterOps(&counters, 1, 0, COUNT_INCREMENT);
+  setCounterOps(&counters, 1, 1, COUNT_TEST);
+  printf("  table bytes: chain %zu, counting %zu\n",
+         (size_t)chain.Qc * chain.Ec * sizeof(State*) + chain.Qc * sizeof(State),
+         (size_t)counted.Qc * counted.Ec * (sizeof(State*) + 1) + counted.Qc * sizeof(State) +
+         counted.Qc * sizeof(unsigned int) + counters.counter_count * sizeof(CounterBounds));
+
+  unsigned int *input = malloc(length * sizeof(unsigned int));
+  for (unsigned int l = 0; l < 2; l++) {
+    // runs end in symbol 1, as many whole runs as fit
+    unsigned int end = 0;
+    for (;;) {
+      unsigned int run = 1 + nextRandom(&seed) % longest[l];
+      if (end + run + 1 > length)
+        break;
+      for (unsigned int k = 0; k < run; k++)
+        input[end++] = 0;
+      input[end++] = 1;
+    }
+    end--;
+    printf("  runs of 1 to %u, input of %u symbols\n", longest[l], end + 1);
+
+    double chain_time = timeInterpreter(&chain, input, end + 1);
+    reportRate("chain of states", end + 1, chain_time);
+
+    // one symbol at a time
+    CountingInterpreter counting;
+    INTERP_STATUS status = INTERP_OK;
+    double best = 1e30;
+    for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+      initCountingInterpreter(&counting, &counted, &counters);
+      double start = nowSeconds();
+      for (unsigned int i = 0; i <= end && status == INTERP_OK; i++)
+        status = countedTransition(&counting, input[i]);
+      double elapsed = nowSeconds() - start;
+      if (elapsed < best)
+        best = elapsed;
+      freeCountingInterpreter(&counting);
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "countedTransition%s", (status == INTERP_OK) ? "" : ", WRONG");
+    reportRate(label, end + 1, best);
+
+    // runs skipped in bulk
+    size_t consumed = 0;
+    best = 1e30;
+    for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+      initCountingInterpreter(&counting, &counted, &counters);
+      double start = nowSeconds();
+      status = runCounted(&counting, input, end + 1, &consumed);
+      double elapsed = nowSeconds() - start;
+      if (elapsed < best)
+        best = elapsed;
+      freeCountingInterpreter(&counting);
+    }
+    snprintf(label, sizeof(label), "runCounted%s", (status == INTERP_NO_ACCEPT && consumed == end + 1) ? "" : ", WRONG");
+    reportRate(label, end + 1, best);
+  }
+
+  free(input);
+  freeCounters(&counters);
+  freeFSM(&counted);
+  freeFSM(&chain);
+}
+
+
+/*
+Bench Perf
+Actions:
+  • runs random walks through chain machines from a table that fits in the first level cache to one far
+    larger than the last level cache, with counters open around each run
+  • without -c, opens counters for this benchmark alone, and says which events are not counted
+*/
+static void benchPerf(void) {
+  const unsigned int symbol_count = 16;
+  const unsigned int length = 1u << 23;
+  const unsigned int state_counts[5] = {64, 1024, 16384, 131072, 1048576};
+
+  PerfCounters local;
+  PerfCounters *saved = bench_counters;
+  if (bench_counters == NULL) {
+    initPerfCounters(&local);
+    bench_counters = &local;
+  }
+  for (int counted = 1; counted >= 0; counted--) {
+    printf("  %s:", counted ? "counted" : "not counted");
+    for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++)
+      if (perfCounterOpen(bench_counters, event) == counted)
+        printf(" %s", perfEventName(event));
+    printf("\n");
+  }
+
+  // every symbol random, so each step is a read at a random row of the table
+  unsigned int *input = buildChainInput(length, symbol_count, 0, 0x9E3779B97F4A7C15ULL);
+  for (unsigned int s = 0; s < 5; s++) {
+    FSM machine;
+    buildChainMachine(&machine, state_counts[s], symbol_count, 0x2545F4914F6CDD1DULL + s);
+    char label[64];
+    snprintf(label, sizeof(label), "%u states, %zu KiB table", state_counts[s],
+             (size_t)state_counts[s] * symbol_count * sizeof(State*) >> 10);
+    reportRate(label, length, timeInterpreter(&machine, input, length));
+    freeFSM(&machine);
+  }
+  free(input);
+
+  if (saved == NULL) {
+    freePerfCounters(&local);
+    bench_counters = NULL;
+  }
+}
+
+
+/*
+Bench Bulk
+Actions:
+  • checks each kernel against the table on a sparse machine, with states and symbols out of range and
+    missing transitions, next states and both masks
+  • steps a batch of instances of a complete machine one symbol each per round, first with a transition()
+    call per instance, then with each kernel over batches of a few sizes, checking the final states and
+    masks against the transition() loop
+*/
+static void benchBulk(void) {
+  const unsigned int instance_count = 4096;
+  const unsigned int round_count = 256;
+  const unsigned int symbol_count = 16;
+  const unsigned int batch_sizes[3] = {1, 64, 4096};
+  const BULK_KERNEL kernels[3] = {BULK_SCALAR, BULK_AVX2, BULK_AVX512};
+  const char *kernel_names[3] = {"scalar", "AVX2", "AVX-512"};
+  const size_t mask_words = (instance_count + 63) / 64;
+  unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+
+  unsigned int *states = malloc(instance_count * sizeof(unsigned int));
+  unsigned int *symbols = malloc((size_t)round_count * instance_count * sizeof(unsigned int));
+  unsigned int *expected = malloc(instance_count * sizeof(unsigned int));
+  unsigned long long *invalid_mask = malloc(mask_words * sizeof(unsigned long long));
+  unsigned long long *accept_mask = malloc(mask_words * sizeof(unsigned long long));
+
+  // masks, on a batch not a multiple of either vector width
+  FSM sparse;
+  StateTable sparse_table;
+  const unsigned int check_count = 1000;
+  buildSparseMachine(&sparse, 1024, symbol_count, 4, 0x2545F4914F6CDD1DULL);
+  initStateTable(&sparse_table, &sparse);
+  for (unsigned int i = 0; i < check_count; i++) {
+    states[i] = nextRandom(&seed) % (sparse.Qc + 8);
+    symbols[i] = nextRandom(&seed) % (symbol_count + 2);
+  }
+  for (unsigned int k = 0; k < 3; k++) {
+    if (!setBulkKernel(kernels[k]))
+      continue;
+    bulkStep(&sparse_table, states, symbols, check_count, expected, invalid_mask, accept_mask);
+    unsigned int wrong = 0;
+    for (unsigned int i = 0; i < check_count; i++) {
+      State *next = NULL;
+      if (states[i] < sparse.Qc && symbols[i] < symbol_count)
+        next = sparse.D[(size_t)states[i] * symbol_count + symbols[i]];
+      int invalid = (invalid_mask[i >> 6] >> (i & 63)) & 1;
+      int accepting = (accept_mask[i >> 6] >> (i & 63)) & 1;
+      if (expected[i] != ((next == NULL) ? states[i] : next->id) || invalid != (next == NULL) ||
+          accepting != (next != NULL && next->type == ACCEPT_STATE))
+        wrong++;
+    }
+    printf("  %-8s masks on %u instances: %u wrong\n", kernel_names[k], check_count, wrong);
+  }
+  freeStateTable(&sparse_table);
+  freeFSM(&sparse);
+
+  // complete machine, odd states accepting
+  FSM machine;
+  StateTable table;
+  buildChainMachine(&machine, 4096, symbol_count, 0xD1B54A32D192ED03ULL);
+  for (unsigned int state = 1; state < machine.Qc; state += 2)
+    confState(&machine, state, ACCEPT_STATE, NULL);
+  initStateTable(&table, &machine);
+  for (size_t i = 0; i < (size_t)round_count * instance_count; i++)
+    symbols[i] = nextRandom(&seed) % symbol_count;
+  unsigned long long steps = (unsigned long long)round_count * instance_count;
+
+  // a transition() call per instance per round
+  Interpreter *interps = malloc(instance_count * sizeof(Interpreter));
+  double best = 1e30;
+  for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+    for (unsigned int i = 0; i < instance_count; i++)
+      initInterpreter(&interps[i], &machine);
+    double start = nowSeconds();
+    for (unsigned int round = 0; round < round_count; round++) {
+      const unsigned int *row = &symbols[(size_t)round * instance_count];
+      for (unsigned int i = 0; i < instance_count; i++) {
+        State *next;
+        transition(&interps[i], row[i], &next);
+      }
+    }
+    double elapsed = nowSeconds() - start;
+    if (elapsed < best)
+      best = elapsed;
+  }
+  for (unsigned int i = 0; i < instance_count; i++)
+    expected[i] = interps[i].current_state->id;
+  free(interps);
+  reportRate("transition() per instance", steps, best);
+
+  for (unsigned int k = 0; k < 3; k++) {
+    if (!setBulkKernel(kernels[k])) {
+      printf("  %s not supported\n", kernel_names[k]);
+      continue;
+    }
+    for (unsigned int b = 0; b < 3; b++) {
+      unsigned int batch = batch_sizes[b];
+      best = 1e30;
+      for (unsigned int r = 0; r < BENCH_REPEATS; r++) {
+        for (unsigned int i = 0; i < instance_count; i++)
+          states[i] = table.start;
+        double start = nowSeconds();
+        for (unsigned int round = 0; round < round_count; round++) {
+          const unsigned int *row = &symbols[(size_t)round * instance_count];
+          for (unsigned int i = 0; i < instance_count; i += batch)
+            bulkStep(&table, &states[i], &row[i], batch, &states[i], &invalid_mask[i >> 6],
+                     &accept_mask[i >> 6]);
+        }
+        double elapsed = nowSeconds() - start;
+        if (elapsed < best)
+          best = elapsed;
+      }
+
+      // masks of the last round, batches under 64 share mask words so only the full batch is checked
+      unsigned int wrong = 0;
+      for (unsigned int i = 0; i < instance_count; i++) {
+        int accepting = (accept_mask[i >> 6] >> (i & 63)) & 1;
+        int invalid = (invalid_mask[i >> 6] >> (i & 63)) & 1;
+        if (states[i] != expected[i] || (batch % 64 == 0 && (invalid || accepting != (int)(expected[i] & 1))))
+          wrong++;
+      }
+      char label[64];
+      snprintf(label, sizeof(label), "%s, batches of %u%s", kernel_names[k], batch, wrong ? ", WRONG" : "");
+      reportRate(label, steps, best);
+    }
+  }
+  setBulkKernel(BULK_AUTO);
+
+  free(states);
+  free(symbols);
+  free(expected);
+  free(invalid_mask);
+  free(accept_mask);
+  freeStateTable(&table);
+  freeFSM(&machine);
+}
@@ -0,0 +1,167 @@
+// Author: Kevin Imlay
+
+/*
+Benchmark of the compile time machine against the table implementation. Both run the boot sequence
+machine of main.c, with actions that only count their calls, over a long valid input that cycles through
+the operating modes before shutting down.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "static_fsm.hpp"
+
+/* ----- Private Enumeration Definitions ----- */
+
+enum TRANSITION_SYMBOL : unsigned int {
+  IB_SYMB = 0, CSS_SYMB, SSS_SYMB, SSNS_SYMB, MS_SYMB, SD_SYMB, PD_SYMB, NM_SYMB, SM_SYMB, IM_SYMB
+};
+
+enum STATE_ID : unsigned int {
+  B_STATE = 0, IB_STATE, CSS_STATE, LSS_STATE, LDC_STATE, MS_STATE, SS_STATE, PD_STATE,
+  TEMP_NM_STATE, TEMP_SM_STATE, TEMP_IM_STATE
+};
+
+#define NUM_STATES 11
+#define NUM_SYMBOLS 10
+#define BENCH_REPEATS 3
+
+
+/* ----- Private Variables ----- */
+
+static unsigned long long action_calls = 0;
+
+
+/* ----- Private Function Definitions ----- */
+
+static void countAction(void) {
+  action_calls++;
+}
+
+namespace sf = static_fsm;
+
+using BootMachine = sf::Machine<NUM_STATES, NUM_SYMBOLS,
+  sf::States<sf::State<B_STATE, START_STATE, countAction>,
+             sf::State<IB_STATE, NORMAL_STATE, countAction>,
+             sf::State<CSS_STATE, NORMAL_STATE, countAction>,
+             sf::State<LSS_STATE, NORMAL_STATE, countAction>,
+             sf::State<LDC_STATE, NORMAL_STATE, countAction>,
+             sf::State<MS_STATE, NORMAL_STATE, countAction>,
+             sf::State<SS_STATE, NORMAL_STATE, countAction>,
+             sf::State<PD_STATE, ACCEPT_STATE, countAction>,
+             sf::State<TEMP_NM_STATE, NORMAL_STATE, countAction>,
+             sf::State<TEMP_SM_STATE, NORMAL_STATE, countAction>,
+             sf::State<TEMP_IM_STATE, NORMAL_STATE, countAction>>,
+  sf::Transitions<sf::Trans<B_STATE, IB_SYMB, IB_STATE>,
+                  sf::Trans<IB_STATE, CSS_SYMB, CSS_STATE>,
+                  sf::Trans<CSS_STATE, SSS_SYMB, LSS_STATE>,
+                  sf::Trans<CSS_STATE, SSNS_SYMB, LDC_STATE>,
+                  sf::Trans<LSS_STATE, MS_SYMB, MS_STATE>,
+                  sf::Trans<LDC_STATE, MS_SYMB, MS_STATE>,
+                  sf::Trans<MS_STATE, SD_SYMB, SS_STATE>,
+                  sf::Trans<MS_STATE, NM_SYMB, TEMP_NM_STATE>,
+                  sf::Trans<MS_STATE, SM_SYMB, TEMP_SM_STATE>,
+                  sf::Trans<MS_STATE, IM_SYMB, TEMP_IM_STATE>,
+                  sf::Trans<SS_STATE, PD_SYMB, PD_STATE>,
+                  sf::Trans<TEMP_NM_STATE, MS_SYMB, MS_STATE>,
+                  sf::Trans<TEMP_SM_STATE, MS_SYMB, MS_STATE>,
+                  sf::Trans<TEMP_IM_STATE, MS_SYMB, MS_STATE>>>;
+
+// checked while compiling
+static_assert(BootMachine::start == B_STATE);
+static_assert(BootMachine::next_v<MS_STATE, SD_SYMB> == SS_STATE);
+static_assert(BootMachine::next(PD_STATE, MS_SYMB) == BootMachine::no_state);
+
+
+/*
+Create State Machine
+Actions:
+  • same configuration as main.c, with counting actions
+*/
+static void createStateMachine(FSM *state_machine) {
+  const unsigned int transitions[][3] = {
+    {B_STATE, IB_STATE, IB_SYMB}, {IB_STATE, CSS_STATE, CSS_SYMB}, {CSS_STATE, LSS_STATE, SSS_SYMB},
+    {CSS_STATE, LDC_STATE, SSNS_SYMB}, {LSS_STATE, MS_STATE, MS_SYMB}, {LDC_STATE, MS_STATE, MS_SYMB},
+    {MS_STATE, SS_STATE, SD_SYMB}, {MS_STATE, TEMP_NM_STATE, NM_SYMB}, {MS_STATE, TEMP_SM_STATE, SM_SYMB},
+    {MS_STATE, TEMP_IM_STATE, IM_SYMB}, {SS_STATE, PD_STATE, PD_SYMB}, {TEMP_NM_STATE, MS_STATE, MS_SYMB},
+    {TEMP_SM_STATE, MS_STATE, MS_SYMB}, {TEMP_IM_STATE, MS_STATE, MS_SYMB}
+  };
+
+  initFSM(state_machine, NUM_STATES, NUM_SYMBOLS);
+  for (unsigned int i = 0; i < NUM_STATES; i++)
+    confState(state_machine, i, (i == B_STATE) ? START_STATE : (i == PD_STATE) ? ACCEPT_STATE : NORMAL_STATE,
+              countAction);
+  for (const auto &t : transitions)
+    addTrans(state_machine, t[0], t[1], t[2]);
+}
+
+
+/*
+Report Rate
+Actions:
+  • prints time per symbol and symbols per second
+*/
+static void reportRate(const char *label, unsigned long long symbols, double seconds) {
+  std::printf("  %-32s %8.3f ns/symbol %10.1f Msymbols/s\n", label, seconds * 1e9 / (double)symbols,
+              (double)symbols / seconds * 1e-6);
+}
+
+
+template <typename Fn>
+static double bestOf(Fn fn) {
+  double best = 0.0;
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (r == 0 || elapsed < best)
+      best = elapsed;
+  }
+  return best;
+}
+
+
+int main() {
+  const unsigned int mode_cycles = 1u << 23;
+  const unsigned int modes[] = {NM_SYMB, SM_SYMB, IM_SYMB};
+
+  // boot, cycle through the modes, shut down
+  std::vector<unsigned int> input = {IB_SYMB, CSS_SYMB, SSNS_SYMB, MS_SYMB};
+  for (unsigned int i = 0; i < mode_cycles; i++) {
+    input.push_back(modes[(i * 7u + (i >> 3)) % 3]);
+    input.push_back(MS_SYMB);
+  }
+  input.push_back(SD_SYMB);
+  input.push_back(PD_SYMB);
+  unsigned int length = (unsigned int)input.size();
+
+  std::printf("== static ==\n");
+
+  // startup cost
+  FSM machine;
+  auto start = std::chrono::steady_clock::now();
+  createStateMachine(&machine);
+  double setup = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("  table machine setup %.3f us, compile time machine setup 0 us (%zu byte table in rodata)\n",
+              setup * 1e6, sizeof(BootMachine::table));
+
+  INTERP_STATUS table_status = INTERP_OK;
+  reportRate("table runInterpreter", length, bestOf([&] {
+    Interpreter interp;
+    initInterpreter(&interp, &machine);
+    table_status = runInterpreter(&interp, input.data(), length);
+  }));
+
+  INTERP_STATUS static_status = INTERP_OK;
+  reportRate("compile time Runner::run", length, bestOf([&] {
+    BootMachine::Runner runner;
+    static_status = runner.run(input.data(), length);
+  }));
+
+  std::printf("  results %s, %llu actions run\n", (table_status == static_status) ? "agree" : "DISAGREE",
+              action_calls);
+
+  freeFSM(&machine);
+  return 0;
+}
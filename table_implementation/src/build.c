@@ -0,0 +1,411 @@
+// Author: Kevin Imlay
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BUILD_X86
+#endif
+
+#include "build.h"
+#include "cpu.h"
+
+/* ----- Private Structures ----- */
+
+/*
+Transitions filled by one thread, every edge given is added, in order.
+*/
+typedef struct {
+  FSM *fsm;
+  const unsigned int *from;
+  const unsigned int *symbols;
+  const unsigned int *to;
+  size_t edge_count;
+} EdgeJob;
+
+
+/*
+Edges bucketed by one thread, edges [first_edge, end_edge) are counted by the bucket of the state range
+their from state falls in, then copied to the sorted arrays starting at the job's offset in each bucket.
+*/
+typedef struct {
+  const unsigned int *from;
+  const unsigned int *symbols;
+  const unsigned int *to;
+  unsigned char *buckets;
+  size_t first_edge;
+  size_t end_edge;
+  unsigned int state_count;
+  unsigned int bucket_count;
+  size_t offsets[BUILD_MAX_THREADS];
+  unsigned int *sorted_from;
+  unsigned int *sorted_symbols;
+  unsigned int *sorted_to;
+} BucketJob;
+
+
+/*
+States filled by one thread, states [first_state, end_state) are configured.
+*/
+typedef struct {
+  FSM *fsm;
+  const STATE_TYPE *types;
+  void (* const *actions)(void);
+  unsigned int first_state;
+  unsigned int end_state;
+} StateJob;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static size_t findInvalidEdge(FSM *fsm, const unsigned int *from, const unsigned int *symbols,
+                              const unsigned int *to, size_t edge_count);
+#ifdef BUILD_X86
+static size_t skipValidEdgesAVX2(FSM *fsm, const unsigned int *from, const unsigned int *symbols,
+                                 const unsigned int *to, size_t edge_count);
+#endif
+static unsigned int threadsFor(unsigned int thread_count, size_t work, unsigned int state_count);
+static void runJobs(void *(*worker)(void *), void *jobs, size_t job_size, unsigned int job_count);
+static void *countBuckets(void *job);
+static void *sortBuckets(void *job);
+static void *fillTransitions(void *job);
+static void *fillStates(void *job);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Add Transitions
+Actions:
+  • validate every edge, stopping at the first invalid one
+  • split the states into one range per thread
+  • counting sort the edges by range, each thread counting then copying its share of the edges, so the
+    edges keep their order within a range
+  • each thread adds the edges of its range, in order
+  • on one thread, or if the sorted copy cannot be allocated, adds the edges in place on one thread
+*/
+FSM_STATUS addTransitions(FSM *fsm, const unsigned int *from, const unsigned int *symbols,
+                          const unsigned int *to, size_t edge_count, unsigned int thread_count,
+                          size_t *bad_edge) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+
+  size_t bad = findInvalidEdge(fsm, from, symbols, to, edge_count);
+  if (bad < edge_count) {
+    *bad_edge = bad;
+    if (from[bad] >= fsm->Qc || to[bad] >= fsm->Qc)
+      return FSM_NO_STATE;
+    return FSM_SIZE_ERR;
+  }
+
+  EdgeJob jobs[BUILD_MAX_THREADS];
+  unsigned int job_count = threadsFor(thread_count, edge_count, fsm->Qc);
+  unsigned int *sorted = NULL;
+  unsigned char *buckets = NULL;
+  if (job_count > 1) {
+    sorted = malloc(edge_count * 3 * sizeof(unsigned int));
+    buckets = malloc(edge_count);
+  }
+
+  // in place
+  if (sorted == NULL || buckets == NULL) {
+    free(sorted);
+    free(buckets);
+    jobs[0].fsm = fsm;
+    jobs[0].from = from;
+    jobs[0].symbols = symbols;
+    jobs[0].to = to;
+    jobs[0].edge_count = edge_count;
+    fillTransitions(&jobs[0]);
+    return FSM_OK;
+  }
+
+  // count
+  BucketJob sort_jobs[BUILD_MAX_THREADS];
+  for (unsigned int t = 0; t < job_count; t++) {
+    sort_jobs[t].from = from;
+    sort_jobs[t].symbols = symbols;
+    sort_jobs[t].to = to;
+    sort_jobs[t].buckets = buckets;
+    sort_jobs[t].first_edge = edge_count * t / job_count;
+    sort_jobs[t].end_edge = edge_count * (t + 1) / job_count;
+    sort_jobs[t].state_count = fsm->Qc;
+    sort_jobs[t].bucket_count = job_count;
+    sort_jobs[t].sorted_from = sorted;
+    sort_jobs[t].sorted_symbols = sorted + edge_count;
+    sort_jobs[t].sorted_to = sorted + 2 * edge_count;
+  }
+  runJobs(countBuckets, sort_jobs, sizeof(BucketJob), job_count);
+
+  // offsets, buckets in order and each bucket's edges in the order of the jobs
+  size_t bucket_starts[BUILD_MAX_THREADS + 1];
+  size_t next = 0;
+  for (unsigned int b = 0; b < job_count; b++) {
+    bucket_starts[b] = next;
+    for (unsigned int t = 0; t < job_count; t++) {
+      size_t count = sort_jobs[t].offsets[b];
+      sort_jobs[t].offsets[b] = next;
+      next += count;
+    }
+  }
+  bucket_starts[job_count] = next;
+
+  // copy
+  runJobs(sortBuckets, sort_jobs, sizeof(BucketJob), job_count);
+  free(buckets);
+
+  // fill
+  for (unsigned int t = 0; t < job_count; t++) {
+    jobs[t].fsm = fsm;
+    jobs[t].from = sorted + bucket_starts[t];
+    jobs[t].symbols = sorted + edge_count + bucket_starts[t];
+    jobs[t].to = sorted + 2 * edge_count + bucket_starts[t];
+    jobs[t].edge_count = bucket_starts[t + 1] - bucket_starts[t];
+  }
+  runJobs(fillTransitions, jobs, sizeof(EdgeJob), job_count);
+  free(sorted);
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Configure States
+Actions:
+  • validate every designation, finding the last start state on the way
+  • split the states into one range per thread
+  • each thread sets the designation and action of the states in its range
+*/
+FSM_STATUS confStates(FSM *fsm, const STATE_TYPE *types, void (* const *actions)(void),
+                      unsigned int thread_count, unsigned int *bad_state) {
+  // validate inputs
+  if (fsm == NULL || fsm->Q == NULL)
+    return FSM_NO_MACHINE;
+
+  unsigned int start_id = fsm->Qc;
+  for (unsigned int i = 0; i < fsm->Qc; i++) {
+    if (types[i] != START_STATE && types[i] != ACCEPT_STATE && types[i] != NORMAL_STATE) {
+      *bad_state = i;
+      return FSM_SIZE_ERR;
+    }
+    if (types[i] == START_STATE)
+      start_id = i;
+  }
+
+  // fill
+  StateJob jobs[BUILD_MAX_THREADS];
+  unsigned int job_count = threadsFor(thread_count, fsm->Qc, fsm->Qc);
+  for (unsigned int t = 0; t < job_count; t++) {
+    jobs[t].fsm = fsm;
+    jobs[t].types = types;
+    jobs[t].actions = actions;
+    jobs[t].first_state = (unsigned int)((unsigned long long)fsm->Qc * t / job_count);
+    jobs[t].end_state = (unsigned int)((unsigned long long)fsm->Qc * (t + 1) / job_count);
+  }
+  runJobs(fillStates, jobs, sizeof(StateJob), job_count);
+
+  // set machine start if needed
+  if (start_id < fsm->Qc)
+    fsm->Qs = &fsm->Q[start_id];
+
+  // successful
+  return FSM_OK;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Find Invalid Edge
+Actions:
+  • skips the leading valid edges with the vector kernel for this CPU, if any
+  • checks the rest one at a time
+  • returns the index of the first invalid edge, or the edge count if all are valid
+*/
+static size_t findInvalidEdge(FSM *fsm, const unsigned int *from, const unsigned int *symbols,
+                              const unsigned int *to, size_t edge_count) {
+  size_t i = 0;
+
+#ifdef BUILD_X86
+  if (cpuHasAVX2())
+    i = skipValidEdgesAVX2(fsm, from, symbols, to, edge_count);
+#endif
+
+  for (; i < edge_count; i++)
+    if (from[i] >= fsm->Qc || to[i] >= fsm->Qc || symbols[i] >= fsm->Ec)
+      return i;
+
+  return edge_count;
+}
+
+
+#ifdef BUILD_X86
+
+/*
+Skip Valid Edges AVX2
+Actions:
+  • checks 32 edges at a time, 8 per vector
+  • returns the start of the first group with an invalid edge, or of the partial group at the end
+*/
+__attribute__((target("avx2")))
+static size_t skipValidEdgesAVX2(FSM *fsm, const unsigned int *from, const unsigned int *symbols,
+                                 const unsigned int *to, size_t edge_count) {
+  // unsigned x >= limit is max(x, limit) == x
+  const __m256i qc = _mm256_set1_epi32((int)fsm->Qc);
+  const __m256i ec = _mm256_set1_epi32((int)fsm->Ec);
+
+  size_t i = 0;
+  for (; i + 32 <= edge_count; i += 32) {
+    __m256i bad = _mm256_setzero_si256();
+    for (size_t j = i; j < i + 32; j += 8) {
+      __m256i f = _mm256_loadu_si256((const __m256i *)(from + j));
+      __m256i t = _mm256_loadu_si256((const __m256i *)(to + j));
+      __m256i e = _mm256_loadu_si256((const __m256i *)(symbols + j));
+      bad = _mm256_or_si256(bad, _mm256_cmpeq_epi32(_mm256_max_epu32(f, qc), f));
+      bad = _mm256_or_si256(bad, _mm256_cmpeq_epi32(_mm256_max_epu32(t, qc), t));
+      bad = _mm256_or_si256(bad, _mm256_cmpeq_epi32(_mm256_max_epu32(e, ec), e));
+    }
+    if (!_mm256_testz_si256(bad, bad))
+      break;
+  }
+
+  return i;
+}
+
+#endif
+
+
+/*
+Threads For
+Actions:
+  • resolves 0 to the count of online CPUs and caps at BUILD_MAX_THREADS
+  • uses one thread for small builds, and never more threads than states
+*/
+static unsigned int threadsFor(unsigned int thread_count, size_t work, unsigned int state_count) {
+  if (thread_count == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = (cpus > 0) ? (unsigned int)cpus : 1;
+  }
+  if (thread_count > BUILD_MAX_THREADS)
+    thread_count = BUILD_MAX_THREADS;
+  if (work < BUILD_PARALLEL_MIN)
+    thread_count = 1;
+  if (thread_count > state_count)
+    thread_count = state_count;
+
+  return thread_count;
+}
+
+
+/*
+Run Jobs
+Actions:
+  • starts a thread for every job but the first, and runs the first on the calling thread
+  • runs a job on the calling thread if its thread cannot be started, as the jobs are independent
+  • waits for the threads to finish
+*/
+static void runJobs(void *(*worker)(void *), void *jobs, size_t job_size, unsigned int job_count) {
+  pthread_t threads[BUILD_MAX_THREADS];
+  int started[BUILD_MAX_THREADS];
+
+  for (unsigned int t = 1; t < job_count; t++) {
+    void *job = (char *)jobs + t * job_size;
+    started[t] = (pthread_create(&threads[t], NULL, worker, job) == 0);
+    if (!started[t])
+      worker(job);
+  }
+
+  if (job_count > 0)
+    worker(jobs);
+
+  for (unsigned int t = 1; t < job_count; t++)
+    if (started[t])
+      pthread_join(threads[t], NULL);
+}
+
+
+/*
+Count Buckets
+Actions:
+  • finds the bucket of each of the job's edges, the last range whose first state is at most its from
+    state, and counts the edges of each bucket
+*/
+static void *countBuckets(void *job) {
+  BucketJob *sort = job;
+  size_t counts[BUILD_MAX_THREADS] = {0};
+  unsigned long long bucket_count = sort->bucket_count;
+
+  for (size_t i = sort->first_edge; i < sort->end_edge; i++) {
+    // range t starts at state Qc * t / bucket_count, rounded down
+    unsigned int bucket = (unsigned int)(((sort->from[i] + 1ULL) * bucket_count - 1) / sort->state_count);
+    sort->buckets[i] = (unsigned char)bucket;
+    counts[bucket]++;
+  }
+
+  for (unsigned int b = 0; b < sort->bucket_count; b++)
+    sort->offsets[b] = counts[b];
+  return NULL;
+}
+
+
+/*
+Sort Buckets
+Actions:
+  • copies each of the job's edges, in order, to the next place of the job in its bucket
+*/
+static void *sortBuckets(void *job) {
+  BucketJob *sort = job;
+  size_t offsets[BUILD_MAX_THREADS];
+
+  for (unsigned int b = 0; b < sort->bucket_count; b++)
+    offsets[b] = sort->offsets[b];
+
+  for (size_t i = sort->first_edge; i < sort->end_edge; i++) {
+    size_t place = offsets[sort->buckets[i]]++;
+    sort->sorted_from[place] = sort->from[i];
+    sort->sorted_symbols[place] = sort->symbols[i];
+    sort->sorted_to[place] = sort->to[i];
+  }
+
+  return NULL;
+}
+
+
+/*
+Fill Transitions
+Actions:
+  • adds every edge of the job, in order
+*/
+static void *fillTransitions(void *job) {
+  EdgeJob *edges = job;
+  State **table = edges->fsm->D;
+  State *states = edges->fsm->Q;
+  size_t symbol_count = edges->fsm->Ec;
+
+  for (size_t i = 0; i < edges->edge_count; i++)
+    table[edges->from[i] * symbol_count + edges->symbols[i]] = &states[edges->to[i]];
+
+  return NULL;
+}
+
+
+/*
+Fill States
+Actions:
+  • sets the designation and action of every state in the job's range
+*/
+static void *fillStates(void *job) {
+  StateJob *range = job;
+  State *states = range->fsm->Q;
+
+  for (unsigned int i = range->first_state; i < range->end_state; i++) {
+    states[i].type = range->types[i];
+    states[i].action = (range->actions != NULL) ? range->actions[i] : NULL;
+  }
+
+  return NULL;
+}
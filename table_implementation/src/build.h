@@ -0,0 +1,92 @@
+// Author: Kevin Imlay
+
+/*
+Bulk building configures the states and adds the transitions of a machine from arrays in one call, rather
+than one confState() or addTrans() call per state or transition. The arrays are validated in one pass
+before anything is changed, with edges checked by AVX2 when the CPU supports it. If any entry is invalid,
+the machine is left unchanged and the index of the first invalid entry is passed back.
+
+Large machines are filled by several threads. Each thread owns a range of states, and only writes the
+states and transition table rows in its range, so the result is the same as calling confState() or
+addTrans() on each entry in order: when several edges set the same transition, the last one is kept.
+Edges are first sorted into their thread's range with a counting sort that keeps their order, split over
+the same threads, so each thread only reads the edges it adds.
+*/
+
+#ifndef BUILD_H
+#define BUILD_H
+
+#include <stddef.h>
+
+#include "fsm.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Entries below which a bulk build runs on the calling thread only.
+*/
+#define BUILD_PARALLEL_MIN 65536
+
+/*
+Most threads a bulk build uses.
+*/
+#define BUILD_MAX_THREADS 64
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Add Transitions
+Adds a list of edges to the machine, the same as calling addTrans() on each edge in order.
+
+Arguments:
+  • fsm - pointer to the fsm.
+  • from - array of the unsigned integer ID of the state each edge travels from.
+  • symbols - array of the unsigned integer symbol of each edge.
+  • to - array of the unsigned integer ID of the state each edge travels to.
+  • edge_count - number of edges.
+  • thread_count - most threads to fill the table with.
+      Note: 0 uses one thread per online CPU.
+      Note: on several threads, a sorted copy of the edges is made, 13 bytes per edge. If it cannot be
+      allocated the edges are added on the calling thread.
+  • bad_edge - [pass back] index of the first invalid edge.
+      Note: only written when FSM_NO_STATE or FSM_SIZE_ERR is returned.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if an edge's from or to state ID is not in the machine, no edges are added.
+  • FSM_SIZE_ERR - if an edge's symbol is larger than the number of symbols set in the machine, no
+      edges are added.
+  • FSM_NO_MACHINE - the machine pointer provided was null or the machine is not initialized.
+*/
+FSM_STATUS addTransitions(FSM *fsm, const unsigned int *from, const unsigned int *symbols,
+                          const unsigned int *to, size_t edge_count, unsigned int thread_count,
+                          size_t *bad_edge);
+
+
+/*
+Configure States
+Sets the designation and action of every state of the machine, the same as calling confState() on each
+state in order of ID.
+
+Arguments:
+  • fsm - pointer to the fsm.
+  • types - array of Qc designations, one per state ID.
+      Note: if several states are designated as the start state, the last one is the start state.
+  • actions - array of Qc action function pointers, one per state ID.
+      Note: may be null, to clear every action.
+  • thread_count - most threads to fill the states with.
+      Note: 0 uses one thread per online CPU.
+  • bad_state - [pass back] ID of the first state with an invalid designation.
+      Note: only written when FSM_SIZE_ERR is returned.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_SIZE_ERR - if a designation is not a STATE_TYPE, no states are changed.
+  • FSM_NO_MACHINE - the machine pointer provided was null or the machine is not initialized.
+*/
+FSM_STATUS confStates(FSM *fsm, const STATE_TYPE *types, void (* const *actions)(void),
+                      unsigned int thread_count, unsigned int *bad_state);
+
+#endif
@@ -0,0 +1,281 @@
+// Author: Kevin Imlay
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BULK_X86
+#endif
+
+#include "bulk.h"
+#include "cpu.h"
+
+/* ----- Private Types ----- */
+
+/*
+A bulk step kernel steps instances from the start of the batch and returns how many it stepped. The
+remaining instances are stepped by the scalar kernel.
+*/
+typedef unsigned int (*BulkKernel)(const StateTable *table, const unsigned int *states,
+                                   const unsigned int *symbols, unsigned int count,
+                                   unsigned int *next_states, unsigned long long *invalid_mask,
+                                   unsigned long long *accept_mask);
+
+
+/* ----- Private Variables ----- */
+
+/*
+Kernel forced by setBulkKernel(), and the widest kernel the CPU supports, BULK_AUTO until first selected.
+Atomic, as any thread may step or force a kernel, and threads selecting at once all store the same one.
+*/
+static atomic_int forced_kernel = BULK_AUTO;
+#ifdef BULK_X86
+static atomic_int widest_kernel = BULK_AUTO;
+#endif
+
+
+/* ----- Private Function Prototypes ----- */
+
+static void stepScalar(const StateTable *table, const unsigned int *states, const unsigned int *symbols,
+                       unsigned int begin, unsigned int count, unsigned int *next_states,
+                       unsigned long long *invalid_mask, unsigned long long *accept_mask);
+
+#ifdef BULK_X86
+static unsigned int stepAVX2(const StateTable *table, const unsigned int *states,
+                             const unsigned int *symbols, unsigned int count, unsigned int *next_states,
+                             unsigned long long *invalid_mask, unsigned long long *accept_mask);
+static unsigned int stepAVX512(const StateTable *table, const unsigned int *states,
+                               const unsigned int *symbols, unsigned int count, unsigned int *next_states,
+                               unsigned long long *invalid_mask, unsigned long long *accept_mask);
+#endif
+
+static BulkKernel selectKernel(void);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Bulk Step
+Actions:
+  • clear the masks
+  • step as many instances as possible with the vector kernel for this CPU, if any
+  • step the rest with the scalar kernel
+*/
+INTERP_STATUS bulkStep(const StateTable *table, const unsigned int *states, const unsigned int *symbols,
+                       unsigned int count, unsigned int *next_states,
+                       unsigned long long *invalid_mask, unsigned long long *accept_mask) {
+  // validate inputs
+  if (table == NULL || table->next == NULL)
+    return INTERP_NO_MACHINE;
+
+  // clear masks
+  size_t words = ((size_t)count + 63) / 64;
+  memset(invalid_mask, 0, words * sizeof(unsigned long long));
+  memset(accept_mask, 0, words * sizeof(unsigned long long));
+
+  // vector kernels index the table with signed 32-bit offsets
+  unsigned int stepped = 0;
+  BulkKernel kernel = selectKernel();
+  if (kernel != NULL && (size_t)table->Qc * table->Ec <= INT_MAX)
+    stepped = kernel(table, states, symbols, count, next_states, invalid_mask, accept_mask);
+
+  stepScalar(table, states, symbols, stepped, count, next_states, invalid_mask, accept_mask);
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Set Bulk Kernel
+Actions:
+  • checks the CPU supports the kernel before forcing it
+*/
+int setBulkKernel(BULK_KERNEL kernel) {
+  switch (kernel) {
+    case BULK_AUTO:
+    case BULK_SCALAR:
+      break;
+#ifdef BULK_X86
+    case BULK_AVX2:
+      if (!cpuHasAVX2())
+        return 0;
+      break;
+    case BULK_AVX512:
+      if (!cpuHasAVX512())
+        return 0;
+      break;
+#endif
+    default:
+      return 0;
+  }
+
+  atomic_store_explicit(&forced_kernel, kernel, memory_order_relaxed);
+  return 1;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Step Scalar
+Actions:
+  • steps instances [begin, count) one at a time
+*/
+static void stepScalar(const StateTable *table, const unsigned int *states, const unsigned int *symbols,
+                       unsigned int begin, unsigned int count, unsigned int *next_states,
+                       unsigned long long *invalid_mask, unsigned long long *accept_mask) {
+  // the stores may alias the table as far as the compiler knows, so its fields are read once here
+  const unsigned int state_count = table->Qc;
+  const unsigned int symbol_count = table->Ec;
+  const unsigned int *next_table = table->next;
+  const unsigned long long *accept = table->accept;
+
+  for (unsigned int i = begin; i < count; i++) {
+    unsigned int state = states[i];
+    unsigned int symbol = symbols[i];
+    unsigned int next = TABLE_NO_STATE;
+
+    if (state < state_count && symbol < symbol_count)
+      next = next_table[(size_t)state * symbol_count + symbol];
+
+    if (next == TABLE_NO_STATE) {
+      next_states[i] = state;
+      invalid_mask[i >> 6] |= 1ULL << (i & 63);
+    }
+    else {
+      next_states[i] = next;
+      accept_mask[i >> 6] |= ((accept[next >> 6] >> (next & 63)) & 1) << (i & 63);
+    }
+  }
+}
+
+
+/*
+Select Kernel
+Actions:
+  • the forced kernel, if any
+  • otherwise the widest vector kernel the CPU supports, picked on the first call and kept
+*/
+static BulkKernel selectKernel(void) {
+#ifdef BULK_X86
+  int kernel = atomic_load_explicit(&forced_kernel, memory_order_relaxed);
+  if (kernel == BULK_AUTO) {
+    kernel = atomic_load_explicit(&widest_kernel, memory_order_relaxed);
+    if (kernel == BULK_AUTO) {
+      kernel = cpuHasAVX512() ? BULK_AVX512 : cpuHasAVX2() ? BULK_AVX2 : BULK_SCALAR;
+      atomic_store_explicit(&widest_kernel, kernel, memory_order_relaxed);
+    }
+  }
+
+  if (kernel == BULK_AVX512)
+    return stepAVX512;
+  if (kernel == BULK_AVX2)
+    return stepAVX2;
+  return NULL;
+#else
+  return NULL;
+#endif
+}
+
+
+#ifdef BULK_X86
+
+/*
+Step AVX2
+Actions:
+  • steps 8 instances at a time
+  • a lane is valid if its state and symbol are in range and the gathered next state exists
+  • the accepting bit of the next state is gathered from the bitmap as 32-bit words
+*/
+__attribute__((target("avx2")))
+static unsigned int stepAVX2(const StateTable *table, const unsigned int *states,
+                             const unsigned int *symbols, unsigned int count, unsigned int *next_states,
+                             unsigned long long *invalid_mask, unsigned long long *accept_mask) {
+  const __m256i qc = _mm256_set1_epi32((int)table->Qc);
+  const __m256i ec = _mm256_set1_epi32((int)table->Ec);
+  const __m256i none = _mm256_set1_epi32(-1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i low5 = _mm256_set1_epi32(31);
+
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i s = _mm256_loadu_si256((const __m256i *)(states + i));
+    __m256i e = _mm256_loadu_si256((const __m256i *)(symbols + i));
+
+    // unsigned x >= limit is max(x, limit) == x
+    __m256i s_bad = _mm256_cmpeq_epi32(_mm256_max_epu32(s, qc), s);
+    __m256i e_bad = _mm256_cmpeq_epi32(_mm256_max_epu32(e, ec), e);
+    __m256i in_range = _mm256_andnot_si256(_mm256_or_si256(s_bad, e_bad), none);
+
+    // gather next states
+    __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(s, ec), e);
+    __m256i n = _mm256_mask_i32gather_epi32(none, (const int *)table->next, index, in_range, 4);
+    __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(n, none), in_range);
+
+    // gather accepting bits
+    __m256i word = _mm256_mask_i32gather_epi32(zero, (const int *)table->accept,
+                                               _mm256_srli_epi32(n, 5), valid, 4);
+    __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(n, low5)), one);
+    __m256i accepting = _mm256_and_si256(_mm256_cmpeq_epi32(bit, one), valid);
+
+    // invalid lanes keep their current state
+    _mm256_storeu_si256((__m256i *)(next_states + i), _mm256_blendv_epi8(s, n, valid));
+
+    unsigned long long valid_bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(valid));
+    unsigned long long accept_bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(accepting));
+    invalid_mask[i >> 6] |= (~valid_bits & 0xFFULL) << (i & 63);
+    accept_mask[i >> 6] |= accept_bits << (i & 63);
+  }
+
+  return i;
+}
+
+
+/*
+Step AVX-512
+Actions:
+  • steps 16 instances at a time, same as the AVX2 kernel but with mask registers
+*/
+__attribute__((target("avx512f")))
+static unsigned int stepAVX512(const StateTable *table, const unsigned int *states,
+                               const unsigned int *symbols, unsigned int count, unsigned int *next_states,
+                               unsigned long long *invalid_mask, unsigned long long *accept_mask) {
+  const __m512i qc = _mm512_set1_epi32((int)table->Qc);
+  const __m512i ec = _mm512_set1_epi32((int)table->Ec);
+  const __m512i none = _mm512_set1_epi32(-1);
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i low5 = _mm512_set1_epi32(31);
+
+  unsigned int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512i s = _mm512_loadu_si512((const void *)(states + i));
+    __m512i e = _mm512_loadu_si512((const void *)(symbols + i));
+    __mmask16 in_range = _mm512_cmplt_epu32_mask(s, qc) & _mm512_cmplt_epu32_mask(e, ec);
+
+    // gather next states
+    __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(s, ec), e);
+    __m512i n = _mm512_mask_i32gather_epi32(none, in_range, index, (const void *)table->next, 4);
+    __mmask16 valid = _mm512_mask_cmpneq_epi32_mask(in_range, n, none);
+
+    // gather accepting bits
+    __m512i word = _mm512_mask_i32gather_epi32(zero, valid, _mm512_srli_epi32(n, 5),
+                                               (const void *)table->accept, 4);
+    __m512i bit = _mm512_srlv_epi32(word, _mm512_and_si512(n, low5));
+    __mmask16 accepting = _mm512_mask_test_epi32_mask(valid, bit, one);
+
+    // invalid lanes keep their current state
+    _mm512_storeu_si512((void *)(next_states + i), _mm512_mask_blend_epi32(valid, s, n));
+
+    invalid_mask[i >> 6] |= (unsigned long long)(__mmask16)~valid << (i & 63);
+    accept_mask[i >> 6] |= (unsigned long long)accepting << (i & 63);
+  }
+
+  return i;
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Author: Kevin Imlay
+
+/*
+Bulk stepping applies one input symbol to each of many instances of the same machine in one call. Each
+instance is only described by its current state ID, so a batch of instances is two arrays: current
+states and the symbols they receive. The next states are computed with AVX-512 or AVX2 gathers when the
+CPU supports them, and with a scalar loop otherwise.
+*/
+
+#ifndef BULK_H
+#define BULK_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Enumerations ----- */
+
+/*
+Kernel used to step a batch.
+*/
+typedef enum {
+  BULK_AUTO = 7000, // widest kernel the CPU supports
+  BULK_SCALAR,      // one instance at a time
+  BULK_AVX2,        // 8 instances at a time
+  BULK_AVX512       // 16 instances at a time
+} BULK_KERNEL;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Bulk Step
+Steps every instance of a batch by one symbol.
+
+Arguments:
+  • table - pointer to the state table of the machine.
+  • states - array of the current state ID of each instance.
+  • symbols - array of the symbol input to each instance.
+  • count - number of instances in the batch.
+  • next_states - [pass back] array of the next state ID of each instance.
+      Note: may be the same array as states to step in place.
+      Note: an instance with an invalid transition keeps its current state.
+  • invalid_mask - [pass back] bitmask, one bit per instance, set if the state or symbol of the instance
+      is invalid, or if there is no transition out of its state on its symbol.
+      Note: must hold (count + 63) / 64 words.
+  • accept_mask - [pass back] bitmask, one bit per instance, set if the instance's next state is an
+      accepting state.
+      Note: must hold (count + 63) / 64 words.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_NO_MACHINE - if the table provided is null or not initialized.
+*/
+INTERP_STATUS bulkStep(const StateTable *table, const unsigned int *states, const unsigned int *symbols,
+                       unsigned int count, unsigned int *next_states,
+                       unsigned long long *invalid_mask, unsigned long long *accept_mask);
+
+
+/*
+Set Bulk Kernel
+Forces the kernel bulkStep() uses, to compare the kernels with each other.
+Note: may be called while other threads step, each step uses the kernel set when it starts.
+
+Arguments:
+  • kernel - the kernel to use, BULK_AUTO to go back to the widest one the CPU supports.
+
+Returns:
+  • 1 - if the kernel is set.
+  • 0 - if the CPU or build does not support the kernel, the kernel used is not changed.
+*/
+int setBulkKernel(BULK_KERNEL kernel);
+
+#endif
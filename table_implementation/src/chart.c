@@ -0,0 +1,493 @@
+// Author: Kevin Imlay
+
+#include <stdint.h>
+
+#include "chart.h"
+
+/* ----- Private Structures ----- */
+
+/*
+Growing array of actions, built while flattening.
+*/
+typedef struct {
+  void (**actions)(void);
+  size_t count;
+  size_t capacity;
+} ActionList;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int resolveLeaf(const Chart *chart, const unsigned char *has_child, unsigned int node);
+static unsigned int findDomain(const Chart *chart, const unsigned int *depth, unsigned int source,
+                               unsigned int target);
+static int appendAction(ActionList *list, void (*action)(void));
+static int appendExits(ActionList *list, const Chart *chart, unsigned int leaf, unsigned int domain);
+static int appendEntries(ActionList *list, const Chart *chart, unsigned int leaf, unsigned int domain);
+static void runActions(const FlatChart *flat, size_t sequence);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Chart
+Actions:
+  • validates the sizes
+  • allocates the node arrays and transition table
+  • places every node at the top level, normal, with no actions or transitions
+*/
+FSM_STATUS initChart(Chart *chart, unsigned int node_count, unsigned int symbol_count) {
+  // validate inputs
+  if (chart == NULL)
+    return FSM_NO_MACHINE;
+  if (node_count == 0 || symbol_count == 0 || node_count == CHART_NO_NODE ||
+      (size_t)node_count > SIZE_MAX / sizeof(unsigned int) / symbol_count)
+    return FSM_SIZE_ERR;
+
+  // allocate
+  chart->parent = malloc(node_count * sizeof(unsigned int));
+  chart->initial = malloc(node_count * sizeof(unsigned int));
+  chart->entry = calloc(node_count, sizeof(void (*)(void)));
+  chart->exit = calloc(node_count, sizeof(void (*)(void)));
+  chart->type = malloc(node_count * sizeof(STATE_TYPE));
+  chart->trans = malloc((size_t)node_count * symbol_count * sizeof(unsigned int));
+  chart->node_count = node_count;
+  chart->symbol_count = symbol_count;
+  chart->start = CHART_NO_NODE;
+  if (chart->parent == NULL || chart->initial == NULL || chart->entry == NULL || chart->exit == NULL ||
+      chart->type == NULL || chart->trans == NULL) {
+    freeChart(chart);
+    return FSM_ALLOC_ERR;
+  }
+
+  // default nodes
+  for (unsigned int i = 0; i < node_count; i++) {
+    chart->parent[i] = CHART_NO_NODE;
+    chart->initial[i] = CHART_NO_NODE;
+    chart->type[i] = NORMAL_STATE;
+  }
+  for (size_t i = 0; i < (size_t)node_count * symbol_count; i++)
+    chart->trans[i] = CHART_NO_NODE;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Chart
+Actions:
+  • frees the node arrays and transition table
+*/
+void freeChart(Chart *chart) {
+  if (chart == NULL)
+    return;
+
+  free(chart->parent);
+  free(chart->initial);
+  free(chart->entry);
+  free(chart->exit);
+  free(chart->type);
+  free(chart->trans);
+  chart->parent = NULL;
+  chart->initial = NULL;
+  chart->entry = NULL;
+  chart->exit = NULL;
+  chart->type = NULL;
+  chart->trans = NULL;
+  chart->node_count = 0;
+}
+
+
+/*
+Configure Node
+Actions:
+  • validates the node and parent, and that the parent is not nested in the node
+  • moves the node, clearing the old parent's initial child if it was the node
+  • sets the designation and actions, moving the start to the node if it is the start
+*/
+FSM_STATUS confNode(Chart *chart, unsigned int node_id, unsigned int parent_id, STATE_TYPE designation,
+                    void (*entry)(void), void (*exit)(void)) {
+  // validate inputs
+  if (chart == NULL || chart->parent == NULL)
+    return FSM_NO_MACHINE;
+  if (node_id >= chart->node_count || (parent_id != CHART_NO_NODE && parent_id >= chart->node_count))
+    return FSM_NO_STATE;
+  for (unsigned int n = parent_id; n != CHART_NO_NODE; n = chart->parent[n])
+    if (n == node_id)
+      return FSM_SIZE_ERR;
+
+  // move
+  unsigned int old_parent = chart->parent[node_id];
+  if (old_parent != parent_id && old_parent != CHART_NO_NODE && chart->initial[old_parent] == node_id)
+    chart->initial[old_parent] = CHART_NO_NODE;
+  chart->parent[node_id] = parent_id;
+
+  // configure
+  chart->type[node_id] = designation;
+  chart->entry[node_id] = entry;
+  chart->exit[node_id] = exit;
+  if (designation == START_STATE)
+    chart->start = node_id;
+  else if (chart->start == node_id)
+    chart->start = CHART_NO_NODE;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Set Initial
+Actions:
+  • validates the child is a child of the node
+  • sets the node's initial child
+*/
+FSM_STATUS setInitial(Chart *chart, unsigned int node_id, unsigned int child_id) {
+  // validate inputs
+  if (chart == NULL || chart->parent == NULL)
+    return FSM_NO_MACHINE;
+  if (node_id >= chart->node_count || child_id >= chart->node_count || chart->parent[child_id] != node_id)
+    return FSM_NO_STATE;
+
+  chart->initial[node_id] = child_id;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Add Chart Transition
+Actions:
+  • validates the nodes and symbol
+  • sets the node's target on the symbol
+*/
+FSM_STATUS addChartTrans(Chart *chart, unsigned int from_node_id, unsigned int to_node_id, unsigned int symbol) {
+  // validate inputs
+  if (chart == NULL || chart->trans == NULL)
+    return FSM_NO_MACHINE;
+  if (from_node_id >= chart->node_count || to_node_id >= chart->node_count)
+    return FSM_NO_STATE;
+  if (symbol >= chart->symbol_count)
+    return FSM_SIZE_ERR;
+
+  chart->trans[(size_t)from_node_id * chart->symbol_count + symbol] = to_node_id;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Flatten Chart
+Actions:
+  • gives every leaf node a flat state, and computes the depth of every node
+  • for every leaf and symbol, finds the innermost node containing the leaf with a transition on the
+    symbol, resolves its target to a leaf, and records the exits from the leaf up to the transition's
+    domain and the entries from the domain down to the target leaf
+  • records the entries from the top level down to the start leaf last
+*/
+FSM_STATUS flattenChart(Chart *chart, FlatChart *flat) {
+  // validate inputs
+  if (chart == NULL || flat == NULL || chart->trans == NULL)
+    return FSM_NO_MACHINE;
+  if (chart->start == CHART_NO_NODE)
+    return FSM_NO_STATE;
+
+  unsigned int node_count = chart->node_count;
+  unsigned int symbol_count = chart->symbol_count;
+
+  // leaves and depths
+  unsigned int *depth = calloc(node_count, sizeof(unsigned int));
+  unsigned char *has_child = calloc(node_count, 1);
+  flat->node_state = malloc(node_count * sizeof(unsigned int));
+  flat->state_node = malloc(node_count * sizeof(unsigned int));
+  flat->first = NULL;
+  flat->actions = NULL;
+  flat->fsm.Q = NULL;
+  flat->fsm.D = NULL;
+  flat->fsm.Dbytes = 0;
+  ActionList list = {NULL, 0, 0};
+  FSM_STATUS status = FSM_ALLOC_ERR;
+  if (depth == NULL || has_child == NULL || flat->node_state == NULL || flat->state_node == NULL)
+    goto fail;
+
+  for (unsigned int i = 0; i < node_count; i++) {
+    if (chart->parent[i] != CHART_NO_NODE)
+      has_child[chart->parent[i]] = 1;
+    for (unsigned int n = chart->parent[i]; n != CHART_NO_NODE; n = chart->parent[n])
+      depth[i]++;
+  }
+  unsigned int leaf_count = 0;
+  for (unsigned int i = 0; i < node_count; i++) {
+    flat->node_state[i] = has_child[i] ? CHART_NO_NODE : leaf_count;
+    if (!has_child[i])
+      flat->state_node[leaf_count++] = i;
+  }
+  unsigned int start_leaf = resolveLeaf(chart, has_child, chart->start);
+  if (start_leaf == CHART_NO_NODE) {
+    status = FSM_NO_STATE;
+    goto fail;
+  }
+
+  // flat machine
+  status = initFSM(&flat->fsm, leaf_count, symbol_count);
+  if (status != FSM_OK)
+    goto fail;
+  status = FSM_ALLOC_ERR;
+  size_t cells = (size_t)leaf_count * symbol_count;
+  flat->first = malloc((cells + 2) * sizeof(size_t));
+  if (flat->first == NULL)
+    goto fail;
+
+  for (unsigned int state = 0; state < leaf_count; state++) {
+    unsigned int leaf = flat->state_node[state];
+    STATE_TYPE type = (leaf == start_leaf) ? START_STATE :
+                      (chart->type[leaf] == ACCEPT_STATE) ? ACCEPT_STATE : NORMAL_STATE;
+    confState(&flat->fsm, state, type, NULL);
+
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+      size_t cell = (size_t)state * symbol_count + symbol;
+      flat->first[cell] = list.count;
+
+      // innermost transition on the symbol
+      unsigned int source = leaf;
+      while (source != CHART_NO_NODE && chart->trans[(size_t)source * symbol_count + symbol] == CHART_NO_NODE)
+        source = chart->parent[source];
+      if (source == CHART_NO_NODE)
+        continue;
+
+      unsigned int target = chart->trans[(size_t)source * symbol_count + symbol];
+      unsigned int target_leaf = resolveLeaf(chart, has_child, target);
+      if (target_leaf == CHART_NO_NODE) {
+        status = FSM_NO_STATE;
+        goto fail;
+      }
+
+      unsigned int domain = findDomain(chart, depth, source, target);
+      if (!appendExits(&list, chart, leaf, domain) || !appendEntries(&list, chart, target_leaf, domain))
+        goto fail;
+      addTrans(&flat->fsm, state, flat->node_state[target_leaf], symbol);
+    }
+  }
+
+  // start entries
+  flat->first[cells] = list.count;
+  if (!appendEntries(&list, chart, start_leaf, CHART_NO_NODE))
+    goto fail;
+  flat->first[cells + 1] = list.count;
+  flat->actions = list.actions;
+
+  free(depth);
+  free(has_child);
+
+  // successful
+  return FSM_OK;
+
+fail:
+  free(depth);
+  free(has_child);
+  free(list.actions);
+  freeFlatChart(flat);
+  return status;
+}
+
+
+/*
+Free Flat Chart
+Actions:
+  • frees the machine, maps and action sequences
+*/
+void freeFlatChart(FlatChart *flat) {
+  if (flat == NULL)
+    return;
+
+  freeFSM(&flat->fsm);
+  free(flat->state_node);
+  free(flat->node_state);
+  free(flat->first);
+  free(flat->actions);
+  flat->state_node = NULL;
+  flat->node_state = NULL;
+  flat->first = NULL;
+  flat->actions = NULL;
+}
+
+
+/*
+Initialize Chart Interpreter
+Actions:
+  • initializes the interpreter on the flat machine
+  • runs the start state's entry actions
+*/
+INTERP_STATUS initChartInterpreter(Interpreter *interp, FlatChart *flat) {
+  if (flat == NULL)
+    return INTERP_NO_MACHINE;
+
+  INTERP_STATUS status = initInterpreter(interp, &flat->fsm);
+  if (status != INTERP_OK)
+    return status;
+
+  runActions(flat, (size_t)flat->fsm.Qc * flat->fsm.Ec);
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Step Chart
+Actions:
+  • looks up the transition in the flat table
+  • runs its exit and entry actions, then moves to the new state
+*/
+INTERP_STATUS stepChart(Interpreter *interp, const FlatChart *flat, unsigned int symbol) {
+  // validate inputs
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (symbol >= flat->fsm.Ec)
+    return INTERP_SYMB_ERR;
+
+  size_t cell = (size_t)interp->current_state->id * flat->fsm.Ec + symbol;
+  State *next = flat->fsm.D[cell];
+  if (next == NULL)
+    return INTERP_TRANS_ERR;
+
+  runActions(flat, cell);
+  interp->current_state = next;
+  interp->position++;
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Run Chart
+Actions:
+  • steps each symbol, stopping at the first error
+  • reports if the final state is accepting
+*/
+INTERP_STATUS runChart(Interpreter *interp, const FlatChart *flat, unsigned int *input, unsigned int input_length) {
+  for (unsigned int i = 0; i < input_length; i++) {
+    INTERP_STATUS status = stepChart(interp, flat, input[i]);
+    if (status != INTERP_OK)
+      return status;
+  }
+
+  if (interp->current_state->type == ACCEPT_STATE)
+    return INTERP_ACCEPT;
+  return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Resolve Leaf
+Actions:
+  • follows initial children down from the node to a leaf
+  • returns CHART_NO_NODE if a parent on the way has no initial child
+*/
+static unsigned int resolveLeaf(const Chart *chart, const unsigned char *has_child, unsigned int node) {
+  while (has_child[node]) {
+    node = chart->initial[node];
+    if (node == CHART_NO_NODE)
+      return CHART_NO_NODE;
+  }
+  return node;
+}
+
+
+/*
+Find Domain
+Actions:
+  • finds the nearest node containing both the source and target
+  • moves out one more level if that is the source or target itself, so both are exited and entered
+*/
+static unsigned int findDomain(const Chart *chart, const unsigned int *depth, unsigned int source,
+                               unsigned int target) {
+  unsigned int a = source, b = target;
+  while (depth[a] > depth[b])
+    a = chart->parent[a];
+  while (depth[b] > depth[a])
+    b = chart->parent[b];
+  while (a != b) {
+    a = chart->parent[a];
+    b = chart->parent[b];
+    if (a == CHART_NO_NODE)
+      return CHART_NO_NODE;
+  }
+
+  if (a == source || a == target)
+    return chart->parent[a];
+  return a;
+}
+
+
+/*
+Append Action
+Actions:
+  • appends a non null action, doubling the list when full
+*/
+static int appendAction(ActionList *list, void (*action)(void)) {
+  if (action == NULL)
+    return 1;
+
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    void (**actions)(void) = realloc(list->actions, capacity * sizeof(void (*)(void)));
+    if (actions == NULL)
+      return 0;
+    list->actions = actions;
+    list->capacity = capacity;
+  }
+  list->actions[list->count++] = action;
+  return 1;
+}
+
+
+/*
+Append Exits
+Actions:
+  • appends the exit actions from the leaf outwards, stopping before the domain
+*/
+static int appendExits(ActionList *list, const Chart *chart, unsigned int leaf, unsigned int domain) {
+  for (unsigned int n = leaf; n != domain; n = chart->parent[n])
+    if (!appendAction(list, chart->exit[n]))
+      return 0;
+  return 1;
+}
+
+
+/*
+Append Entries
+Actions:
+  • appends the entry actions from just inside the domain down to the leaf
+*/
+static int appendEntries(ActionList *list, const Chart *chart, unsigned int leaf, unsigned int domain) {
+  size_t begin = list->count;
+  for (unsigned int n = leaf; n != domain; n = chart->parent[n])
+    if (!appendAction(list, chart->entry[n]))
+      return 0;
+
+  // collected inside out, entered outside in
+  for (size_t i = begin, j = list->count; i + 1 < j; i++, j--) {
+    void (*temp)(void) = list->actions[i];
+    list->actions[i] = list->actions[j - 1];
+    list->actions[j - 1] = temp;
+  }
+  return 1;
+}
+
+
+/*
+Run Actions
+Actions:
+  • calls each action of a sequence in order
+*/
+static void runActions(const FlatChart *flat, size_t sequence) {
+  for (size_t i = flat->first[sequence]; i < flat->first[sequence + 1]; i++)
+    flat->actions[i]();
+}
@@ -0,0 +1,253 @@
+// Author: Kevin Imlay
+
+/*
+Charts are hierarchical machines: states may be nested in a parent state, each state may have an entry
+and an exit action, and a transition out of a parent state is taken from every state nested in it unless
+a state further in has its own transition on the same symbol. A transition into a parent state enters
+its initial child, and that child's initial child, down to a state with no children.
+
+A chart is not run directly. flattenChart() compiles it into a plain FSM with one state per leaf of the
+chart, plus the sequence of exit and entry actions each transition performs, so running a chart costs one
+table lookup per symbol and the actions it calls, with no walking of the hierarchy.
+
+Transitions are external: a transition leaves every state up to, but not including, the nearest state
+containing both its source and its target, so a transition from a state to itself or to one of its own
+children exits and re-enters the source.
+*/
+
+#ifndef CHART_H
+#define CHART_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Marker for no state, the parent of a top level state and the target of an unset transition.
+*/
+#define CHART_NO_NODE 0xFFFFFFFFu
+
+
+/* ----- Structures ----- */
+
+/*
+Hierarchical machine, before flattening.
+*/
+typedef struct {
+  // count of states (nodes) and symbols
+  unsigned int node_count;
+  unsigned int symbol_count;
+
+  // parent and initial child of each node, or CHART_NO_NODE
+  unsigned int *parent;
+  unsigned int *initial;
+
+  // entry and exit action of each node, may be null
+  void (**entry)(void);
+  void (**exit)(void);
+
+  // designation of each node, only START_STATE and ACCEPT_STATE are meaningful on leaves
+  STATE_TYPE *type;
+
+  // node_count * symbol_count transition targets, or CHART_NO_NODE
+  unsigned int *trans;
+
+  // node the chart starts in, or CHART_NO_NODE
+  unsigned int start;
+
+} Chart;
+
+
+/*
+Chart flattened into a machine over its leaves.
+*/
+typedef struct {
+  FSM fsm;
+
+  // chart node of each flat state, and flat state of each node, or CHART_NO_NODE for parents
+  unsigned int *state_node;
+  unsigned int *node_state;
+
+  // actions of transition (state * Ec + symbol) are actions[first[i]] to actions[first[i + 1] - 1], the
+  // entry actions of the start state are at index Qc * Ec
+  size_t *first;
+  void (**actions)(void);
+
+} FlatChart;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Chart
+Allocates a chart with every node at the top level, without actions or transitions.
+
+Arguments:
+  • chart - pointer to the chart to initialize.
+  • node_count - unsigned integer count of nodes.
+  • symbol_count - unsigned integer count of symbols.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if either count is 0 or the sizes are too large.
+  • FSM_NO_MACHINE - the chart pointer provided was null.
+*/
+FSM_STATUS initChart(Chart *chart, unsigned int node_count, unsigned int symbol_count);
+
+
+/*
+Free Chart
+Releases the memory held by a chart.
+
+Arguments:
+  • chart - pointer to the chart.
+      Note: may be null.
+*/
+void freeChart(Chart *chart);
+
+
+/*
+Configure Node
+Sets the parent, designation and actions of a node.
+
+Arguments:
+  • chart - pointer to the chart.
+  • node_id - unsigned integer ID of the node.
+  • parent_id - unsigned integer ID of the parent, or CHART_NO_NODE for the top level.
+  • designation - designation of the node.
+      Note: a START_STATE node is where the chart starts, it may be a parent, entering its initial child.
+  • entry - action run when the node is entered, may be null.
+  • exit - action run when the node is left, may be null.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if either node ID is not in the chart.
+  • FSM_SIZE_ERR - if the parent is the node or nested in it.
+  • FSM_NO_MACHINE - the chart pointer provided was null or the chart is not initialized.
+*/
+FSM_STATUS confNode(Chart *chart, unsigned int node_id, unsigned int parent_id, STATE_TYPE designation,
+                    void (*entry)(void), void (*exit)(void));
+
+
+/*
+Set Initial
+Sets the child a parent node enters when it is the target of a transition.
+
+Arguments:
+  • chart - pointer to the chart.
+  • node_id - unsigned integer ID of the parent.
+  • child_id - unsigned integer ID of the child.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if either node ID is not in the chart, or the child's parent is not the node.
+  • FSM_NO_MACHINE - the chart pointer provided was null or the chart is not initialized.
+*/
+FSM_STATUS setInitial(Chart *chart, unsigned int node_id, unsigned int child_id);
+
+
+/*
+Add Chart Transition
+Adds a transition to a chart, taken from the node and every node nested in it that does not have its own
+transition on the symbol.
+
+Arguments:
+  • chart - pointer to the chart.
+  • from_node_id - unsigned integer ID of the node the transition is from.
+  • to_node_id - unsigned integer ID of the node the transition is to.
+  • symbol - unsigned integer symbol of the transition.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if either node ID is not in the chart.
+  • FSM_SIZE_ERR - if the symbol is larger than the number of symbols set in the chart.
+  • FSM_NO_MACHINE - the chart pointer provided was null or the chart is not initialized.
+*/
+FSM_STATUS addChartTrans(Chart *chart, unsigned int from_node_id, unsigned int to_node_id, unsigned int symbol);
+
+
+/*
+Flatten Chart
+Compiles a chart into a machine with one state per leaf node, and the exit and entry actions of every
+transition.
+
+Arguments:
+  • chart - pointer to the chart.
+  • flat - pointer to the flattened chart to initialize.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_STATE - if the chart has no start node, or a parent that is entered has no initial child.
+  • FSM_NO_MACHINE - either pointer provided was null or the chart is not initialized.
+*/
+FSM_STATUS flattenChart(Chart *chart, FlatChart *flat);
+
+
+/*
+Free Flat Chart
+Releases the memory held by a flattened chart, including its machine.
+
+Arguments:
+  • flat - pointer to the flattened chart.
+      Note: may be null.
+*/
+void freeFlatChart(FlatChart *flat);
+
+
+/*
+Initialize Chart Interpreter
+Initializes an interpreter on a flattened chart, and runs the entry actions of the start state, from the
+top level down.
+
+Arguments:
+  • interp - pointer to the interpreter to be initialized.
+  • flat - pointer to the flattened chart.
+
+Returns:
+  • same as initInterpreter().
+*/
+INTERP_STATUS initChartInterpreter(Interpreter *interp, FlatChart *flat);
+
+
+/*
+Step Chart
+Inputs a symbol to an interpreter on a flattened chart, running the exit and entry actions of the
+transition.
+
+Arguments:
+  • interp - pointer to an interpreter initialized with initChartInterpreter().
+  • flat - pointer to the flattened chart.
+  • symbol - unsigned integer symbol.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_SYMB_ERR - if the symbol provided is invalid.
+  • INTERP_TRANS_ERR - if no node containing the current state has a transition on the symbol.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+*/
+INTERP_STATUS stepChart(Interpreter *interp, const FlatChart *flat, unsigned int symbol);
+
+
+/*
+Run Chart
+Inputs each symbol of an input sequence to an interpreter on a flattened chart.
+
+Arguments:
+  • interp - pointer to an interpreter initialized with initChartInterpreter().
+  • flat - pointer to the flattened chart.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+
+Returns:
+  • INTERP_ACCEPT - if the input ends in an accepting state.
+  • INTERP_NO_ACCEPT - if the input ends in a state that is not accepting.
+  • same as stepChart() on an error, stopping at the symbol.
+*/
+INTERP_STATUS runChart(Interpreter *interp, const FlatChart *flat, unsigned int *input, unsigned int input_length);
+
+#endif
@@ -0,0 +1,199 @@
+// Author: Kevin Imlay
+
+#include "checkpoint.h"
+
+/* ----- Private Function Prototypes ----- */
+
+static void matchFrom(const FSM *fsm, State *state, const unsigned int *input, size_t input_length,
+                      Checkpoint *accept);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Save Interpreter
+Actions:
+  • copies the current state and position
+*/
+void saveInterpreter(const Interpreter *interp, Checkpoint *checkpoint) {
+  checkpoint->state = interp->current_state;
+  checkpoint->position = interp->position;
+}
+
+
+/*
+Restore Interpreter
+Actions:
+  • copies the state and position back
+*/
+void restoreInterpreter(Interpreter *interp, const Checkpoint *checkpoint) {
+  interp->current_state = checkpoint->state;
+  interp->position = checkpoint->position;
+}
+
+
+/*
+Initialize Checkpoint Stack
+Actions:
+  • clears the count
+*/
+void initCheckpoints(CheckpointStack *stack) {
+  stack->bottom = 0;
+  stack->count = 0;
+}
+
+
+/*
+Push Checkpoint
+Actions:
+  • drops the oldest checkpoint if full, the stack is kept as a ring
+  • saves the interpreter above the latest
+*/
+int pushCheckpoint(CheckpointStack *stack, const Interpreter *interp) {
+  int dropped = 0;
+  if (stack->count == CHECKPOINT_DEPTH) {
+    stack->bottom = (stack->bottom + 1) % CHECKPOINT_DEPTH;
+    stack->count--;
+    dropped = 1;
+  }
+
+  saveInterpreter(interp, &stack->saved[(stack->bottom + stack->count) % CHECKPOINT_DEPTH]);
+  stack->count++;
+  return dropped;
+}
+
+
+/*
+Rollback Interpreter
+Actions:
+  • pops the latest checkpoint and restores it
+*/
+INTERP_STATUS rollbackInterpreter(Interpreter *interp, CheckpointStack *stack) {
+  if (stack->count == 0)
+    return INTERP_NOT_STARTED;
+
+  stack->count--;
+  restoreInterpreter(interp, &stack->saved[(stack->bottom + stack->count) % CHECKPOINT_DEPTH]);
+  return INTERP_OK;
+}
+
+
+/*
+Commit Checkpoint
+Actions:
+  • pops the latest checkpoint
+*/
+INTERP_STATUS commitCheckpoint(CheckpointStack *stack) {
+  if (stack->count == 0)
+    return INTERP_NOT_STARTED;
+
+  stack->count--;
+  return INTERP_OK;
+}
+
+
+/*
+Longest Match
+Actions:
+  • steps the input through the table, without actions, until it cannot go on
+  • remembers the last accepting position in a checkpoint
+  • restores it, so no symbol is stepped twice
+*/
+INTERP_STATUS longestMatch(Interpreter *interp, const unsigned int *input, size_t input_length,
+                           size_t *match_length) {
+  // validate inputs
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL)
+    return INTERP_NO_MACHINE;
+
+  // last accepting position, the current one if it is accepting
+  Checkpoint accept = {NULL, interp->position};
+  if (interp->current_state->type == ACCEPT_STATE)
+    saveInterpreter(interp, &accept);
+  matchFrom(interp->fsm, interp->current_state, input, input_length, &accept);
+
+  if (accept.state == NULL)
+    return INTERP_NO_ACCEPT;
+
+  // rewind to the last accept
+  *match_length = accept.position - interp->position;
+  restoreInterpreter(interp, &accept);
+  return INTERP_ACCEPT;
+}
+
+
+/*
+Munch Tokens
+Actions:
+  • takes the longest match from the start state over and over, recording where each ends
+  • stops when no non empty prefix is accepted, the arrays are full, or the input is done
+*/
+INTERP_STATUS munchTokens(FSM *fsm, const unsigned int *input, size_t input_length, size_t *token_ends,
+                          unsigned int *token_states, size_t capacity, size_t *token_count, size_t *consumed) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return INTERP_NO_MACHINE;
+  if (fsm->Qs == NULL)
+    return INTERP_MACHINE_NO_START;
+
+  INTERP_STATUS status = INTERP_ACCEPT;
+  size_t position = 0, count = 0;
+  while (position < input_length) {
+    if (count == capacity) {
+      status = INTERP_OK;
+      break;
+    }
+
+    Checkpoint accept = {NULL, position};
+    matchFrom(fsm, fsm->Qs, &input[position], input_length - position, &accept);
+    if (accept.state == NULL) {
+      status = INTERP_NO_ACCEPT;
+      break;
+    }
+
+    position = accept.position;
+    token_ends[count] = position;
+    token_states[count] = accept.state->id;
+    count++;
+  }
+
+  *token_count = count;
+  *consumed = position;
+  return status;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Match From
+Actions:
+  • steps the input from a state until the end, an invalid symbol, a missing transition or the sink
+  • moves the checkpoint to each accepting state entered, offset from its position
+*/
+static void matchFrom(const FSM *fsm, State *state, const unsigned int *input, size_t input_length,
+                      Checkpoint *accept) {
+  State **table = fsm->D;
+  size_t symbol_count = fsm->Ec;
+  State *sink = fsm->Qsink;
+  State *accept_state = NULL;
+  size_t accept_length = 0;
+
+  for (size_t i = 0; i < input_length; i++) {
+    if (input[i] >= symbol_count)
+      break;
+    state = table[state->id * symbol_count + input[i]];
+    if (state == NULL || state == sink)
+      break;
+    if (state->type == ACCEPT_STATE) {
+      accept_state = state;
+      accept_length = i + 1;
+    }
+  }
+
+  if (accept_state != NULL) {
+    accept->state = accept_state;
+    accept->position += accept_length;
+  }
+}
@@ -0,0 +1,179 @@
+// Author: Kevin Imlay
+
+/*
+Checkpoints save where an interpreter is, its state and position, so it can be put back there without
+running the input again. Saving and restoring copy two words. A checkpoint stack holds the latest
+CHECKPOINT_DEPTH checkpoints of an interpreter, for backing up over nested attempts.
+
+Maximal munch finds the longest prefix of an input the machine accepts, as a tokenizer does: the input
+is stepped until the machine cannot go on, remembering the last accepting position in a checkpoint, and
+the interpreter is then rewound to it. munchTokens() splits a whole input this way in one call.
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Checkpoints held by a checkpoint stack.
+*/
+#define CHECKPOINT_DEPTH 16
+
+
+/* ----- Structures ----- */
+
+/*
+Saved state and position of an interpreter.
+*/
+typedef struct {
+  State *state;
+  size_t position;
+} Checkpoint;
+
+
+/*
+Fixed size stack of checkpoints, the oldest is dropped when a push finds it full.
+*/
+typedef struct {
+  Checkpoint saved[CHECKPOINT_DEPTH];
+
+  // index of the oldest checkpoint, and count held
+  unsigned int bottom;
+  unsigned int count;
+
+} CheckpointStack;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Save Interpreter
+Saves the state and position of an interpreter.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • checkpoint - [pass back] the checkpoint.
+*/
+void saveInterpreter(const Interpreter *interp, Checkpoint *checkpoint);
+
+
+/*
+Restore Interpreter
+Puts an interpreter back to a checkpoint. No actions are run.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • checkpoint - pointer to a checkpoint saved from the interpreter.
+*/
+void restoreInterpreter(Interpreter *interp, const Checkpoint *checkpoint);
+
+
+/*
+Initialize Checkpoint Stack
+Empties a checkpoint stack.
+
+Arguments:
+  • stack - pointer to the stack.
+*/
+void initCheckpoints(CheckpointStack *stack);
+
+
+/*
+Push Checkpoint
+Saves the interpreter onto the stack.
+
+Arguments:
+  • stack - pointer to the stack.
+  • interp - pointer to the interpreter.
+
+Returns:
+  • 1 - if the stack was full and its oldest checkpoint was dropped.
+  • 0 - otherwise.
+*/
+int pushCheckpoint(CheckpointStack *stack, const Interpreter *interp);
+
+
+/*
+Rollback Interpreter
+Pops the latest checkpoint off the stack and restores the interpreter to it.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • stack - pointer to the stack.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_NOT_STARTED - if the stack is empty, the interpreter is not changed.
+*/
+INTERP_STATUS rollbackInterpreter(Interpreter *interp, CheckpointStack *stack);
+
+
+/*
+Commit Checkpoint
+Pops the latest checkpoint off the stack without restoring it, keeping the input since.
+
+Arguments:
+  • stack - pointer to the stack.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_NOT_STARTED - if the stack is empty.
+*/
+INTERP_STATUS commitCheckpoint(CheckpointStack *stack);
+
+
+/*
+Longest Match
+Steps the input from the interpreter's current state until the end, an invalid symbol, a missing
+transition, or the machine's sink state, and rewinds the interpreter to the last accepting position.
+No actions are run. The current state counts as a match of length 0 if it is accepting.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - length of the input array.
+  • match_length - [pass back] count of symbols in the longest accepted prefix.
+      Note: only written when INTERP_ACCEPT is returned.
+
+Returns:
+  • INTERP_ACCEPT - if a prefix is accepted, the interpreter is left after it.
+  • INTERP_NO_ACCEPT - if no prefix is accepted, the interpreter is left where it was.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null (not initialized).
+*/
+INTERP_STATUS longestMatch(Interpreter *interp, const unsigned int *input, size_t input_length,
+                           size_t *match_length);
+
+
+/*
+Munch Tokens
+Splits an input into tokens from the machine's start state, each the longest accepted prefix of the rest
+of the input, as longestMatch() finds. No actions are run.
+
+Arguments:
+  • fsm - pointer to the fsm.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - length of the input array.
+  • token_ends - [pass back] array of the offset in the input just past each token.
+  • token_states - [pass back] array of the ID of the accepting state each token ends in.
+  • capacity - length of the token arrays.
+  • token_count - [pass back] count of tokens found.
+  • consumed - [pass back] count of symbols covered by the tokens found, where to continue from.
+
+Returns:
+  • INTERP_ACCEPT - if the whole input was split into tokens.
+  • INTERP_NO_ACCEPT - if no prefix of the input after the last token is accepted, or only an empty one.
+  • INTERP_OK - if the token arrays filled up first.
+  • INTERP_NO_MACHINE - if the machine is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS munchTokens(FSM *fsm, const unsigned int *input, size_t input_length, size_t *token_ends,
+                          unsigned int *token_states, size_t capacity, size_t *token_count, size_t *consumed);
+
+#endif
@@ -0,0 +1,293 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+
+#include "comb.h"
+
+/* ----- Private Definitions ----- */
+
+/*
+Probes a row may take before the search floor is raised past the holes that failed it.
+*/
+#define COMB_MAX_PROBES 64
+
+
+/* ----- Private Function Prototypes ----- */
+
+static int growComb(CombTable *comb, size_t **skip, size_t *capacity, size_t needed);
+static size_t findFree(size_t *skip, size_t slot);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Comb Table
+Actions:
+  • count the transitions of each row and order the rows densest first
+  • place each row at the lowest base where all its slots are free, trying only bases that put its
+      first transition in a free slot
+  • raise the floor the search starts at when the holes low in the arrays take too many probes
+  • trim the shared arrays to the slots used, keeping room for a lookup on any symbol from any base
+*/
+FSM_STATUS initCombTable(CombTable *comb, FSM *fsm) {
+  // validate inputs
+  if (comb == NULL || fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+
+  unsigned int state_count = fsm->Qc;
+  unsigned int symbol_count = fsm->Ec;
+
+  // allocate
+  unsigned int *row_count = calloc(state_count, sizeof(unsigned int));
+  unsigned int *order = malloc(state_count * sizeof(unsigned int));
+  size_t *bucket = calloc((size_t)symbol_count + 2, sizeof(size_t));
+  unsigned int *symbols = malloc(symbol_count * sizeof(unsigned int));
+  comb->base = malloc(state_count * sizeof(size_t));
+  comb->accept = calloc(((size_t)state_count + 63) / 64, sizeof(unsigned long long));
+  comb->next = NULL;
+  comb->check = NULL;
+  size_t capacity = 0;
+  if (row_count == NULL || order == NULL || bucket == NULL || symbols == NULL || comb->base == NULL ||
+      comb->accept == NULL) {
+    free(row_count);
+    free(order);
+    free(bucket);
+    free(symbols);
+    freeCombTable(comb);
+    return FSM_ALLOC_ERR;
+  }
+
+  // count transitions of each row
+  size_t transitions = 0;
+  for (unsigned int state = 0; state < state_count; state++) {
+    State **row = &fsm->D[(size_t)state * symbol_count];
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+      if (row[symbol] != NULL)
+        row_count[state]++;
+    transitions += row_count[state];
+  }
+
+  // densest rows first, by counting sort so equal rows keep their order
+  for (unsigned int state = 0; state < state_count; state++)
+    bucket[symbol_count - row_count[state] + 1]++;
+  for (unsigned int i = 1; i <= symbol_count + 1; i++)
+    bucket[i] += bucket[i - 1];
+  for (unsigned int state = 0; state < state_count; state++)
+    order[bucket[symbol_count - row_count[state]]++] = state;
+
+  // pack rows, skip[] leads from any slot to the first free slot at or after it
+  size_t *skip = NULL;
+  size_t probed[COMB_MAX_PROBES];
+  size_t search_floor = 0;
+  size_t used = symbol_count;
+  int ok = growComb(comb, &skip, &capacity, transitions + 2 * (size_t)symbol_count);
+  for (unsigned int i = 0; ok && i < state_count; i++) {
+    unsigned int state = order[i];
+    State **row = &fsm->D[(size_t)state * symbol_count];
+
+    // empty rows never match a slot's owner, so any base will do
+    comb->base[state] = 0;
+    if (row_count[state] == 0)
+      continue;
+
+    unsigned int n = 0;
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++)
+      if (row[symbol] != NULL)
+        symbols[n++] = symbol;
+
+    // try bases that put the first transition in a free slot, from the search search_floor up
+    size_t slot = findFree(skip, (search_floor > symbols[0]) ? search_floor : symbols[0]);
+    unsigned int probes = 0;
+    for (;;) {
+      if (!growComb(comb, &skip, &capacity, slot - symbols[0] + 2 * (size_t)symbol_count)) {
+        ok = 0;
+        break;
+      }
+      unsigned int k = 1;
+      while (k < n && comb->check[slot - symbols[0] + symbols[k]] == TABLE_NO_STATE)
+        k++;
+      if (k == n)
+        break;
+      probed[probes++ % COMB_MAX_PROBES] = slot;
+      slot = findFree(skip, slot + 1);
+    }
+    if (!ok)
+      break;
+    size_t base = slot - symbols[0];
+
+    // holes below the last few probes are too small for the rows still to come
+    if (probes > COMB_MAX_PROBES)
+      search_floor = probed[probes % COMB_MAX_PROBES];
+
+    // place row
+    ok = growComb(comb, &skip, &capacity, base + 2 * (size_t)symbol_count);
+    if (!ok)
+      break;
+    comb->base[state] = base;
+    for (unsigned int k = 0; k < n; k++) {
+      comb->check[base + symbols[k]] = state;
+      comb->next[base + symbols[k]] = row[symbols[k]]->id;
+      skip[base + symbols[k]] = base + symbols[k] + 1;
+    }
+    if (base + symbol_count > used)
+      used = base + symbol_count;
+  }
+  free(skip);
+  if (!ok) {
+    free(row_count);
+    free(order);
+    free(bucket);
+    free(symbols);
+    freeCombTable(comb);
+    return FSM_ALLOC_ERR;
+  }
+
+  // trim
+  unsigned int *next = realloc(comb->next, used * sizeof(unsigned int));
+  unsigned int *check = realloc(comb->check, used * sizeof(unsigned int));
+  if (next != NULL)
+    comb->next = next;
+  if (check != NULL)
+    comb->check = check;
+
+  // accepting and start states
+  for (unsigned int state = 0; state < state_count; state++)
+    if (fsm->Q[state].type == ACCEPT_STATE)
+      comb->accept[state >> 6] |= 1ULL << (state & 63);
+
+  comb->Qc = state_count;
+  comb->Ec = symbol_count;
+  comb->size = used;
+  comb->transitions = transitions;
+  comb->start = (fsm->Qs == NULL) ? TABLE_NO_STATE : fsm->Qs->id;
+
+  free(row_count);
+  free(order);
+  free(bucket);
+  free(symbols);
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Comb Table
+Actions:
+  • free the bases, shared arrays and accepting bitmap
+*/
+void freeCombTable(CombTable *comb) {
+  if (comb == NULL)
+    return;
+
+  free(comb->base);
+  free(comb->next);
+  free(comb->check);
+  free(comb->accept);
+  comb->base = NULL;
+  comb->next = NULL;
+  comb->check = NULL;
+  comb->accept = NULL;
+  comb->size = 0;
+}
+
+
+/*
+Comb Fill Ratio
+Actions:
+  • transitions over slots
+*/
+double combFillRatio(const CombTable *comb) {
+  if (comb == NULL || comb->size == 0)
+    return 0.0;
+  return (double)comb->transitions / (double)comb->size;
+}
+
+
+/*
+Recognize Comb
+Actions:
+  • walk the comb table from the start state
+  • check the accepting bitmap for the final state
+*/
+INTERP_STATUS recognizeComb(const CombTable *comb, const unsigned int *input, unsigned int input_length) {
+  // validate inputs
+  if (comb == NULL || comb->check == NULL)
+    return INTERP_NO_MACHINE;
+  if (comb->start == TABLE_NO_STATE)
+    return INTERP_MACHINE_NO_START;
+
+  unsigned int state = comb->start;
+  for (unsigned int i = 0; i < input_length; i++) {
+    if (input[i] >= comb->Ec)
+      return INTERP_SYMB_ERR;
+    state = combNext(comb, state, input[i]);
+    if (state == TABLE_NO_STATE)
+      return INTERP_TRANS_ERR;
+  }
+
+  // check accept state
+  if ((comb->accept[state >> 6] >> (state & 63)) & 1)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Grow Comb
+Actions:
+  • doubles the shared arrays until they hold at least the slots needed
+  • marks new slots as free
+*/
+static int growComb(CombTable *comb, size_t **skip, size_t *capacity, size_t needed) {
+  if (needed <= *capacity)
+    return 1;
+
+  size_t new_capacity = (*capacity > 0) ? *capacity : 64;
+  while (new_capacity < needed)
+    new_capacity *= 2;
+
+  unsigned int *next = realloc(comb->next, new_capacity * sizeof(unsigned int));
+  if (next == NULL)
+    return 0;
+  comb->next = next;
+  unsigned int *check = realloc(comb->check, new_capacity * sizeof(unsigned int));
+  if (check == NULL)
+    return 0;
+  comb->check = check;
+  size_t *new_skip = realloc(*skip, (new_capacity + 1) * sizeof(size_t));
+  if (new_skip == NULL)
+    return 0;
+  *skip = new_skip;
+
+  for (size_t i = *capacity; i < new_capacity; i++) {
+    comb->check[i] = TABLE_NO_STATE;
+    (*skip)[i] = i;
+  }
+  (*skip)[new_capacity] = new_capacity;
+  *capacity = new_capacity;
+  return 1;
+}
+
+
+/*
+Find Free
+Actions:
+  • follows skip links to the first free slot at or after a slot, a free slot links to itself
+  • shortens the links on the way, so repeated searches stay cheap
+*/
+static size_t findFree(size_t *skip, size_t slot) {
+  size_t free_slot = slot;
+  while (skip[free_slot] != free_slot)
+    free_slot = skip[free_slot];
+
+  while (skip[slot] != free_slot) {
+    size_t next = skip[slot];
+    skip[slot] = free_slot;
+    slot = next;
+  }
+  return free_slot;
+}
@@ -0,0 +1,141 @@
+// Author: Kevin Imlay
+
+/*
+The comb table is a compressed transition table for large, sparse machines, using row displacement
+(also known as a comb vector or double array). The rows of the dense table are overlaid into one shared
+pair of arrays, each row shifted by its own base offset so that its transitions fall into slots no other
+row uses:
+  • next[base[state] + symbol] - the state transitioned to,
+  • check[base[state] + symbol] - the state that owns the slot.
+A lookup reads the slot and checks its owner, so it stays two array reads, while the memory used is
+close to the number of transitions in the machine rather than Qc * Ec.
+
+Like the state table, the comb table is a snapshot of the FSM it was built from.
+*/
+
+#ifndef COMB_H
+#define COMB_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Structures ----- */
+
+/*
+Row displacement transition table.
+*/
+typedef struct {
+  // count of states in the machine
+  unsigned int Qc;
+
+  // count of input alphabet symbols
+  unsigned int Ec;
+
+  // offset of each state's row into the shared arrays
+  size_t *base;
+
+  // state transitioned to in each slot
+  unsigned int *next;
+
+  // state that owns each slot, or TABLE_NO_STATE
+  unsigned int *check;
+
+  // count of slots in the shared arrays
+  size_t size;
+
+  // count of transitions packed
+  size_t transitions;
+
+  // bitmap of accepting states, one bit per state ID
+  unsigned long long *accept;
+
+  // ID of the starting state
+  unsigned int start;
+
+} CombTable;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Comb Table
+Packs the transitions of a FSM into a comb table.
+Rows are packed densest first, each at the lowest base where all of its transitions fit.
+
+Arguments:
+  • comb - pointer to the comb table to initialize.
+  • fsm - pointer to an initialized FSM.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either the table or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initCombTable(CombTable *comb, FSM *fsm);
+
+
+/*
+Free Comb Table
+Releases the memory held by a comb table.
+
+Arguments:
+  • comb - pointer to the comb table.
+      Note: may be null.
+*/
+void freeCombTable(CombTable *comb);
+
+
+/*
+Comb Fill Ratio
+Fraction of the slots of the shared arrays that hold a transition.
+
+Arguments:
+  • comb - pointer to the comb table.
+
+Returns:
+  • the fill ratio, between 0 and 1.
+*/
+double combFillRatio(const CombTable *comb);
+
+
+/*
+Comb Next
+Looks up the state transitioned to from a state on a symbol.
+
+Arguments:
+  • comb - pointer to the comb table.
+  • state_id - ID of the state, must be less than the table's state count.
+  • symbol - symbol, must be less than the table's symbol count.
+
+Returns:
+  • ID of the state transitioned to, or TABLE_NO_STATE if there is no transition.
+*/
+static inline unsigned int combNext(const CombTable *comb, unsigned int state_id, unsigned int symbol) {
+  size_t slot = comb->base[state_id] + symbol;
+  return (comb->check[slot] == state_id) ? comb->next[slot] : TABLE_NO_STATE;
+}
+
+
+/*
+Recognize Comb
+Runs the input from the machine's start state without running any actions, the same as
+recognizeInput() on a state table.
+
+Arguments:
+  • comb - pointer to the comb table.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+  • INTERP_NO_MACHINE - if the table provided is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS recognizeComb(const CombTable *comb, const unsigned int *input, unsigned int input_length);
+
+#endif
@@ -0,0 +1,596 @@
+// Author: Kevin Imlay
+
+/*
+Corpus scanner: runs one serialized machine over many files, each byte of a file one symbol, and prints
+a line per file with its result, then totals and throughput to stderr.
+
+Usage:
+  corpus_scan [-j threads] [-l list] [-r] machine path...
+    • -j threads - threads scanning files, 0 or not given for one per online CPU.
+    • -l list - file of paths to scan, one per line, "-" for stdin, added to the paths given.
+    • -r - read files with read() instead of mapping them.
+    • machine - machine written by saveMachine().
+    • path - file to scan, or directory to scan every regular file under.
+
+Each result line is tab separated: the result, the offset of the first byte after which the machine was
+in an accepting state, or "-" if it never was, the bytes scanned, and the path. The result is "accept" or
+"reject", "symbol-error@offset" or "transition-error@offset", or "read-error" with the reason. Lines are
+printed in the order the paths were listed.
+
+Files are mapped SCAN_WINDOW bytes at a time, and read into a SCAN_BUFFER byte buffer per thread when they
+cannot be mapped, are not regular files, or -r is given, so the memory used for file contents does not
+grow with the size or number of files. A file stops being read once the machine enters a state every
+symbol loops on, as the result cannot change.
+*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "interpreter.h"
+#include "serial.h"
+#include "table.h"
+
+/* ----- Definitions ----- */
+
+/*
+Bytes of a file mapped at a time, a multiple of the page size.
+*/
+#define SCAN_WINDOW ((size_t)16 << 20)
+
+/*
+Bytes of a file read at a time when it is not mapped.
+*/
+#define SCAN_BUFFER ((size_t)1 << 20)
+
+/*
+Bytes stepped between checks for a state every symbol loops on.
+*/
+#define SCAN_CHECK 4096
+
+/*
+Offset of a first match that has not happened.
+*/
+#define SCAN_NO_MATCH ((unsigned long long)-1)
+
+/*
+Most file descriptors the directory walk holds open.
+*/
+#define SCAN_WALK_FDS 32
+
+
+/* ----- Structures ----- */
+
+/*
+Machine as the scanner walks it.
+*/
+typedef struct {
+  StateTable table;
+
+  // per state, whether it accepts and whether every symbol loops on it
+  unsigned char *accepting;
+  unsigned char *absorbing;
+
+} ScanMachine;
+
+
+/*
+Result of scanning a file, and its progress while it is scanned.
+*/
+typedef struct {
+  INTERP_STATUS status;
+  unsigned int state;
+
+  // bytes stepped, and after how many the machine first accepted
+  unsigned long long bytes;
+  unsigned long long first_match;
+
+  // set if the file could not be read, with the errno of the error, 0 if none
+  int read_failed;
+  int error;
+
+  // set once the result cannot change
+  int decided;
+
+} FileResult;
+
+
+/*
+Paths to scan.
+*/
+typedef struct {
+  char **paths;
+  size_t count;
+  size_t capacity;
+} PathList;
+
+
+/*
+Work shared by the scanning threads.
+*/
+typedef struct {
+  const ScanMachine *machine;
+  const PathList *list;
+  FileResult *results;
+  int use_read;
+
+  // index of the next path to scan
+  atomic_size_t next;
+
+} ScanJob;
+
+
+/* ----- Private Variables ----- */
+
+// list the directory walk adds to
+static PathList *walk_list = NULL;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static int initScanMachine(ScanMachine *machine, FSM *fsm);
+static void freeScanMachine(ScanMachine *machine);
+static void stepBytes(const ScanMachine *machine, FileResult *result, const unsigned char *bytes, size_t length);
+static void scanFile(const ScanMachine *machine, const char *path, int use_read, unsigned char *buffer,
+                     FileResult *result);
+static void readFile(const ScanMachine *machine, int fd, unsigned char *buffer, FileResult *result);
+static void *scanWorker(void *argument);
+static int addPath(PathList *list, const char *path);
+static int addWalked(const char *path, const struct stat *info, int type, struct FTW *walk);
+static int addListed(PathList *list, const char *list_path);
+static void printResult(const char *path, const FileResult *result);
+static double nowSeconds(void);
+
+
+/* ----- Main ----- */
+
+int main(int argc, char *argv[]) {
+  unsigned int thread_count = 0;
+  int use_read = 0;
+  PathList list = {NULL, 0, 0};
+
+  // options
+  int option;
+  while ((option = getopt(argc, argv, "j:l:r")) != -1) {
+    if (option == 'j') {
+      thread_count = (unsigned int)strtoul(optarg, NULL, 10);
+    } else if (option == 'l') {
+      if (!addListed(&list, optarg)) {
+        fprintf(stderr, "corpus_scan: cannot read list %s: %s\n", optarg, strerror(errno));
+        return 2;
+      }
+    } else if (option == 'r') {
+      use_read = 1;
+    } else {
+      fprintf(stderr, "usage: corpus_scan [-j threads] [-l list] [-r] machine path...\n");
+      return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: corpus_scan [-j threads] [-l list] [-r] machine path...\n");
+    return 2;
+  }
+
+  // machine
+  FSM fsm;
+  FSM_STATUS loaded = loadMachine(&fsm, argv[optind]);
+  if (loaded != FSM_OK) {
+    fprintf(stderr, "corpus_scan: cannot load machine %s (status %d)\n", argv[optind], loaded);
+    return 2;
+  }
+  if (fsm.Qs == NULL) {
+    fprintf(stderr, "corpus_scan: machine %s has no start state\n", argv[optind]);
+    return 2;
+  }
+  ScanMachine machine;
+  if (!initScanMachine(&machine, &fsm)) {
+    fprintf(stderr, "corpus_scan: out of memory\n");
+    return 2;
+  }
+  freeFSM(&fsm);
+
+  // paths, directories walked for their regular files
+  walk_list = &list;
+  for (int i = optind + 1; i < argc; i++) {
+    struct stat info;
+    if (stat(argv[i], &info) == 0 && S_ISDIR(info.st_mode)) {
+      if (nftw(argv[i], addWalked, SCAN_WALK_FDS, FTW_PHYS) != 0)
+        fprintf(stderr, "corpus_scan: cannot walk %s: %s\n", argv[i], strerror(errno));
+    } else if (!addPath(&list, argv[i])) {
+      fprintf(stderr, "corpus_scan: out of memory\n");
+      return 2;
+    }
+  }
+
+  // scan
+  if (thread_count == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = (online > 0) ? (unsigned int)online : 1;
+  }
+  if (thread_count > list.count && list.count > 0)
+    thread_count = (unsigned int)list.count;
+
+  ScanJob job;
+  job.machine = &machine;
+  job.list = &list;
+  job.results = calloc(list.count ? list.count : 1, sizeof(FileResult));
+  job.use_read = use_read;
+  atomic_init(&job.next, 0);
+  pthread_t *threads = malloc(thread_count * sizeof(pthread_t));
+  if (job.results == NULL || threads == NULL) {
+    fprintf(stderr, "corpus_scan: out of memory\n");
+    return 2;
+  }
+
+  double start = nowSeconds();
+  unsigned int started = 0;
+  for (unsigned int i = 1; i < thread_count; i++)
+    if (pthread_create(&threads[started], NULL, scanWorker, &job) == 0)
+      started++;
+  scanWorker(&job);
+  for (unsigned int i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  double elapsed = nowSeconds() - start;
+
+  // report
+  unsigned long long bytes = 0, accepted = 0, rejected = 0, failed = 0;
+  for (size_t i = 0; i < list.count; i++) {
+    printResult(list.paths[i], &job.results[i]);
+    bytes += job.results[i].bytes;
+    if (job.results[i].read_failed)
+      failed++;
+    else if (job.results[i].status == INTERP_ACCEPT)
+      accepted++;
+    else if (job.results[i].status == INTERP_NO_ACCEPT)
+      rejected++;
+    else
+      failed++;
+  }
+  fprintf(stderr, "%zu files, %llu accepted, %llu rejected, %llu errors\n", list.count, accepted, rejected, failed);
+  fprintf(stderr, "%llu bytes in %.3f s on %u threads, %.1f MB/s\n", bytes, elapsed, started + 1,
+          (elapsed > 0) ? (double)bytes / elapsed / 1e6 : 0.0);
+
+  for (size_t i = 0; i < list.count; i++)
+    free(list.paths[i]);
+  free(list.paths);
+  free(job.results);
+  free(threads);
+  freeScanMachine(&machine);
+  return (failed > 0) ? 1 : 0;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Initialize Scan Machine
+Actions:
+  • freezes the machine into a state table
+  • marks the accepting states, and the states every symbol loops on
+*/
+static int initScanMachine(ScanMachine *machine, FSM *fsm) {
+  if (initStateTable(&machine->table, fsm) != FSM_OK)
+    return 0;
+
+  machine->accepting = malloc(fsm->Qc);
+  machine->absorbing = malloc(fsm->Qc);
+  if (machine->accepting == NULL || machine->absorbing == NULL) {
+    freeScanMachine(machine);
+    return 0;
+  }
+
+  for (unsigned int state = 0; state < fsm->Qc; state++) {
+    machine->accepting[state] = (unsigned char)isAccepting(&machine->table, state);
+    machine->absorbing[state] = 1;
+    for (unsigned int symbol = 0; symbol < fsm->Ec && machine->absorbing[state]; symbol++)
+      machine->absorbing[state] = (machine->table.next[(size_t)state * fsm->Ec + symbol] == state);
+    // bytes past the alphabet are errors, so the state does not absorb them
+    if (fsm->Ec < 256)
+      machine->absorbing[state] = 0;
+  }
+
+  return 1;
+}
+
+
+/*
+Free Scan Machine
+Actions:
+  • frees the state table and per state flags
+*/
+static void freeScanMachine(ScanMachine *machine) {
+  freeStateTable(&machine->table);
+  free(machine->accepting);
+  free(machine->absorbing);
+  machine->accepting = NULL;
+  machine->absorbing = NULL;
+}
+
+
+/*
+Step Bytes
+Actions:
+  • steps each byte checking for an accepting state, until the first is found
+  • then steps blocks of SCAN_CHECK bytes with no check but for errors, stopping after a block that ends
+    in an absorbing state
+  • bytes are not checked against the alphabet when it covers every byte
+*/
+static void stepBytes(const ScanMachine *machine, FileResult *result, const unsigned char *bytes, size_t length) {
+  const unsigned int *next = machine->table.next;
+  size_t symbol_count = machine->table.Ec;
+  int every_byte = (symbol_count >= 256);
+  unsigned int state = result->state;
+  size_t i = 0;
+
+  while (i < length && !result->decided) {
+    size_t end = (length - i > SCAN_CHECK) ? i + SCAN_CHECK : length;
+    size_t stopped = end;
+
+    if (result->first_match == SCAN_NO_MATCH) {
+      for (; i < end; i++) {
+        if (!every_byte && bytes[i] >= symbol_count) {
+          stopped = i;
+          result->status = INTERP_SYMB_ERR;
+          break;
+        }
+        unsigned int to = next[(size_t)state * symbol_count + bytes[i]];
+        if (to == TABLE_NO_STATE) {
+          stopped = i;
+          result->status = INTERP_TRANS_ERR;
+          break;
+        }
+        state = to;
+        if (machine->accepting[state]) {
+          result->first_match = result->bytes + i + 1;
+          i++;
+          break;
+        }
+      }
+    } else if (every_byte) {
+      for (; i < end; i++) {
+        unsigned int to = next[(size_t)state * symbol_count + bytes[i]];
+        if (to == TABLE_NO_STATE) {
+          stopped = i;
+          result->status = INTERP_TRANS_ERR;
+          break;
+        }
+        state = to;
+      }
+    } else {
+      for (; i < end; i++) {
+        unsigned int to = (bytes[i] < symbol_count) ? next[(size_t)state * symbol_count + bytes[i]] : TABLE_NO_STATE;
+        if (to == TABLE_NO_STATE) {
+          stopped = i;
+          result->status = (bytes[i] < symbol_count) ? INTERP_TRANS_ERR : INTERP_SYMB_ERR;
+          break;
+        }
+        state = to;
+      }
+    }
+
+    if (stopped < end) {
+      i = stopped;
+      result->decided = 1;
+    } else if (machine->absorbing[state]) {
+      result->decided = 1;
+    }
+  }
+
+  result->state = state;
+  result->bytes += i;
+}
+
+
+/*
+Scan File
+Actions:
+  • maps a regular file a window at a time, advised for sequential reading, and steps each window
+  • reads the file instead if it is not regular, has no size, as files of the proc file system do, cannot
+    be mapped, or reading was asked for
+  • sets the result from the final state, unless an error decided it
+*/
+static void scanFile(const ScanMachine *machine, const char *path, int use_read, unsigned char *buffer,
+                     FileResult *result) {
+  result->status = INTERP_OK;
+  result->state = machine->table.start;
+  result->bytes = 0;
+  result->first_match = SCAN_NO_MATCH;
+  result->read_failed = 0;
+  result->error = 0;
+  result->decided = 0;
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0) {
+    result->error = errno;
+    result->read_failed = 1;
+    if (fd >= 0)
+      close(fd);
+    return;
+  }
+
+  int mapped = 0;
+  if (!use_read && S_ISREG(info.st_mode) && info.st_size > 0) {
+    mapped = 1;
+    size_t size = (size_t)info.st_size;
+    for (size_t offset = 0; offset < size && !result->decided; offset += SCAN_WINDOW) {
+      size_t window = (size - offset > SCAN_WINDOW) ? SCAN_WINDOW : size - offset;
+      void *bytes = mmap(NULL, window, PROT_READ, MAP_PRIVATE, fd, (off_t)offset);
+      if (bytes == MAP_FAILED) {
+        // read the rest instead
+        if (lseek(fd, (off_t)offset, SEEK_SET) == (off_t)offset)
+          mapped = 0;
+        else
+          result->error = errno;
+        break;
+      }
+      madvise(bytes, window, MADV_SEQUENTIAL);
+      stepBytes(machine, result, bytes, window);
+      munmap(bytes, window);
+    }
+  }
+  if (!mapped && result->error == 0)
+    readFile(machine, fd, buffer, result);
+  close(fd);
+
+  if (result->error != 0)
+    result->read_failed = 1;
+  else if (result->status == INTERP_OK)
+    result->status = machine->accepting[result->state] ? INTERP_ACCEPT : INTERP_NO_ACCEPT;
+}
+
+
+/*
+Read File
+Actions:
+  • reads the file into the buffer a SCAN_BUFFER at a time and steps it, until the end or the result is
+    decided
+*/
+static void readFile(const ScanMachine *machine, int fd, unsigned char *buffer, FileResult *result) {
+  while (!result->decided) {
+    ssize_t count = read(fd, buffer, SCAN_BUFFER);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count < 0)
+      result->error = errno;
+    if (count <= 0)
+      return;
+    stepBytes(machine, result, buffer, (size_t)count);
+  }
+}
+
+
+/*
+Scan Worker
+Actions:
+  • takes the next path off the job and scans it into its result, until none are left
+*/
+static void *scanWorker(void *argument) {
+  ScanJob *job = argument;
+  unsigned char *buffer = malloc(SCAN_BUFFER);
+
+  for (;;) {
+    size_t index = atomic_fetch_add(&job->next, 1);
+    if (index >= job->list->count)
+      break;
+    if (buffer == NULL) {
+      job->results[index].read_failed = 1;
+      job->results[index].error = ENOMEM;
+      continue;
+    }
+    scanFile(job->machine, job->list->paths[index], job->use_read, buffer, &job->results[index]);
+  }
+
+  free(buffer);
+  return NULL;
+}
+
+
+/*
+Add Path
+Actions:
+  • copies the path onto the list, doubling the list when full
+*/
+static int addPath(PathList *list, const char *path) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 256;
+    char **grown = realloc(list->paths, capacity * sizeof(char*));
+    if (grown == NULL)
+      return 0;
+    list->paths = grown;
+    list->capacity = capacity;
+  }
+
+  list->paths[list->count] = strdup(path);
+  if (list->paths[list->count] == NULL)
+    return 0;
+  list->count++;
+  return 1;
+}
+
+
+/*
+Add Walked
+Actions:
+  • adds each regular file the directory walk visits
+*/
+static int addWalked(const char *path, const struct stat *info, int type, struct FTW *walk) {
+  (void)walk;
+  if (type == FTW_F && S_ISREG(info->st_mode))
+    return addPath(walk_list, path) ? 0 : -1;
+  return 0;
+}
+
+
+/*
+Add Listed
+Actions:
+  • adds each line of the list file as a path, skipping empty lines
+*/
+static int addListed(PathList *list, const char *list_path) {
+  FILE *file = (strcmp(list_path, "-") == 0) ? stdin : fopen(list_path, "r");
+  if (file == NULL)
+    return 0;
+
+  char *line = NULL;
+  size_t line_capacity = 0;
+  ssize_t length;
+  int added = 1;
+  while (added && (length = getline(&line, &line_capacity, file)) >= 0) {
+    if (length > 0 && line[length - 1] == '\n')
+      line[--length] = '\0';
+    if (length > 0)
+      added = addPath(list, line);
+  }
+
+  free(line);
+  if (file != stdin)
+    fclose(file);
+  return added;
+}
+
+
+/*
+Print Result
+Actions:
+  • prints the result line of a file
+*/
+static void printResult(const char *path, const FileResult *result) {
+  char first_match[32] = "-";
+  if (result->first_match != SCAN_NO_MATCH)
+    snprintf(first_match, sizeof(first_match), "%llu", result->first_match);
+
+  if (result->read_failed)
+    printf("read-error: %s\t-\t%llu\t%s\n", strerror(result->error), result->bytes, path);
+  else if (result->status == INTERP_ACCEPT)
+    printf("accept\t%s\t%llu\t%s\n", first_match, result->bytes, path);
+  else if (result->status == INTERP_NO_ACCEPT)
+    printf("reject\t%s\t%llu\t%s\n", first_match, result->bytes, path);
+  else if (result->status == INTERP_SYMB_ERR)
+    printf("symbol-error@%llu\t%s\t%llu\t%s\n", result->bytes, first_match, result->bytes, path);
+  else
+    printf("transition-error@%llu\t%s\t%llu\t%s\n", result->bytes, first_match, result->bytes, path);
+}
+
+
+/*
+Now Seconds
+Actions:
+  • reads the monotonic clock
+*/
+static double nowSeconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
@@ -0,0 +1,338 @@
+// Author: Kevin Imlay
+
+#include "counter.h"
+
+/* ----- Private Definitions ----- */
+
+/*
+Symbols compared at once while measuring a run.
+*/
+#define COUNTER_SCAN_BLOCK 8
+
+
+/* ----- Private Function Prototypes ----- */
+
+static int inBounds(const CounterTable *table, const unsigned int *counts, unsigned int state_id);
+static int applyOps(const CounterTable *table, unsigned int *counts, unsigned int from_state_id,
+                    unsigned int to_state_id, unsigned int ops);
+static size_t measureRun(const unsigned int *input, size_t first, size_t limit, unsigned int symbol);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Counter Table
+Actions:
+  • allocates the per state counter indices, all COUNTER_NONE, and the per transition operations
+*/
+FSM_STATUS initCounters(CounterTable *table, FSM *fsm) {
+  // validate inputs
+  if (table == NULL || fsm == NULL || fsm->D == NULL || fsm->Q == NULL)
+    return FSM_NO_MACHINE;
+
+  // allocate
+  table->counter = malloc(fsm->Qc * sizeof(unsigned int));
+  table->ops = calloc((size_t)fsm->Qc * fsm->Ec, sizeof(unsigned char));
+  if (table->counter == NULL || table->ops == NULL) {
+    free(table->counter);
+    free(table->ops);
+    table->counter = NULL;
+    table->ops = NULL;
+    return FSM_ALLOC_ERR;
+  }
+  for (unsigned int state = 0; state < fsm->Qc; state++)
+    table->counter[state] = COUNTER_NONE;
+  table->fsm = fsm;
+  table->bounds = NULL;
+  table->counter_count = 0;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Counter Table
+Actions:
+  • frees the counter indices, bounds and operations
+*/
+void freeCounters(CounterTable *table) {
+  if (table == NULL)
+    return;
+
+  free(table->counter);
+  free(table->bounds);
+  free(table->ops);
+  table->counter = NULL;
+  table->bounds = NULL;
+  table->ops = NULL;
+  table->counter_count = 0;
+}
+
+
+/*
+Set Counter
+Actions:
+  • validates the state and bounds
+  • gives the state a new counter if it has none, then sets the bounds
+*/
+FSM_STATUS setCounter(CounterTable *table, unsigned int state_id, unsigned int min, unsigned int max) {
+  // validate inputs
+  if (table == NULL || table->counter == NULL)
+    return FSM_NO_MACHINE;
+  if (state_id >= table->fsm->Qc)
+    return FSM_NO_STATE;
+  if (max == 0 || min > max)
+    return FSM_SIZE_ERR;
+
+  // new counter
+  if (table->counter[state_id] == COUNTER_NONE) {
+    CounterBounds *grown = realloc(table->bounds, (table->counter_count + 1) * sizeof(CounterBounds));
+    if (grown == NULL)
+      return FSM_ALLOC_ERR;
+    table->bounds = grown;
+    table->counter[state_id] = table->counter_count++;
+  }
+
+  table->bounds[table->counter[state_id]].min = min;
+  table->bounds[table->counter[state_id]].max = max;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Set Counter Operations
+Actions:
+  • validates the state, symbol and operations
+  • records the transition's operations
+*/
+FSM_STATUS setCounterOps(CounterTable *table, unsigned int from_state_id, unsigned int symbol, unsigned int ops) {
+  // validate inputs
+  if (table == NULL || table->ops == NULL)
+    return FSM_NO_MACHINE;
+  if (from_state_id >= table->fsm->Qc)
+    return FSM_NO_STATE;
+  if (symbol >= table->fsm->Ec || (ops & ~(COUNT_TEST | COUNT_RESET | COUNT_INCREMENT)) != 0)
+    return FSM_SIZE_ERR;
+
+  table->ops[(size_t)from_state_id * table->fsm->Ec + symbol] = (unsigned char)ops;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Initialize Counting Interpreter
+Actions:
+  • validates the table is of the machine
+  • initializes the interpreter
+  • allocates the counts, all 0
+*/
+INTERP_STATUS initCountingInterpreter(CountingInterpreter *counting, FSM *machine, const CounterTable *counters) {
+  // validate inputs
+  if (counting == NULL)
+    return INTERP_NO_INTERP;
+  if (machine == NULL || counters == NULL || counters->fsm != machine)
+    return INTERP_NO_MACHINE;
+
+  INTERP_STATUS status = initInterpreter(&counting->interp, machine);
+  if (status != INTERP_OK)
+    return status;
+
+  counting->counts = calloc(counters->counter_count ? counters->counter_count : 1, sizeof(unsigned int));
+  if (counting->counts == NULL)
+    return INTERP_ALLOC_ERR;
+  counting->counters = counters;
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Free Counting Interpreter
+Actions:
+  • frees the counts
+*/
+void freeCountingInterpreter(CountingInterpreter *counting) {
+  if (counting == NULL)
+    return;
+
+  free(counting->counts);
+  counting->counts = NULL;
+}
+
+
+/*
+Counted Transition
+Actions:
+  • finds the transition, then checks and applies its counter operations
+  • moves to the new state and runs its action
+*/
+INTERP_STATUS countedTransition(CountingInterpreter *counting, unsigned int symbol) {
+  // validate inputs
+  if (counting == NULL)
+    return INTERP_NO_INTERP;
+  FSM *fsm = counting->interp.fsm;
+  if (symbol >= fsm->Ec)
+    return INTERP_SYMB_ERR;
+
+  unsigned int from = counting->interp.current_state->id;
+  size_t index = (size_t)from * fsm->Ec + symbol;
+  State *next = fsm->D[index];
+  if (next == NULL || !applyOps(counting->counters, counting->counts, from, next->id, counting->counters->ops[index]))
+    return INTERP_TRANS_ERR;
+
+  counting->interp.current_state = next;
+  counting->interp.position++;
+  if (next->action != NULL)
+    next->action();
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Run Counted
+Actions:
+  • steps each symbol, checking and applying counter operations where the transition has any
+  • on a loop that only increments, measures the run of its symbol that follows, up to the room left in
+    the counter, and adds it to the counter at once
+*/
+INTERP_STATUS runCounted(CountingInterpreter *counting, const unsigned int *input, size_t input_length,
+                         size_t *consumed) {
+  // validate inputs
+  if (counting == NULL)
+    return INTERP_NO_INTERP;
+
+  const CounterTable *table = counting->counters;
+  const unsigned char *ops = table->ops;
+  unsigned int *counts = counting->counts;
+  State **transitions = counting->interp.fsm->D;
+  size_t symbol_count = counting->interp.fsm->Ec;
+
+  State *state = counting->interp.current_state;
+  INTERP_STATUS status = INTERP_OK;
+  size_t i = 0;
+  for (; i < input_length; i++) {
+    unsigned int symbol = input[i];
+    if (symbol >= symbol_count) {
+      status = INTERP_SYMB_ERR;
+      break;
+    }
+    size_t index = (size_t)state->id * symbol_count + symbol;
+    State *next = transitions[index];
+    if (next == NULL) {
+      status = INTERP_TRANS_ERR;
+      break;
+    }
+
+    unsigned int op = ops[index];
+    if (op != 0) {
+      if (!applyOps(table, counts, state->id, next->id, op)) {
+        status = INTERP_TRANS_ERR;
+        break;
+      }
+
+      // the rest of a run on an incrementing loop
+      unsigned int counter = table->counter[next->id];
+      if (next == state && op == COUNT_INCREMENT && counter != COUNTER_NONE) {
+        size_t room = table->bounds[counter].max - counts[counter];
+        size_t limit = (input_length - i - 1 < room) ? input_length : i + 1 + room;
+        size_t run = measureRun(input, i + 1, limit, symbol);
+        counts[counter] += (unsigned int)run;
+        i += run;
+      }
+    }
+    state = next;
+  }
+
+  counting->interp.current_state = state;
+  counting->interp.position += i;
+  if (consumed != NULL)
+    *consumed = i;
+
+  if (status != INTERP_OK)
+    return status;
+  return countedAccept(counting);
+}
+
+
+/*
+Counted Accept
+Actions:
+  • the current state must be accepting, and its counter, if any, within bounds
+*/
+INTERP_STATUS countedAccept(const CountingInterpreter *counting) {
+  const State *state = counting->interp.current_state;
+  if (state->type == ACCEPT_STATE && inBounds(counting->counters, counting->counts, state->id))
+    return INTERP_ACCEPT;
+  return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+In Bounds
+Actions:
+  • a state that does not count is always in bounds
+*/
+static int inBounds(const CounterTable *table, const unsigned int *counts, unsigned int state_id) {
+  unsigned int counter = table->counter[state_id];
+  if (counter == COUNTER_NONE)
+    return 1;
+  return counts[counter] >= table->bounds[counter].min && counts[counter] <= table->bounds[counter].max;
+}
+
+
+/*
+Apply Operations
+Actions:
+  • checks the counters first, so a transition that is not allowed changes nothing
+  • tests the counter of the state left, then resets and increments the counter of the state entered
+*/
+static int applyOps(const CounterTable *table, unsigned int *counts, unsigned int from_state_id,
+                    unsigned int to_state_id, unsigned int ops) {
+  if ((ops & COUNT_TEST) && !inBounds(table, counts, from_state_id))
+    return 0;
+
+  unsigned int counter = table->counter[to_state_id];
+  if (counter == COUNTER_NONE)
+    return 1;
+  unsigned int count = (ops & COUNT_RESET) ? 0 : counts[counter];
+  if (ops & COUNT_INCREMENT) {
+    if (count >= table->bounds[counter].max)
+      return 0;
+    count++;
+  }
+  counts[counter] = count;
+  return 1;
+}
+
+
+/*
+Measure Run
+Actions:
+  • compares whole blocks of symbols at once, with no branch per symbol, until one differs
+  • finishes one symbol at a time
+*/
+static size_t measureRun(const unsigned int *input, size_t first, size_t limit, unsigned int symbol) {
+  size_t i = first;
+  while (limit - i >= COUNTER_SCAN_BLOCK) {
+    unsigned int differ = 0;
+    for (unsigned int k = 0; k < COUNTER_SCAN_BLOCK; k++)
+      differ |= input[i + k] ^ symbol;
+    if (differ != 0)
+      break;
+    i += COUNTER_SCAN_BLOCK;
+  }
+  while (i < limit && input[i] == symbol)
+    i++;
+
+  return i - first;
+}
@@ -0,0 +1,241 @@
+// Author: Kevin Imlay
+
+/*
+Counters let a state count how many times it repeats, so a bounded repetition such as "x 1000 times" is
+one state instead of a chain of 1000. A counting state owns a counter with bounds, and each transition
+may carry counter operations, applied in this order:
+  • COUNT_TEST - the transition is only taken if the counter of the state left is within its bounds.
+  • COUNT_RESET - the counter of the state entered is set to 0.
+  • COUNT_INCREMENT - the counter of the state entered is increased by 1, the transition is not taken if
+    it is already at its upper bound.
+A transition that fails either check is treated as a missing transition. A counting state only accepts
+when its counter is within its bounds.
+
+The bounds and operations are kept in tables beside the machine, and the counts in the interpreter, so
+one table serves any number of interpreters. runCounted() skips over a run of a symbol that loops on a
+counting state and only increments its counter in bulk: it finds the length of the run, up to the room
+left below the bound, and adds it to the counter in one step.
+*/
+
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Counter operations of a transition, combined with |.
+*/
+#define COUNT_TEST 1u
+#define COUNT_RESET 2u
+#define COUNT_INCREMENT 4u
+
+/*
+Counter index of a state that does not count.
+*/
+#define COUNTER_NONE 0xFFFFFFFFu
+
+
+/* ----- Structures ----- */
+
+/*
+Bounds of a counter, both inclusive.
+*/
+typedef struct {
+  unsigned int min;
+  unsigned int max;
+} CounterBounds;
+
+
+/*
+Counters of a machine's states and counter operations of its transitions.
+*/
+typedef struct {
+  FSM *fsm;
+
+  // counter of each state, or COUNTER_NONE, and the bounds of each counter
+  unsigned int *counter;
+  CounterBounds *bounds;
+  unsigned int counter_count;
+
+  // operations of each transition, indexed as the transition table
+  unsigned char *ops;
+
+} CounterTable;
+
+
+/*
+Interpreter whose states may count.
+*/
+typedef struct {
+  Interpreter interp;
+  const CounterTable *counters;
+
+  // count of each counter
+  unsigned int *counts;
+
+} CountingInterpreter;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Counter Table
+Allocates the counter tables of a machine, with no counting states and no operations.
+
+Arguments:
+  • table - pointer to the counter table to initialize.
+  • fsm - pointer to an initialized FSM.
+      Note: its size must not be changed while the table is in use.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either pointer provided was null, or the machine is not initialized.
+*/
+FSM_STATUS initCounters(CounterTable *table, FSM *fsm);
+
+
+/*
+Free Counter Table
+Releases the memory held by a counter table.
+
+Arguments:
+  • table - pointer to the counter table.
+      Note: may be null.
+*/
+void freeCounters(CounterTable *table);
+
+
+/*
+Set Counter
+Makes a state count, or changes the bounds of its counter.
+
+Arguments:
+  • table - pointer to the counter table.
+  • state_id - ID of the state.
+  • min - lowest count the state accepts and may be left by a testing transition at.
+  • max - highest count the counter may reach.
+      Note: must be at least 1 and at least min.
+      Note: counters must not be added while interpreters of the table are in use.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_STATE - if the state does not exist.
+  • FSM_SIZE_ERR - if the bounds are not valid.
+  • FSM_NO_MACHINE - if the table is null or not initialized.
+*/
+FSM_STATUS setCounter(CounterTable *table, unsigned int state_id, unsigned int min, unsigned int max);
+
+
+/*
+Set Counter Operations
+Sets the counter operations of a transition.
+
+Arguments:
+  • table - pointer to the counter table.
+  • from_state_id - ID of the state the transition leaves.
+  • symbol - symbol of the transition.
+  • ops - COUNT_TEST, COUNT_RESET and COUNT_INCREMENT combined with |, or 0 for none.
+      Note: operations on a state that does not count are ignored.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if the state does not exist.
+  • FSM_SIZE_ERR - if the symbol is not in the machine's alphabet, or the operations are not valid.
+  • FSM_NO_MACHINE - if the table is null or not initialized.
+*/
+FSM_STATUS setCounterOps(CounterTable *table, unsigned int from_state_id, unsigned int symbol, unsigned int ops);
+
+
+/*
+Initialize Counting Interpreter
+Initializes an interpreter in the machine's start state with every count 0.
+
+Arguments:
+  • counting - pointer to the counting interpreter to initialize.
+  • machine - pointer to the FSM to run the interpreter on.
+  • counters - pointer to the machine's counter table.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_ALLOC_ERR - if needed memory was not able to be allocated.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine or table is null, or the table is not the machine's.
+  • INTERP_MACHINE_NOT_INIT - if the machine provided is not initialized.
+  • INTERP_MACHINE_NO_START - if the machine provided has no start state.
+*/
+INTERP_STATUS initCountingInterpreter(CountingInterpreter *counting, FSM *machine, const CounterTable *counters);
+
+
+/*
+Free Counting Interpreter
+Releases the counts of an interpreter.
+
+Arguments:
+  • counting - pointer to the counting interpreter.
+      Note: may be null.
+*/
+void freeCountingInterpreter(CountingInterpreter *counting);
+
+
+/*
+Counted Transition
+Inputs a symbol, applying the transition's counter operations, and runs the new state's action.
+
+Arguments:
+  • counting - pointer to the counting interpreter.
+  • symbol - unsigned integer symbol.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_SYMB_ERR - if the symbol provided is invalid.
+  • INTERP_TRANS_ERR - if there is no transition on the symbol, or a counter does not allow it.
+      Note: on either error the interpreter and its counts are not changed.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+*/
+INTERP_STATUS countedTransition(CountingInterpreter *counting, unsigned int symbol);
+
+
+/*
+Run Counted
+Steps an input through a counting interpreter, skipping runs of a symbol that only increments the counter
+of the state it loops on in bulk. No actions are run.
+
+Arguments:
+  • counting - pointer to the counting interpreter.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - length of the input array.
+  • consumed - [pass back] count of symbols stepped, may be null.
+
+Returns:
+  • INTERP_ACCEPT - if the input ends in a final state, with its counter within bounds.
+  • INTERP_NO_ACCEPT - otherwise at the end of the input.
+  • INTERP_SYMB_ERR - if a symbol is invalid.
+  • INTERP_TRANS_ERR - if there is no transition on a symbol, or a counter does not allow it.
+      Note: on either error the interpreter is left before the failing symbol.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+*/
+INTERP_STATUS runCounted(CountingInterpreter *counting, const unsigned int *input, size_t input_length,
+                         size_t *consumed);
+
+
+/*
+Counted Accept
+Gets whether the interpreter's current state accepts, with its counter within bounds.
+
+Arguments:
+  • counting - pointer to the counting interpreter.
+
+Returns:
+  • INTERP_ACCEPT - if the current state accepts.
+  • INTERP_NO_ACCEPT - otherwise.
+*/
+INTERP_STATUS countedAccept(const CountingInterpreter *counting);
+
+#endif
@@ -0,0 +1,49 @@
+// Author: Kevin Imlay
+
+#include "cpu.h"
+
+/* ----- Public Function Definitions ----- */
+
+/*
+CPU Has AVX2
+Actions:
+  • queries the compiler's CPU model
+*/
+int cpuHasAVX2(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? 1 : 0;
+#else
+  return 0;
+#endif
+}
+
+
+/*
+CPU Has AVX-512
+Actions:
+  • queries the compiler's CPU model
+*/
+int cpuHasAVX512(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") ? 1 : 0;
+#else
+  return 0;
+#endif
+}
+
+
+/*
+CPU Has BMI2
+Actions:
+  • queries the compiler's CPU model
+*/
+int cpuHasBMI2(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("bmi2") ? 1 : 0;
+#else
+  return 0;
+#endif
+}
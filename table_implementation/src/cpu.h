@@ -0,0 +1,47 @@
+// Author: Kevin Imlay
+
+/*
+Runtime CPU feature detection. Vectorized kernels are compiled for their instruction set with function
+target attributes and only selected at runtime when the CPU running the program supports them, so the
+rest of the build does not need any instruction set flags.
+*/
+
+#ifndef CPU_H
+#define CPU_H
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+CPU Has AVX2
+Checks if the CPU supports the AVX2 instruction set.
+
+Returns:
+  • 1 - if supported.
+  • 0 - if not supported.
+*/
+int cpuHasAVX2(void);
+
+
+/*
+CPU Has AVX-512
+Checks if the CPU supports the AVX-512 foundation instruction set.
+
+Returns:
+  • 1 - if supported.
+  • 0 - if not supported.
+*/
+int cpuHasAVX512(void);
+
+
+/*
+CPU Has BMI2
+Checks if the CPU supports the BMI2 bit manipulation instruction set.
+
+Returns:
+  • 1 - if supported.
+  • 0 - if not supported.
+*/
+int cpuHasBMI2(void);
+
+#endif
@@ -0,0 +1,291 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define DEFROW_SSE2
+#endif
+
+#include "defrow.h"
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int cellOf(FSM *fsm, unsigned int state_id, unsigned int symbol);
+static unsigned int chooseDefault(FSM *fsm, unsigned int state_id, unsigned char *depth,
+                                  unsigned int *tally, unsigned int *touched, unsigned int *exception_count);
+static inline unsigned int lookup(const DefaultTable *table, unsigned int state_id, unsigned int symbol);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Default Row Table
+Actions:
+  • choose the default of every state, counting its exceptions
+  • allocate the exception lists, padded for the SIMD compare
+  • fill each state's exceptions in symbol order
+*/
+FSM_STATUS initDefaultTable(DefaultTable *table, FSM *fsm) {
+  // validate inputs
+  if (table == NULL || fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+  if (fsm->Qc >= DEFROW_TEMPLATE)
+    return FSM_SIZE_ERR;
+
+  unsigned int state_count = fsm->Qc;
+  unsigned int symbol_count = fsm->Ec;
+
+  // allocate
+  table->fallback = malloc(state_count * sizeof(unsigned int));
+  table->offset = malloc(((size_t)state_count + 1) * sizeof(size_t));
+  table->accept = calloc(((size_t)state_count + 63) / 64, sizeof(unsigned long long));
+  table->exception_symbol = NULL;
+  table->exception_target = NULL;
+  unsigned char *depth = malloc(state_count * sizeof(unsigned char));
+  unsigned int *tally = calloc((size_t)state_count + 1, sizeof(unsigned int));
+  unsigned int *touched = malloc(symbol_count * sizeof(unsigned int));
+  if (table->fallback == NULL || table->offset == NULL || table->accept == NULL || depth == NULL ||
+      tally == NULL || touched == NULL) {
+    free(depth);
+    free(tally);
+    free(touched);
+    freeDefaultTable(table);
+    return FSM_ALLOC_ERR;
+  }
+
+  // choose defaults
+  table->exceptions = 0;
+  table->templates = 0;
+  table->offset[0] = 0;
+  for (unsigned int state = 0; state < state_count; state++) {
+    unsigned int exception_count;
+    table->fallback[state] = chooseDefault(fsm, state, depth, tally, touched, &exception_count);
+    if (table->fallback[state] != TABLE_NO_STATE && (table->fallback[state] & DEFROW_TEMPLATE))
+      table->templates++;
+    table->exceptions += exception_count;
+
+    size_t padded = (exception_count + DEFROW_LANES - 1) / DEFROW_LANES * DEFROW_LANES;
+    table->offset[state + 1] = table->offset[state] + padded;
+  }
+  free(depth);
+  free(tally);
+  free(touched);
+
+  // allocate exceptions
+  size_t slots = table->offset[state_count];
+  table->exception_symbol = malloc((slots > 0 ? slots : 1) * sizeof(unsigned int));
+  table->exception_target = malloc((slots > 0 ? slots : 1) * sizeof(unsigned int));
+  if (table->exception_symbol == NULL || table->exception_target == NULL) {
+    freeDefaultTable(table);
+    return FSM_ALLOC_ERR;
+  }
+
+  // fill exceptions, every symbol where the state's row differs from its default
+  for (unsigned int state = 0; state < state_count; state++) {
+    unsigned int fallback = table->fallback[state];
+    int is_template = (fallback != TABLE_NO_STATE && (fallback & DEFROW_TEMPLATE));
+    size_t slot = table->offset[state];
+
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+      unsigned int cell = cellOf(fsm, state, symbol);
+      unsigned int default_cell = is_template ? cellOf(fsm, fallback & ~DEFROW_TEMPLATE, symbol) : fallback;
+      if (cell != default_cell) {
+        table->exception_symbol[slot] = symbol;
+        table->exception_target[slot] = cell;
+        slot++;
+      }
+    }
+    for (; slot < table->offset[state + 1]; slot++) {
+      table->exception_symbol[slot] = TABLE_NO_STATE;
+      table->exception_target[slot] = TABLE_NO_STATE;
+    }
+  }
+
+  // accepting and start states
+  for (unsigned int state = 0; state < state_count; state++)
+    if (fsm->Q[state].type == ACCEPT_STATE)
+      table->accept[state >> 6] |= 1ULL << (state & 63);
+
+  table->Qc = state_count;
+  table->Ec = symbol_count;
+  table->start = (fsm->Qs == NULL) ? TABLE_NO_STATE : fsm->Qs->id;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Default Row Table
+Actions:
+  • free the defaults, exceptions and accepting bitmap
+*/
+void freeDefaultTable(DefaultTable *table) {
+  if (table == NULL)
+    return;
+
+  free(table->fallback);
+  free(table->offset);
+  free(table->exception_symbol);
+  free(table->exception_target);
+  free(table->accept);
+  table->fallback = NULL;
+  table->offset = NULL;
+  table->exception_symbol = NULL;
+  table->exception_target = NULL;
+  table->accept = NULL;
+}
+
+
+/*
+Default Next
+Actions:
+  • see lookup()
+*/
+unsigned int defaultNext(const DefaultTable *table, unsigned int state_id, unsigned int symbol) {
+  return lookup(table, state_id, symbol);
+}
+
+
+/*
+Recognize Default
+Actions:
+  • walk the default row table from the start state
+  • check the accepting bitmap for the final state
+*/
+INTERP_STATUS recognizeDefault(const DefaultTable *table, const unsigned int *input, unsigned int input_length) {
+  // validate inputs
+  if (table == NULL || table->exception_symbol == NULL)
+    return INTERP_NO_MACHINE;
+  if (table->start == TABLE_NO_STATE)
+    return INTERP_MACHINE_NO_START;
+
+  unsigned int state = table->start;
+  for (unsigned int i = 0; i < input_length; i++) {
+    if (input[i] >= table->Ec)
+      return INTERP_SYMB_ERR;
+    state = lookup(table, state, input[i]);
+    if (state == TABLE_NO_STATE)
+      return INTERP_TRANS_ERR;
+  }
+
+  // check accept state
+  if ((table->accept[state >> 6] >> (state & 63)) & 1)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Cell Of
+Actions:
+  • ID of the state in a field of the FSM's table, or TABLE_NO_STATE
+*/
+static unsigned int cellOf(FSM *fsm, unsigned int state_id, unsigned int symbol) {
+  State *to_state = fsm->D[(size_t)state_id * fsm->Ec + symbol];
+  return (to_state == NULL) ? TABLE_NO_STATE : to_state->id;
+}
+
+
+/*
+Choose Default
+Actions:
+  • count the most common target of the state's row, its exceptions are every other field
+  • count the differences from each of the last few states' rows that may still be used as a template
+  • pick whichever has the fewest exceptions, preferring the default target on a tie
+  • record the depth of the state's row, for later states that use it as a template
+*/
+static unsigned int chooseDefault(FSM *fsm, unsigned int state_id, unsigned char *depth,
+                                  unsigned int *tally, unsigned int *touched, unsigned int *exception_count) {
+  unsigned int symbol_count = fsm->Ec;
+  unsigned int touched_count = 0;
+  unsigned int best_target = TABLE_NO_STATE;
+  unsigned int best_tally = 0;
+
+  // most common target, the tally is indexed by target + 1 so no transition counts too
+  for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+    unsigned int index = cellOf(fsm, state_id, symbol) + 1;
+    if (tally[index]++ == 0)
+      touched[touched_count++] = index;
+    if (tally[index] > best_tally) {
+      best_tally = tally[index];
+      best_target = index - 1;
+    }
+  }
+  for (unsigned int i = 0; i < touched_count; i++)
+    tally[touched[i]] = 0;
+
+  unsigned int best = best_target;
+  unsigned int best_count = symbol_count - best_tally;
+  unsigned char best_depth = 1;
+
+  // template rows
+  unsigned int first = (state_id > DEFROW_TEMPLATE_WINDOW) ? state_id - DEFROW_TEMPLATE_WINDOW : 0;
+  for (unsigned int other = first; other < state_id && best_count > 0; other++) {
+    if (depth[other] >= DEFROW_MAX_DEPTH)
+      continue;
+
+    unsigned int count = 0;
+    for (unsigned int symbol = 0; symbol < symbol_count && count < best_count; symbol++)
+      if (cellOf(fsm, state_id, symbol) != cellOf(fsm, other, symbol))
+        count++;
+
+    if (count < best_count) {
+      best = other | DEFROW_TEMPLATE;
+      best_count = count;
+      best_depth = depth[other] + 1;
+    }
+  }
+
+  depth[state_id] = best_depth;
+  *exception_count = best_count;
+  return best;
+}
+
+
+/*
+Lookup
+Actions:
+  • compare the symbol against the state's exceptions, DEFROW_LANES at a time
+  • exceptions are sorted, so stop at the first group that ends past the symbol
+  • if none match, use the default target, or look up the template row the same way
+*/
+static inline unsigned int lookup(const DefaultTable *table, unsigned int state_id, unsigned int symbol) {
+  const unsigned int *symbols = table->exception_symbol;
+
+#ifdef DEFROW_SSE2
+  const __m128i key = _mm_set1_epi32((int)symbol);
+#endif
+
+  for (unsigned int level = 0; level < DEFROW_MAX_DEPTH; level++) {
+    size_t end = table->offset[state_id + 1];
+
+    for (size_t i = table->offset[state_id]; i < end; i += DEFROW_LANES) {
+#ifdef DEFROW_SSE2
+      __m128i low = _mm_loadu_si128((const __m128i *)(symbols + i));
+      __m128i high = _mm_loadu_si128((const __m128i *)(symbols + i + 4));
+      int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(low, key))) |
+                 (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(high, key))) << 4);
+      if (mask != 0)
+        return table->exception_target[i + (unsigned int)__builtin_ctz((unsigned int)mask)];
+#else
+      for (size_t j = i; j < i + DEFROW_LANES; j++)
+        if (symbols[j] == symbol)
+          return table->exception_target[j];
+#endif
+      if (symbols[i + DEFROW_LANES - 1] > symbol)
+        break;
+    }
+
+    unsigned int fallback = table->fallback[state_id];
+    if (fallback == TABLE_NO_STATE || !(fallback & DEFROW_TEMPLATE))
+      return fallback;
+    state_id = fallback & ~DEFROW_TEMPLATE;
+  }
+
+  return TABLE_NO_STATE;
+}
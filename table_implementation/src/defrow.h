@@ -0,0 +1,152 @@
+// Author: Kevin Imlay
+
+/*
+The default row table stores each state's row of the transition table as a default plus a short list
+of exceptions, the way lex and flex compress their tables. A state's default is either:
+  • a default target - the state transitioned to on every symbol that is not an exception, or
+  • a template row - another state whose row is used for every symbol that is not an exception, for
+      states whose rows are nearly the same as an earlier state's.
+The default of each state is chosen by whichever needs the fewest exceptions. Exceptions are kept
+sorted by symbol and padded to a multiple of DEFROW_LANES, so a lookup compares the symbol against
+several exceptions at once with SSE2.
+
+Like the state table, the default row table is a snapshot of the FSM it was built from.
+*/
+
+#ifndef DEFROW_H
+#define DEFROW_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Exceptions compared per step of a lookup, exception lists are padded to a multiple of this.
+*/
+#define DEFROW_LANES 8
+
+/*
+Flag on a state's default that marks it as a template row rather than a default target.
+*/
+#define DEFROW_TEMPLATE 0x80000000u
+
+/*
+Most template rows a lookup follows, including the state's own row.
+*/
+#define DEFROW_MAX_DEPTH 4
+
+/*
+Earlier states considered as the template row of a state.
+*/
+#define DEFROW_TEMPLATE_WINDOW 16
+
+
+/* ----- Structures ----- */
+
+/*
+Default row transition table.
+*/
+typedef struct {
+  // count of states in the machine
+  unsigned int Qc;
+
+  // count of input alphabet symbols
+  unsigned int Ec;
+
+  // default of each state: a state ID or TABLE_NO_STATE, or a template row state ID | DEFROW_TEMPLATE
+  unsigned int *fallback;
+
+  // start of each state's exceptions, Qc + 1 entries
+  size_t *offset;
+
+  // exception symbols, sorted within each state and padded with TABLE_NO_STATE
+  unsigned int *exception_symbol;
+
+  // state transitioned to on each exception symbol, or TABLE_NO_STATE
+  unsigned int *exception_target;
+
+  // count of exceptions, not counting padding
+  size_t exceptions;
+
+  // count of states using a template row
+  unsigned int templates;
+
+  // bitmap of accepting states, one bit per state ID
+  unsigned long long *accept;
+
+  // ID of the starting state
+  unsigned int start;
+
+} DefaultTable;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Default Row Table
+Compresses the transition table of a FSM into default rows with exceptions.
+
+Arguments:
+  • table - pointer to the default row table to initialize.
+  • fsm - pointer to an initialized FSM.
+      Note: must have fewer than DEFROW_TEMPLATE states.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if the machine has too many states.
+  • FSM_NO_MACHINE - either the table or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initDefaultTable(DefaultTable *table, FSM *fsm);
+
+
+/*
+Free Default Row Table
+Releases the memory held by a default row table.
+
+Arguments:
+  • table - pointer to the default row table.
+      Note: may be null.
+*/
+void freeDefaultTable(DefaultTable *table);
+
+
+/*
+Default Next
+Looks up the state transitioned to from a state on a symbol.
+
+Arguments:
+  • table - pointer to the default row table.
+  • state_id - ID of the state, must be less than the table's state count.
+  • symbol - symbol, must be less than the table's symbol count.
+
+Returns:
+  • ID of the state transitioned to, or TABLE_NO_STATE if there is no transition.
+*/
+unsigned int defaultNext(const DefaultTable *table, unsigned int state_id, unsigned int symbol);
+
+
+/*
+Recognize Default
+Runs the input from the machine's start state without running any actions, the same as
+recognizeInput() on a state table.
+
+Arguments:
+  • table - pointer to the default row table.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+  • INTERP_NO_MACHINE - if the table provided is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS recognizeDefault(const DefaultTable *table, const unsigned int *input, unsigned int input_length);
+
+#endif
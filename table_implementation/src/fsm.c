@@ -3,10 +3,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define FSM_MMAP
+#endif
+
 #include "fsm.h"
 
 /* ----- Private Function Prototypes ----- */
 
+static State **allocTable(size_t cells, TABLE_PAGES pages, TABLE_PAGES *granted, size_t *mapped);
+static void freeTable(State **table, size_t mapped);
+
 
 /* ----- Public Function Definitions ----- */
 
@@ -32,26 +42,26 @@ void printFSM(FSM *fsm) {
 
   // print symbols
   strcat(temp_row, "___");
-  for (int i = 0; i < fsm->Ec; i++) {
+  for (unsigned int i = 0; i < fsm->Ec; i++) {
     strcat(temp_row, "|_%d_");
     sprintf(temp_row, temp_row, i);
   }
   printf("%s\n", temp_row);
 
   // print states
-  for (int i = 0; i < fsm->Qc; i++) {
+  for (unsigned int i = 0; i < fsm->Qc; i++) {
     for (int i = 0; i < 100; i++)
       temp_row[i] = '\0';
     strcat(temp_row, " %d ");
     sprintf(temp_row, temp_row, i);
-    for (int j = 0; j < fsm->Ec; j++) {
-      if (fsm->D[i*fsm->Ec+j] == NULL) {
+    for (unsigned int j = 0; j < fsm->Ec; j++) {
+      if (fsm->D[(size_t)i*fsm->Ec+j] == NULL) {
         strcat(temp_row, "| %c ");
         sprintf(temp_row, temp_row, '-');
       }
       else {
         strcat(temp_row, "| %d ");
-        sprintf(temp_row, temp_row, (fsm->D[i*fsm->Ec+j])->id);
+        sprintf(temp_row, temp_row, (fsm->D[(size_t)i*fsm->Ec+j])->id);
       }
     }
     printf("%s\n", temp_row);
@@ -65,31 +75,46 @@ void printFSM(FSM *fsm) {
 /*
 Initialize FSM
 Actions:
-  • allocate the transition table and state list
-  • set the starting state to NULL
-  • set count of states and symbols to 0
+  • initialize with the transition table on normal pages
 */
 FSM_STATUS initFSM(FSM *fsm, unsigned int state_count, unsigned int symbol_count) {
+  return initFSMPages(fsm, state_count, symbol_count, PAGES_SMALL);
+}
+
+
+/*
+Initialize FSM With Pages
+Actions:
+  • check the size of the transition table fits in memory
+  • allocate the transition table on the pages requested, and the state list
+  • set the starting state to NULL
+  • set count of states and symbols
+*/
+FSM_STATUS initFSMPages(FSM *fsm, unsigned int state_count, unsigned int symbol_count, TABLE_PAGES pages) {
   // validate inputs
   if (fsm == NULL)
     return FSM_NO_MACHINE;
   if (state_count == 0 || symbol_count == 0)
     return FSM_SIZE_ERR;
+  if (symbol_count > SIZE_MAX / sizeof(State*) / state_count)
+    return FSM_SIZE_ERR;
+  if (pages != PAGES_SMALL && pages != PAGES_TRANSPARENT && pages != PAGES_HUGE)
+    return FSM_SIZE_ERR;
 
-  // allocate
+  // allocate, every transition starts null
   fsm->Q = calloc(state_count, sizeof(State));
-  fsm->D = malloc(state_count * symbol_count * sizeof(State*));
-  for (int i = 0; i < state_count * symbol_count; i++)
-    fsm->D[i] = NULL;
+  fsm->D = allocTable((size_t)state_count * symbol_count, pages, &fsm->Dpages, &fsm->Dbytes);
 
   // check if allocation was successful
-  if (fsm->Q == NULL || fsm->D == NULL)
+  if (fsm->Q == NULL || fsm->D == NULL) {
+    freeFSM(fsm);
     return FSM_ALLOC_ERR;
+  }
 
   // set defaults
   fsm->Qc = state_count;
   fsm->Ec = symbol_count;
-  for (int i = 0; i < state_count; i++) {
+  for (unsigned int i = 0; i < state_count; i++) {
     State temp_state;
     temp_state.id = i;
     temp_state.type = NORMAL_STATE;
@@ -98,12 +123,33 @@ FSM_STATUS initFSM(FSM *fsm, unsigned int state_count, unsigned int symbol_count
     // printf("%d Func Ptr: %d\n", temp_state.id, temp_state.action);
   }
   fsm->Qs = NULL;
+  fsm->Qsink = NULL;
 
   // successful
   return FSM_OK;
 }
 
 
+/*
+Free FSM
+Actions:
+  • free the state list
+  • free or unmap the transition table
+*/
+void freeFSM(FSM *fsm) {
+  if (fsm == NULL)
+    return;
+
+  free(fsm->Q);
+  freeTable(fsm->D, fsm->Dbytes);
+  fsm->Q = NULL;
+  fsm->D = NULL;
+  fsm->Qs = NULL;
+  fsm->Qsink = NULL;
+  fsm->Dbytes = 0;
+}
+
+
 /*
 Configure State
 
@@ -148,7 +194,7 @@ FSM_STATUS addTrans(FSM *fsm, unsigned int from_state_id, unsigned int to_state_
     return FSM_SIZE_ERR;
 
   // set transition
-  fsm->D[from_state_id * fsm->Ec + symbol] = &(fsm->Q[to_state_id]);
+  fsm->D[(size_t)from_state_id * fsm->Ec + symbol] = &(fsm->Q[to_state_id]);
 
   // successful
   return FSM_OK;
@@ -171,8 +217,137 @@ FSM_STATUS remTrans(FSM *fsm, unsigned int from_state_id, unsigned int symbol) {
     return FSM_SIZE_ERR;
 
   // set transition
-  fsm->D[from_state_id * fsm->Ec + symbol] = NULL;
+  fsm->D[(size_t)from_state_id * fsm->Ec + symbol] = NULL;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Totalize FSM
+Actions:
+  • allocate a state list and transition table with room for the sink state, on the same pages
+  • copy the states, and every transition by ID into the new table
+  • point every missing transition, and every transition of the sink state, at the sink state
+*/
+FSM_STATUS totalizeFSM(FSM *fsm, unsigned int *sink_id) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+  if (fsm->Qsink != NULL) {
+    *sink_id = fsm->Qsink->id;
+    return FSM_OK;
+  }
+  if (fsm->Qc == 0xFFFFFFFFu || fsm->Ec > SIZE_MAX / sizeof(State*) / (fsm->Qc + 1))
+    return FSM_SIZE_ERR;
+
+  // allocate
+  unsigned int state_count = fsm->Qc + 1;
+  TABLE_PAGES pages;
+  size_t mapped;
+  State *states = calloc(state_count, sizeof(State));
+  State **table = allocTable((size_t)state_count * fsm->Ec, fsm->Dpages, &pages, &mapped);
+  if (states == NULL || table == NULL) {
+    free(states);
+    freeTable(table, mapped);
+    return FSM_ALLOC_ERR;
+  }
+
+  // copy states, add sink
+  for (unsigned int i = 0; i < fsm->Qc; i++)
+    states[i] = fsm->Q[i];
+  State *sink = &states[fsm->Qc];
+  sink->id = fsm->Qc;
+  sink->type = NORMAL_STATE;
+  sink->action = NULL;
+
+  // copy transitions, fill missing
+  for (size_t i = 0; i < (size_t)fsm->Qc * fsm->Ec; i++)
+    table[i] = (fsm->D[i] == NULL) ? sink : &states[fsm->D[i]->id];
+  for (size_t i = (size_t)fsm->Qc * fsm->Ec; i < (size_t)state_count * fsm->Ec; i++)
+    table[i] = sink;
+
+  // swap in
+  if (fsm->Qs != NULL)
+    fsm->Qs = &states[fsm->Qs->id];
+  free(fsm->Q);
+  freeTable(fsm->D, fsm->Dbytes);
+  fsm->Q = states;
+  fsm->D = table;
+  fsm->Dpages = pages;
+  fsm->Dbytes = mapped;
+  fsm->Qc = state_count;
+  fsm->Qsink = sink;
+  *sink_id = sink->id;
 
   // successful
   return FSM_OK;
 }
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Allocate Table
+Actions:
+  • explicit huge pages are mapped from the huge page pool, rounded up to whole huge pages
+  • transparent huge pages are mapped with room to align the table to a huge page, the unaligned ends
+      are unmapped, and the kernel is advised to back the rest with huge pages
+  • normal pages are heap allocated
+  • each falls back to the next when it fails, passing back the pages used and the bytes mapped
+*/
+static State **allocTable(size_t cells, TABLE_PAGES pages, TABLE_PAGES *granted, size_t *mapped) {
+  size_t bytes = cells * sizeof(State*);
+  *mapped = 0;
+
+#if defined(FSM_MMAP) && defined(MAP_HUGETLB)
+  if (pages == PAGES_HUGE && bytes <= SIZE_MAX - FSM_HUGE_PAGE_SIZE) {
+    size_t length = (bytes + FSM_HUGE_PAGE_SIZE - 1) & ~(FSM_HUGE_PAGE_SIZE - 1);
+    void *memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+      *granted = PAGES_HUGE;
+      *mapped = length;
+      return memory;
+    }
+  }
+#endif
+
+#if defined(FSM_MMAP) && defined(MADV_HUGEPAGE)
+  if ((pages == PAGES_HUGE || pages == PAGES_TRANSPARENT) && bytes <= SIZE_MAX - 2 * FSM_HUGE_PAGE_SIZE) {
+    size_t length = (bytes + FSM_HUGE_PAGE_SIZE - 1) & ~(FSM_HUGE_PAGE_SIZE - 1);
+    char *memory = mmap(NULL, length + FSM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+      char *aligned = (char *)(((uintptr_t)memory + FSM_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(FSM_HUGE_PAGE_SIZE - 1));
+      if (aligned > memory)
+        munmap(memory, aligned - memory);
+      if (aligned + length < memory + length + FSM_HUGE_PAGE_SIZE)
+        munmap(aligned + length, memory + FSM_HUGE_PAGE_SIZE - aligned);
+      madvise(aligned, length, MADV_HUGEPAGE);
+      *granted = PAGES_TRANSPARENT;
+      *mapped = length;
+      return (State **)aligned;
+    }
+  }
+#endif
+
+  *granted = PAGES_SMALL;
+  return calloc(cells, sizeof(State*));
+}
+
+
+/*
+Free Table
+Actions:
+  • unmaps a mapped table, or frees a heap allocated one
+*/
+static void freeTable(State **table, size_t mapped) {
+#ifdef FSM_MMAP
+  if (mapped > 0) {
+    munmap(table, mapped);
+    return;
+  }
+#endif
+  free(table);
+}
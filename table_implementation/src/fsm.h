@@ -16,6 +16,16 @@ are the current state and the input symbol.
 #ifndef FSM_H
 #define FSM_H
 
+#include <stddef.h>
+
+
+/* ----- Definitions ----- */
+
+/*
+Size of the huge pages the transition table is aligned to when backed by huge pages.
+*/
+#define FSM_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
 
 /* ----- Enumerations ----- */
 /* Enumerations for all implementations of FSMs */
@@ -29,7 +39,8 @@ typedef enum {
   FSM_ALLOC_ERR,        // there was a problem allocating the necessary memory
   FSM_SIZE_ERR,         // the size provided was invalid or impossible
   FSM_NO_STATE,         // the state does not exist
-  FSM_NO_MACHINE        // the machine does not exist
+  FSM_NO_MACHINE,       // the machine does not exist
+  FSM_IO_ERR            // a file could not be read or written, or does not hold a machine
 } FSM_STATUS;
 
 
@@ -43,6 +54,16 @@ typedef enum {
 } STATE_TYPE;
 
 
+/*
+Pages backing the transition table.
+*/
+typedef enum {
+  PAGES_SMALL = 5000, // heap allocated, normal pages
+  PAGES_TRANSPARENT,  // mapped and aligned to huge pages, advised as transparent huge pages
+  PAGES_HUGE          // mapped from the reserved huge page pool
+} TABLE_PAGES;
+
+
 /* ----- Structures ----- */
 
 /*
@@ -77,6 +98,15 @@ typedef struct {
   // starting state
   State *Qs;
 
+  // sink state that every missing transition leads to, null until the machine is totalized
+  State *Qsink;
+
+  // pages backing the transition table
+  TABLE_PAGES Dpages;
+
+  // bytes mapped for the transition table, 0 if it is heap allocated
+  size_t Dbytes;
+
 } FSM;
 
 
@@ -111,12 +141,50 @@ Arguments:
 Returns:
   • FSM_OK - if successful.
   • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
-  • FSM_SIZE_ERR - either the number of states or number of symbols provided were 0.
+  • FSM_SIZE_ERR - either the number of states or number of symbols provided were 0, or the transition
+      table is larger than can be addressed.
   • FSM_NO_MACHINE - the machine pointer provided was null.
 */
 FSM_STATUS initFSM(FSM *fsm, unsigned int state_count, unsigned int symbol_count);
 
 
+/*
+Initialize FSM With Pages
+Same as initFSM(), with the transition table backed by the pages requested. Huge pages cut the TLB misses
+of lookups in tables much larger than the TLB covers.
+If the pages requested cannot be had, explicit huge pages fall back to transparent huge pages, and
+transparent huge pages fall back to normal pages. The pages actually used are set in the machine's Dpages.
+
+Arguments:
+  • fsm - pointer to the fsm to initialize.
+  • state_count - number of states in the machine.
+      Must be greater than 0 (machine cannot be empty).
+  • symbol_count - number of symbols in the machine.
+      Must be greater than 0 (machine needs to accept input).
+  • pages - pages to back the transition table with.
+      Note: PAGES_HUGE needs huge pages reserved with the system (vm.nr_hugepages).
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - either the number of states or number of symbols provided were 0, the transition
+      table is larger than can be addressed, or the pages are not a TABLE_PAGES.
+  • FSM_NO_MACHINE - the machine pointer provided was null.
+*/
+FSM_STATUS initFSMPages(FSM *fsm, unsigned int state_count, unsigned int symbol_count, TABLE_PAGES pages);
+
+
+/*
+Free FSM
+Releases the state list and transition table of a machine.
+
+Arguments:
+  • fsm - pointer to the fsm to free.
+      Note: may be null.
+*/
+void freeFSM(FSM *fsm);
+
+
 /*
 Configure State
 Changes a state's designation (start, accepting, neither), set the action function pointer.
@@ -175,4 +243,27 @@ Returns:
 */
 FSM_STATUS remTrans(FSM *fsm, unsigned int from_state_id, unsigned int symbol);
 
+
+/*
+Totalize FSM
+Adds a sink state to the machine and points every missing transition at it, so that every state has a
+transition on every symbol. The sink state is a normal state without an action and transitions to
+itself on every symbol, so once entered it is never left.
+Note: the state list is reallocated, so pointers to the machine's states are no longer valid.
+Note: transitions added to the machine later are not checked against the sink state.
+
+Arguments:
+  • fsm - pointer to the fsm to totalize.
+      Note: must not be a replica made by initReplicas(), its states and table are not its own to reallocate.
+  • sink_id - [pass back] unsigned integer ID of the sink state.
+      Note: if the machine is already totalized, its existing sink state.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if the machine already has the most states possible.
+  • FSM_NO_MACHINE - the machine pointer provided was null or the machine is not initialized.
+*/
+FSM_STATUS totalizeFSM(FSM *fsm, unsigned int *sink_id);
+
 #endif
@@ -0,0 +1,522 @@
+// Author: Kevin Imlay
+
+#include <string.h>
+
+#include "incremental.h"
+
+/* ----- Private Structures ----- */
+
+/*
+State to record at a position of the input.
+*/
+typedef struct {
+  size_t position;
+  unsigned int state;
+} Record;
+
+
+/*
+Growing list of states to record.
+*/
+typedef struct {
+  Record *records;
+  size_t count;
+  size_t capacity;
+} RecordList;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int stepRange(const FSM *fsm, unsigned int state, const unsigned int *input, size_t first,
+                              size_t end);
+static int appendRecord(RecordList *list, size_t position, unsigned int state);
+static int reserveNodes(IncrementalRun *run, size_t needed);
+static size_t newNode(IncrementalRun *run, size_t gap, unsigned int state);
+static void freeNodes(IncrementalRun *run, size_t tree);
+static size_t buildTree(IncrementalRun *run, const RecordList *list, size_t previous_position);
+static void updateNode(RunCheckpoint *nodes, size_t node);
+static size_t mergeTrees(RunCheckpoint *nodes, size_t left, size_t right);
+static void splitTree(RunCheckpoint *nodes, size_t tree, size_t rank, size_t *left, size_t *right);
+static size_t findCheckpoint(const IncrementalRun *run, size_t position, size_t *found_position,
+                             unsigned int *state);
+static size_t countBefore(const IncrementalRun *run, size_t position);
+static size_t checkpointAt(const IncrementalRun *run, size_t rank, size_t *position);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Incremental Run
+Actions:
+  • steps the whole input from the start state, recording the state every interval symbols
+  • builds the tree of recorded states
+*/
+INTERP_STATUS initIncremental(IncrementalRun *run, FSM *fsm, unsigned int interval, const unsigned int *input,
+                              size_t input_length) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return INTERP_NO_MACHINE;
+  if (fsm->Qs == NULL)
+    return INTERP_MACHINE_NO_START;
+  if (interval == 0)
+    return INTERP_SYMB_ERR;
+
+  // record
+  RecordList list = {NULL, 0, 0};
+  unsigned int state = fsm->Qs->id;
+  for (size_t position = 0; position < input_length; position += interval) {
+    if (!appendRecord(&list, position, state)) {
+      free(list.records);
+      return INTERP_ALLOC_ERR;
+    }
+    size_t end = (input_length - position > interval) ? position + interval : input_length;
+    state = stepRange(fsm, state, input, position, end);
+  }
+  if (list.count == 0 && !appendRecord(&list, 0, state)) {
+    free(list.records);
+    return INTERP_ALLOC_ERR;
+  }
+
+  // tree, node 0 being the empty tree
+  run->nodes = NULL;
+  run->capacity = 0;
+  run->used = 0;
+  run->free_list = 0;
+  run->free_count = 0;
+  run->seed = 0x9E3779B97F4A7C15ULL;
+  if (!reserveNodes(run, list.count + 1)) {
+    free(list.records);
+    return INTERP_ALLOC_ERR;
+  }
+  memset(&run->nodes[0], 0, sizeof(RunCheckpoint));
+  run->used = 1;
+  run->root = buildTree(run, &list, 0);
+  run->count = list.count;
+  free(list.records);
+
+  run->fsm = fsm;
+  run->interval = interval;
+  run->length = input_length;
+  run->final_state = state;
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Free Incremental Run
+Actions:
+  • frees the recorded states
+*/
+void freeIncremental(IncrementalRun *run) {
+  if (run == NULL)
+    return;
+
+  free(run->nodes);
+  run->nodes = NULL;
+  run->root = 0;
+  run->count = 0;
+  run->capacity = 0;
+  run->used = 0;
+  run->free_list = 0;
+  run->free_count = 0;
+}
+
+
+/*
+Edit Incremental Run
+Actions:
+  • resumes from the last recorded state at or before the edit, as the input before it is unchanged
+  • steps to each next position to record, every interval symbols, or to compare, the new position of
+    each old recorded state past the edit
+  • stops where the state matches the old one, reusing the old states and final state from there
+  • otherwise runs to the end of the input
+  • splits the tree into the kept states before the edit, the states run past, and the reused states
+    after, frees the states run past, and joins the kept states, the new states and the reused states,
+    setting the gap of the first reused state from the state now before it
+*/
+INTERP_STATUS editIncremental(IncrementalRun *run, const unsigned int *input, size_t offset, size_t removed,
+                              size_t inserted, size_t *stepped) {
+  // validate inputs
+  if (offset > run->length || removed > run->length - offset)
+    return INTERP_SYMB_ERR;
+
+  size_t length = run->length - removed + inserted;
+  size_t position = 0;
+  unsigned int state = 0;
+  size_t resume = findCheckpoint(run, offset, &position, &state);
+  size_t start_position = position;
+
+  // first old state past the edit, its new position is its old one moved by the change in length
+  size_t old = countBefore(run, offset + removed);
+  if (old < resume + 1)
+    old = resume + 1;
+  size_t old_position = 0;
+  size_t old_node = (old < run->count) ? checkpointAt(run, old, &old_position) : 0;
+
+  RecordList list = {NULL, 0, 0};
+  size_t next_record = position + run->interval;
+  int converged = 0;
+  while (position < length) {
+    size_t compare = (old < run->count) ? old_position - removed + inserted : length;
+    size_t end = (next_record < compare) ? next_record : compare;
+    if (end > length)
+      end = length;
+    state = stepRange(run->fsm, state, input, position, end);
+    position = end;
+
+    if (position == compare && old < run->count) {
+      if (run->nodes[old_node].state == state) {
+        converged = 1;
+        break;
+      }
+      old++;
+      if (old < run->count)
+        old_node = checkpointAt(run, old, &old_position);
+    }
+    if (position == next_record && position < length) {
+      if (!appendRecord(&list, position, state)) {
+        free(list.records);
+        return INTERP_ALLOC_ERR;
+      }
+      next_record += run->interval;
+    }
+  }
+
+  // a reused state landing on the state resumed from is the same state
+  if (converged && position == start_position) {
+    old++;
+    if (old < run->count)
+      checkpointAt(run, old, &old_position);
+  }
+  if (!reserveNodes(run, list.count)) {
+    free(list.records);
+    return INTERP_ALLOC_ERR;
+  }
+
+  // splice
+  RunCheckpoint *nodes = run->nodes;
+  size_t kept, rest, passed, reused = 0;
+  splitTree(nodes, run->root, resume + 1, &kept, &rest);
+  if (converged)
+    splitTree(nodes, rest, old - resume - 1, &passed, &reused);
+  else
+    passed = rest;
+  freeNodes(run, passed);
+
+  size_t previous_position = (list.count > 0) ? list.records[list.count - 1].position : start_position;
+  size_t added = buildTree(run, &list, start_position);
+  free(list.records);
+  if (reused != 0) {
+    size_t first, after;
+    splitTree(nodes, reused, 1, &first, &after);
+    nodes[first].gap = old_position - removed + inserted - previous_position;
+    updateNode(nodes, first);
+    reused = mergeTrees(nodes, first, after);
+  }
+  run->root = mergeTrees(nodes, mergeTrees(nodes, kept, added), reused);
+  run->count = nodes[run->root].size;
+
+  run->length = length;
+  if (!converged)
+    run->final_state = state;
+  if (stepped != NULL)
+    *stepped = position - start_position;
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Incremental Result
+Actions:
+  • reads the designation of the final state
+*/
+INTERP_STATUS incrementalResult(const IncrementalRun *run) {
+  if (run->final_state == INCREMENTAL_DEAD)
+    return INTERP_TRANS_ERR;
+  if (run->fsm->Q[run->final_state].type == ACCEPT_STATE)
+    return INTERP_ACCEPT;
+  return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Step Range
+Actions:
+  • steps the input from first to end through the table
+  • a missing transition or invalid symbol enters the dead state, which is never left
+*/
+static unsigned int stepRange(const FSM *fsm, unsigned int state, const unsigned int *input, size_t first,
+                              size_t end) {
+  State **table = fsm->D;
+  size_t symbol_count = fsm->Ec;
+
+  for (size_t i = first; i < end && state != INCREMENTAL_DEAD; i++) {
+    State *next = (input[i] < symbol_count) ? table[(size_t)state * symbol_count + input[i]] : NULL;
+    state = (next != NULL) ? next->id : INCREMENTAL_DEAD;
+  }
+
+  return state;
+}
+
+
+/*
+Append Record
+Actions:
+  • appends a state to record, doubling the list when full
+*/
+static int appendRecord(RecordList *list, size_t position, unsigned int state) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    Record *grown = realloc(list->records, capacity * sizeof(Record));
+    if (grown == NULL)
+      return 0;
+    list->records = grown;
+    list->capacity = capacity;
+  }
+
+  list->records[list->count].position = position;
+  list->records[list->count].state = state;
+  list->count++;
+  return 1;
+}
+
+
+/*
+Reserve Nodes
+Actions:
+  • grows the node pool, at least doubling it, unless enough nodes are unused or free
+  • leaves the tree as it was if the pool cannot grow
+*/
+static int reserveNodes(IncrementalRun *run, size_t needed) {
+  if (needed <= run->capacity - run->used + run->free_count)
+    return 1;
+
+  size_t capacity = run->capacity * 2;
+  if (capacity < run->used + needed)
+    capacity = run->used + needed;
+  RunCheckpoint *grown = realloc(run->nodes, capacity * sizeof(RunCheckpoint));
+  if (grown == NULL)
+    return 0;
+  run->nodes = grown;
+  run->capacity = capacity;
+  return 1;
+}
+
+
+/*
+New Node
+Actions:
+  • takes a free node, or the next unused one, from a pool already reserved
+  • gives it a random priority
+*/
+static size_t newNode(IncrementalRun *run, size_t gap, unsigned int state) {
+  size_t node;
+  if (run->free_list != 0) {
+    node = run->free_list;
+    run->free_list = run->nodes[node].left;
+    run->free_count--;
+  }
+  else
+    node = run->used++;
+
+  run->seed ^= run->seed << 13;
+  run->seed ^= run->seed >> 7;
+  run->seed ^= run->seed << 17;
+
+  RunCheckpoint *checkpoint = &run->nodes[node];
+  checkpoint->gap = gap;
+  checkpoint->span = gap;
+  checkpoint->size = 1;
+  checkpoint->left = 0;
+  checkpoint->right = 0;
+  checkpoint->state = state;
+  checkpoint->priority = (unsigned int)(run->seed >> 32);
+  return node;
+}
+
+
+/*
+Free Nodes
+Actions:
+  • puts every node of a tree on the free list
+*/
+static void freeNodes(IncrementalRun *run, size_t tree) {
+  if (tree == 0)
+    return;
+
+  freeNodes(run, run->nodes[tree].left);
+  freeNodes(run, run->nodes[tree].right);
+  run->nodes[tree].left = run->free_list;
+  run->free_list = tree;
+  run->free_count++;
+}
+
+
+/*
+Build Tree
+Actions:
+  • makes a node per record, its gap from the record before, the first from the previous position
+  • appends each to the tree, from nodes already reserved
+*/
+static size_t buildTree(IncrementalRun *run, const RecordList *list, size_t previous_position) {
+  size_t tree = 0;
+  for (size_t i = 0; i < list->count; i++) {
+    size_t node = newNode(run, list->records[i].position - previous_position, list->records[i].state);
+    previous_position = list->records[i].position;
+    tree = mergeTrees(run->nodes, tree, node);
+  }
+
+  return tree;
+}
+
+
+/*
+Update Node
+Actions:
+  • sums the gaps and counts the states of the node's subtree from its children
+*/
+static void updateNode(RunCheckpoint *nodes, size_t node) {
+  RunCheckpoint *checkpoint = &nodes[node];
+  checkpoint->span = checkpoint->gap + nodes[checkpoint->left].span + nodes[checkpoint->right].span;
+  checkpoint->size = 1 + nodes[checkpoint->left].size + nodes[checkpoint->right].size;
+}
+
+
+/*
+Merge Trees
+Actions:
+  • joins two trees, every state of the left one before every state of the right one
+  • the root of higher priority stays the root
+*/
+static size_t mergeTrees(RunCheckpoint *nodes, size_t left, size_t right) {
+  if (left == 0)
+    return right;
+  if (right == 0)
+    return left;
+
+  if (nodes[left].priority > nodes[right].priority) {
+    nodes[left].right = mergeTrees(nodes, nodes[left].right, right);
+    updateNode(nodes, left);
+    return left;
+  }
+  nodes[right].left = mergeTrees(nodes, left, nodes[right].left);
+  updateNode(nodes, right);
+  return right;
+}
+
+
+/*
+Split Tree
+Actions:
+  • splits a tree into its first rank states and the rest
+*/
+static void splitTree(RunCheckpoint *nodes, size_t tree, size_t rank, size_t *left, size_t *right) {
+  if (tree == 0) {
+    *left = 0;
+    *right = 0;
+    return;
+  }
+
+  size_t inner;
+  size_t left_size = nodes[nodes[tree].left].size;
+  if (rank <= left_size) {
+    splitTree(nodes, nodes[tree].left, rank, left, &inner);
+    nodes[tree].left = inner;
+    updateNode(nodes, tree);
+    *right = tree;
+  }
+  else {
+    splitTree(nodes, nodes[tree].right, rank - left_size - 1, &inner, right);
+    nodes[tree].right = inner;
+    updateNode(nodes, tree);
+    *left = tree;
+  }
+}
+
+
+/*
+Find Checkpoint
+Actions:
+  • descends the tree for the last recorded state at or before the position, summing gaps on the way
+  • returns its rank, and passes back its position and state
+*/
+static size_t findCheckpoint(const IncrementalRun *run, size_t position, size_t *found_position,
+                             unsigned int *state) {
+  const RunCheckpoint *nodes = run->nodes;
+  size_t node = run->root, base = 0, rank = 0, found = 0;
+
+  while (node != 0) {
+    size_t at = base + nodes[nodes[node].left].span + nodes[node].gap;
+    if (at <= position) {
+      found = rank + nodes[nodes[node].left].size;
+      *found_position = at;
+      *state = nodes[node].state;
+      base = at;
+      rank = found + 1;
+      node = nodes[node].right;
+    }
+    else
+      node = nodes[node].left;
+  }
+
+  return found;
+}
+
+
+/*
+Count Before
+Actions:
+  • descends the tree counting the recorded states before the position
+*/
+static size_t countBefore(const IncrementalRun *run, size_t position) {
+  const RunCheckpoint *nodes = run->nodes;
+  size_t node = run->root, base = 0, count = 0;
+
+  while (node != 0) {
+    size_t at = base + nodes[nodes[node].left].span + nodes[node].gap;
+    if (at < position) {
+      count += nodes[nodes[node].left].size + 1;
+      base = at;
+      node = nodes[node].right;
+    }
+    else
+      node = nodes[node].left;
+  }
+
+  return count;
+}
+
+
+/*
+Checkpoint At
+Actions:
+  • descends the tree for the recorded state of a rank, summing gaps on the way
+  • returns its node, and passes back its position
+*/
+static size_t checkpointAt(const IncrementalRun *run, size_t rank, size_t *position) {
+  const RunCheckpoint *nodes = run->nodes;
+  size_t node = run->root, base = 0;
+
+  while (node != 0) {
+    size_t left_size = nodes[nodes[node].left].size;
+    if (rank < left_size) {
+      node = nodes[node].left;
+      continue;
+    }
+    base += nodes[nodes[node].left].span + nodes[node].gap;
+    if (rank == left_size) {
+      *position = base;
+      return node;
+    }
+    rank -= left_size + 1;
+    node = nodes[node].right;
+  }
+
+  return 0;
+}
@@ -0,0 +1,158 @@
+// Author: Kevin Imlay
+
+/*
+Incremental runs keep the result of running a machine over a large input up to date as the input is
+edited, without running the whole input again. The state is recorded every interval symbols. After an
+edit, the run resumes from the last recorded state before the edit, and at each recorded position after
+the edit it compares its state with the one recorded there before. Once they match, the rest of the run is
+the same as before and its result is reused, so the cost of an edit is the edit plus the distance until
+the run falls back into step, rather than the whole input.
+
+Incremental runs only recognize, no actions are run. The recorded states are kept in a balanced tree in
+order of position, each holding the gap from the one before rather than its position, so an edit only
+changes the gap of the first reused state after it. The recorded states an edit does not run past are
+not touched, and an edit costs a logarithm of their count on top of the symbols it runs.
+*/
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+State of a run after a missing transition or invalid symbol, it never leaves it.
+*/
+#define INCREMENTAL_DEAD 0xFFFFFFFFu
+
+
+/* ----- Structures ----- */
+
+/*
+Recorded state at a position of the input, a node of a treap in order of position. Node 0 is the empty
+tree.
+*/
+typedef struct {
+  // symbols from the recorded state before, the position of the first
+  size_t gap;
+
+  // sum of the gaps, and count of recorded states, of the subtree
+  size_t span;
+  size_t size;
+
+  // children, 0 for none, the next free node in the left child of a free node
+  size_t left;
+  size_t right;
+
+  unsigned int state;
+  unsigned int priority;
+} RunCheckpoint;
+
+
+/*
+Incremental run of a machine over an input.
+*/
+typedef struct {
+  FSM *fsm;
+
+  // symbols between recorded states
+  unsigned int interval;
+
+  // recorded states, a tree of nodes in order of position, the first at position 0
+  RunCheckpoint *nodes;
+  size_t root;
+  size_t count;
+
+  // nodes allocated, nodes ever used, and the list of nodes freed since, linked by left child
+  size_t capacity;
+  size_t used;
+  size_t free_list;
+  size_t free_count;
+
+  // xorshift state for node priorities
+  unsigned long long seed;
+
+  // length of the input, and the state at its end
+  size_t length;
+  unsigned int final_state;
+
+} IncrementalRun;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Incremental Run
+Runs a machine over an input from its start state, recording the state every interval symbols.
+
+Arguments:
+  • run - pointer to the incremental run to initialize.
+  • fsm - pointer to the fsm.
+      Note: must not be changed while the run is in use.
+  • interval - symbols between recorded states, larger uses less memory, smaller makes edits cheaper.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - length of the input array.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_ALLOC_ERR - if needed memory was not able to be allocated.
+  • INTERP_SYMB_ERR - if the interval is 0.
+  • INTERP_NO_MACHINE - if the machine is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS initIncremental(IncrementalRun *run, FSM *fsm, unsigned int interval, const unsigned int *input,
+                              size_t input_length);
+
+
+/*
+Free Incremental Run
+Releases the recorded states of a run.
+
+Arguments:
+  • run - pointer to the incremental run.
+      Note: may be null.
+*/
+void freeIncremental(IncrementalRun *run);
+
+
+/*
+Edit Incremental Run
+Brings the run up to date with an edit of its input: removed symbols were replaced by inserted symbols at
+an offset.
+
+Arguments:
+  • run - pointer to the incremental run.
+  • input - array of unsigned integers, the whole input after the edit.
+  • offset - position of the edit.
+  • removed - count of symbols removed at the offset.
+  • inserted - count of symbols inserted at the offset.
+  • stepped - [pass back] count of symbols run again, may be null.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_ALLOC_ERR - if needed memory was not able to be allocated, the run is left as it was.
+  • INTERP_SYMB_ERR - if the edit is not within the input.
+*/
+INTERP_STATUS editIncremental(IncrementalRun *run, const unsigned int *input, size_t offset, size_t removed,
+                              size_t inserted, size_t *stepped);
+
+
+/*
+Incremental Result
+Gets the result of running the machine over the current input.
+
+Arguments:
+  • run - pointer to the incremental run.
+
+Returns:
+  • INTERP_ACCEPT - if the input ends in an accepting state.
+  • INTERP_NO_ACCEPT - if the input ends in a state that is not accepting.
+  • INTERP_TRANS_ERR - if the input has a missing transition or an invalid symbol.
+*/
+INTERP_STATUS incrementalResult(const IncrementalRun *run);
+
+#endif
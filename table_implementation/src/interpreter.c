@@ -30,6 +30,8 @@ INTERP_STATUS initInterpreter(Interpreter *interp, FSM *machine) {
   // fill interpreter
   interp->current_state = machine->Qs;
   interp->fsm = machine;
+  interp->position = 0;
+  interp->streaming = 0;
 
   // successful
   return INTERP_OK;
@@ -76,7 +78,7 @@ INTERP_STATUS transition(Interpreter *interp, unsigned int symbol, State **new_s
 
   // perform transition
   unsigned int current_state_id = interp->current_state->id;
-  *new_state = interp->fsm->D[current_state_id * interp->fsm->Ec + symbol];
+  *new_state = interp->fsm->D[(size_t)current_state_id * interp->fsm->Ec + symbol];
   if (*new_state == NULL) {
     // TODO: define behavior for if transition is invalid
     printf("  :::: Invalid transition out of state %d on symbol %d!\n  :::: Further behavior is undefined!\n", current_state_id, symbol);
@@ -84,6 +86,7 @@ INTERP_STATUS transition(Interpreter *interp, unsigned int symbol, State **new_s
     return INTERP_TRANS_ERR;
   }
   interp->current_state = *new_state;
+  interp->position++;
 
   // successful
   return INTERP_OK;
@@ -112,7 +115,7 @@ INTERP_STATUS runInterpreter(Interpreter *interp, unsigned int *input, unsigned
     return interp_status;
 
   // for each input, transition and run action
-  for (int i = 0; i < input_length; i++) {
+  for (unsigned int i = 0; i < input_length; i++) {
     interp_status = transition(interp, input[i], &current_state);
     if (interp_status != INTERP_OK)
       return interp_status;
@@ -122,6 +125,179 @@ INTERP_STATUS runInterpreter(Interpreter *interp, unsigned int *input, unsigned
       return interp_status;
   }
 
+  // check accept state (the interpreter's, as there may have been no input)
+  if (interp->current_state->type == ACCEPT_STATE)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/*
+Begin Stream
+Actions:
+  • runs the action of the current state
+  • marks the stream as open
+*/
+INTERP_STATUS beginInterpreter(Interpreter *interp) {
+  INTERP_STATUS interp_status;
+
+  // validate input
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL)
+    return INTERP_NO_MACHINE;
+
+  // run action in current state
+  interp_status = runState(interp);
+  if (interp_status != INTERP_OK)
+    return interp_status;
+
+  interp->streaming = 1;
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Feed Stream
+Actions:
+  • input each symbol of the chunk into the machine, running action on each state.
+  • the table and symbol count are read once per chunk rather than once per symbol.
+  • failing symbols are handed to transition() to report the error.
+*/
+INTERP_STATUS feedInterpreter(Interpreter *interp, unsigned int *chunk, unsigned int chunk_length) {
+  // validate input
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL)
+    return INTERP_NO_MACHINE;
+  if (!interp->streaming)
+    return INTERP_NOT_STARTED;
+
+  State **table = interp->fsm->D;
+  unsigned int symbol_count = interp->fsm->Ec;
+  State *current_state = interp->current_state;
+
+  // for each input, transition and run action
+  for (unsigned int i = 0; i < chunk_length; i++) {
+    State *next_state = NULL;
+    if (chunk[i] < symbol_count)
+      next_state = table[(size_t)current_state->id * symbol_count + chunk[i]];
+    if (next_state == NULL)
+      return transition(interp, chunk[i], &next_state);
+
+    current_state = next_state;
+    interp->current_state = current_state;
+    interp->position++;
+    if (current_state->action != NULL)
+      (*current_state->action)();
+  }
+
+  // report accept status so far
+  if (current_state->type == ACCEPT_STATE)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/*
+End Stream
+Actions:
+  • marks the stream as closed
+  • reports accept status of the current state
+*/
+INTERP_STATUS endInterpreter(Interpreter *interp) {
+  // validate input
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (!interp->streaming)
+    return INTERP_NOT_STARTED;
+
+  interp->streaming = 0;
+
+  // check accept state
+  if (interp->current_state->type == ACCEPT_STATE)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/*
+Run Totalized Input
+Actions:
+  • runs the action in the start state
+  • for each block of symbols, finds the first invalid symbol and steps up to it, running the action
+      of each state without checking the state transitioned to
+  • at the end of each block, checks for the sink state and walks the block again to find where it
+      was entered
+*/
+INTERP_STATUS runTotalized(Interpreter *interp, unsigned int *input, unsigned int input_length,
+                           unsigned int *sink_position) {
+  INTERP_STATUS interp_status;
+
+  // validate input
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL)
+    return INTERP_NO_MACHINE;
+  if (interp->fsm->Qsink == NULL)
+    return INTERP_MACHINE_NOT_TOTAL;
+
+  // run action in start state
+  interp_status = runState(interp);
+  if (interp_status != INTERP_OK)
+    return interp_status;
+
+  State **table = interp->fsm->D;
+  unsigned int symbol_count = interp->fsm->Ec;
+  State *sink = interp->fsm->Qsink;
+  State *current_state = interp->current_state;
+  size_t start_position = interp->position;
+
+  for (unsigned int block = 0; block < input_length; block += TOTAL_CHECK_INTERVAL) {
+    unsigned int end = (input_length - block > TOTAL_CHECK_INTERVAL) ? block + TOTAL_CHECK_INTERVAL : input_length;
+
+    // range check the whole block at once, stepping only up to the first invalid symbol
+    unsigned int largest = 0;
+    for (unsigned int i = block; i < end; i++)
+      largest = (input[i] > largest) ? input[i] : largest;
+    unsigned int stop = end;
+    if (largest >= symbol_count) {
+      stop = block;
+      while (input[stop] < symbol_count)
+        stop++;
+    }
+
+    // step, every transition exists
+    State *block_state = current_state;
+    for (unsigned int i = block; i < stop; i++) {
+      current_state = table[(size_t)current_state->id * symbol_count + input[i]];
+      if (current_state->action != NULL)
+        (*current_state->action)();
+    }
+
+    // find where the sink state was entered
+    if (current_state == sink) {
+      unsigned int i = block;
+      State *state = block_state;
+      while (table[(size_t)state->id * symbol_count + input[i]] != sink)
+        state = table[(size_t)state->id * symbol_count + input[i++]];
+      interp->current_state = state;
+      interp->position = start_position + i;
+      *sink_position = i;
+      return INTERP_TRANS_ERR;
+    }
+
+    interp->current_state = current_state;
+    interp->position = start_position + stop;
+    if (stop < end)
+      return INTERP_SYMB_ERR;
+  }
+
   // check accept state
   if (current_state->type == ACCEPT_STATE)
     return INTERP_ACCEPT;
@@ -12,6 +12,14 @@ The interpreter is what actually runs a state machine.
 #include "fsm.h"
 
 
+/* ----- Definitions ----- */
+
+/*
+Symbols stepped by runTotalized() between checks for the sink state.
+*/
+#define TOTAL_CHECK_INTERVAL 64
+
+
 /* ----- Enumerations ----- */
 
 /*
@@ -28,7 +36,10 @@ typedef enum {
   INTERP_MACHINE_NOT_INIT,
   INTERP_MACHINE_NO_START,
   INTERP_ACCEPT,
-  INTERP_NO_ACCEPT
+  INTERP_NO_ACCEPT,
+  INTERP_NOT_STARTED,
+  INTERP_MACHINE_NOT_TOTAL,
+  INTERP_ENCODING_ERR
 } INTERP_STATUS;
 
 
@@ -40,6 +51,12 @@ Interpreter (table-based).
 typedef struct {
   State *current_state;
   FSM *fsm;
+
+  // count of symbols transitioned on since the interpreter was initialized
+  size_t position;
+
+  // set while a stream is open (between beginInterpreter() and endInterpreter())
+  int streaming;
 } Interpreter;
 
 
@@ -125,4 +142,96 @@ Returns:
 INTERP_STATUS runInterpreter(Interpreter *interp, unsigned int *input, unsigned int input_length);
 
 
+/*
+Begin Stream
+Opens a stream of input on the interpreter. Runs the action of the current state once, then input can be
+fed in chunks with feedInterpreter().
+
+Arguments:
+  • interp - pointer to the interpreter.
+      Note: must not be null.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null (not initialized).
+*/
+INTERP_STATUS beginInterpreter(Interpreter *interp);
+
+
+/*
+Feed Stream
+Inputs the next chunk of a stream. Each symbol is transitioned on and the new state's action is run, the
+same as runInterpreter(), but the action of the state the chunk starts in is not run again.
+
+Arguments:
+  • interp - pointer to the interpreter.
+      Note: must not be null.
+  • chunk - array of unsigned integers as symbol inputs.
+  • chunk_length - unsigned integer length of the chunk array.
+      Note: may be 0, to query the accept status.
+
+Returns:
+  • INTERP_ACCEPT - if the input so far ends in a final state.
+  • INTERP_NO_ACCEPT - if the input so far does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+      Note: on either error the interpreter's position is that of the failing symbol.
+  • INTERP_NOT_STARTED - if no stream is open on the interpreter.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null (not initialized).
+*/
+INTERP_STATUS feedInterpreter(Interpreter *interp, unsigned int *chunk, unsigned int chunk_length);
+
+
+/*
+End Stream
+Closes the stream open on the interpreter.
+
+Arguments:
+  • interp - pointer to the interpreter.
+      Note: must not be null.
+
+Returns:
+  • INTERP_ACCEPT - if the stream ends in a final state.
+  • INTERP_NO_ACCEPT - if the stream does not end in a final state.
+  • INTERP_NOT_STARTED - if no stream is open on the interpreter.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+*/
+INTERP_STATUS endInterpreter(Interpreter *interp);
+
+
+/*
+Interpret Totalized Input Sequence
+Runs the interpreter on the given input sequence, the same as runInterpreter(), on a machine totalized
+with totalizeFSM(). Every transition of a totalized machine exists, so symbols are stepped without
+checking the state transitioned to, and the sink state is only checked for every TOTAL_CHECK_INTERVAL
+symbols and at the end of the input.
+When the sink state has been entered, the block it was entered in is walked again without actions to
+find where. The sink state has no action, so the actions run are the same as runInterpreter()'s.
+
+Arguments:
+  • interp - pointer to the interpreter.
+      Note: must not be null.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+  • sink_position - [pass back] index in the input of the symbol that entered the sink state.
+      Note: must not be null.
+      Note: only written when INTERP_TRANS_ERR is returned.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided enters the sink state.
+      Note: on either error the interpreter is left in the state before the failing symbol, as with
+      transition().
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null (not initialized).
+  • INTERP_MACHINE_NOT_TOTAL - if the machine has not been totalized.
+*/
+INTERP_STATUS runTotalized(Interpreter *interp, unsigned int *input, unsigned int input_length,
+                           unsigned int *sink_position);
+
+
 #endif
@@ -0,0 +1,197 @@
+// Author: Kevin Imlay
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define PACKED_BMI2
+#endif
+
+#include "cpu.h"
+#include "packed.h"
+
+/* ----- Private Function Prototypes ----- */
+
+static INTERP_STATUS walkScalar(const PackedTable *table, const unsigned int *input, unsigned int input_length,
+                                unsigned int *end_state);
+#ifdef PACKED_BMI2
+static INTERP_STATUS walkBMI2(const PackedTable *table, const unsigned int *input, unsigned int input_length,
+                              unsigned int *end_state);
+#endif
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Packed Table
+Actions:
+  • find the fewest bits that hold every state ID and the missing transition
+  • allocate the packed words and accepting bitmap
+  • write each field, splitting it across two words where it straddles them
+*/
+FSM_STATUS initPackedTable(PackedTable *table, FSM *fsm) {
+  // validate inputs
+  if (table == NULL || fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+
+  unsigned int bits = 1;
+  while ((1ULL << bits) < (unsigned long long)fsm->Qc + 1)
+    bits++;
+
+  size_t cells = (size_t)fsm->Qc * fsm->Ec;
+  if (cells > (SIZE_MAX - 127) / bits)
+    return FSM_SIZE_ERR;
+
+  // allocate
+  table->word_count = (cells * bits + 63) / 64 + 1;
+  table->words = calloc(table->word_count, sizeof(unsigned long long));
+  table->accept = calloc(((size_t)fsm->Qc + 63) / 64, sizeof(unsigned long long));
+  if (table->words == NULL || table->accept == NULL) {
+    freePackedTable(table);
+    return FSM_ALLOC_ERR;
+  }
+
+  // pack fields
+  table->bits = bits;
+  table->mask = (1ULL << bits) - 1;
+  for (size_t cell = 0; cell < cells; cell++) {
+    unsigned long long field = (fsm->D[cell] == NULL) ? table->mask : fsm->D[cell]->id;
+    size_t offset = cell * bits;
+    unsigned int shift = offset & 63;
+
+    table->words[offset >> 6] |= field << shift;
+    if (shift + bits > 64)
+      table->words[(offset >> 6) + 1] |= field >> (64 - shift);
+  }
+
+  // accepting and start states
+  for (unsigned int state = 0; state < fsm->Qc; state++)
+    if (fsm->Q[state].type == ACCEPT_STATE)
+      table->accept[state >> 6] |= 1ULL << (state & 63);
+
+  table->Qc = fsm->Qc;
+  table->Ec = fsm->Ec;
+  table->start = (fsm->Qs == NULL) ? TABLE_NO_STATE : fsm->Qs->id;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Packed Table
+Actions:
+  • free the packed words and accepting bitmap
+*/
+void freePackedTable(PackedTable *table) {
+  if (table == NULL)
+    return;
+
+  free(table->words);
+  free(table->accept);
+  table->words = NULL;
+  table->accept = NULL;
+}
+
+
+/*
+Recognize Packed
+Actions:
+  • walk the packed table from the start state, with BMI2 when the CPU supports it
+  • check the accepting bitmap for the final state
+*/
+INTERP_STATUS recognizePacked(const PackedTable *table, const unsigned int *input, unsigned int input_length) {
+  // validate inputs
+  if (table == NULL || table->words == NULL)
+    return INTERP_NO_MACHINE;
+  if (table->start == TABLE_NO_STATE)
+    return INTERP_MACHINE_NO_START;
+
+  unsigned int state;
+  INTERP_STATUS interp_status;
+#ifdef PACKED_BMI2
+  if (cpuHasBMI2())
+    interp_status = walkBMI2(table, input, input_length, &state);
+  else
+#endif
+    interp_status = walkScalar(table, input, input_length, &state);
+  if (interp_status != INTERP_OK)
+    return interp_status;
+
+  // check accept state
+  if ((table->accept[state >> 6] >> (state & 63)) & 1)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Walk Scalar
+Actions:
+  • steps through the input, reading each field from the two words it may straddle
+*/
+static INTERP_STATUS walkScalar(const PackedTable *table, const unsigned int *input, unsigned int input_length,
+                                unsigned int *end_state) {
+  const unsigned long long *words = table->words;
+  const unsigned long long mask = table->mask;
+  const size_t symbol_count = table->Ec;
+  const size_t bits = table->bits;
+  unsigned long long state = table->start;
+
+  for (unsigned int i = 0; i < input_length; i++) {
+    if (input[i] >= symbol_count)
+      return INTERP_SYMB_ERR;
+
+    size_t offset = ((size_t)state * symbol_count + input[i]) * bits;
+    const unsigned long long *word = words + (offset >> 6);
+    unsigned int shift = offset & 63;
+    state = ((word[0] >> shift) | ((word[1] << 1) << (63 - shift))) & mask;
+    if (state == mask)
+      return INTERP_TRANS_ERR;
+  }
+
+  *end_state = (unsigned int)state;
+  return INTERP_OK;
+}
+
+
+#ifdef PACKED_BMI2
+
+/*
+Walk BMI2
+Actions:
+  • steps through the input, loading the 8 bytes each field starts in
+  • fields are at most 32 bits and start within the first byte, so they are always in the 8 bytes
+  • cuts the field out with shrx and bzhi
+*/
+__attribute__((target("bmi2")))
+static INTERP_STATUS walkBMI2(const PackedTable *table, const unsigned int *input, unsigned int input_length,
+                              unsigned int *end_state) {
+  const unsigned char *bytes = (const unsigned char *)table->words;
+  const unsigned long long mask = table->mask;
+  const size_t symbol_count = table->Ec;
+  const size_t bits = table->bits;
+  unsigned long long state = table->start;
+
+  for (unsigned int i = 0; i < input_length; i++) {
+    if (input[i] >= symbol_count)
+      return INTERP_SYMB_ERR;
+
+    size_t offset = ((size_t)state * symbol_count + input[i]) * bits;
+    unsigned long long chunk;
+    memcpy(&chunk, bytes + (offset >> 3), sizeof(chunk));
+    state = _bzhi_u64(chunk >> (offset & 7), (unsigned int)bits);
+    if (state == mask)
+      return INTERP_TRANS_ERR;
+  }
+
+  *end_state = (unsigned int)state;
+  return INTERP_OK;
+}
+
+#endif
@@ -0,0 +1,130 @@
+// Author: Kevin Imlay
+
+/*
+The packed table stores the next state ID of every field of the transition table in exactly as many bits
+as needed to tell the states and the missing transition apart, ceil(log2(Qc + 1)) bits, rather than in a
+whole 32-bit word. Fields are packed end to end into 64-bit words, so a field may straddle two words. A
+600 state machine needs 10 bits per field, so its table is a third the size of the state table and fits
+caches the state table does not.
+
+A field is read from the two words it may straddle with shifts and a mask. When the CPU supports BMI2,
+recognizePacked() instead loads the 8 bytes the field starts in and cuts the field out with shrx and bzhi.
+
+Like the state table, the packed table is a snapshot of the FSM it was built from.
+*/
+
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Structures ----- */
+
+/*
+Bit-packed transition table.
+*/
+typedef struct {
+  // count of states in the machine
+  unsigned int Qc;
+
+  // count of input alphabet symbols
+  unsigned int Ec;
+
+  // bits per field
+  unsigned int bits;
+
+  // all ones in the low bits of a field, the field value of a missing transition
+  unsigned long long mask;
+
+  // fields packed end to end, with a word of padding at the end
+  unsigned long long *words;
+
+  // count of words, including padding
+  size_t word_count;
+
+  // bitmap of accepting states, one bit per state ID
+  unsigned long long *accept;
+
+  // ID of the starting state
+  unsigned int start;
+
+} PackedTable;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Packed Table
+Packs the transition table of a FSM.
+
+Arguments:
+  • table - pointer to the packed table to initialize.
+  • fsm - pointer to an initialized FSM.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if the packed table's size overflows.
+  • FSM_NO_MACHINE - either the table or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initPackedTable(PackedTable *table, FSM *fsm);
+
+
+/*
+Free Packed Table
+Releases the memory held by a packed table.
+
+Arguments:
+  • table - pointer to the packed table.
+      Note: may be null.
+*/
+void freePackedTable(PackedTable *table);
+
+
+/*
+Recognize Packed
+Runs the input from the machine's start state without running any actions, the same as
+recognizeInput() on a state table.
+
+Arguments:
+  • table - pointer to the packed table.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+  • INTERP_NO_MACHINE - if the table provided is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS recognizePacked(const PackedTable *table, const unsigned int *input, unsigned int input_length);
+
+
+/*
+Packed Next
+Looks up the state transitioned to from a state on a symbol, with shifts and a mask.
+
+Arguments:
+  • table - pointer to the packed table.
+  • state_id - ID of the state, must be less than the table's state count.
+  • symbol - symbol, must be less than the table's symbol count.
+
+Returns:
+  • ID of the state transitioned to, or TABLE_NO_STATE if there is no transition.
+*/
+static inline unsigned int packedNext(const PackedTable *table, unsigned int state_id, unsigned int symbol) {
+  size_t offset = ((size_t)state_id * table->Ec + symbol) * table->bits;
+  const unsigned long long *word = table->words + (offset >> 6);
+  unsigned int shift = offset & 63;
+
+  // the second word's bits are shifted up in two steps, so a shift of 0 does not shift by 64
+  unsigned long long field = ((word[0] >> shift) | ((word[1] << 1) << (63 - shift))) & table->mask;
+  return (field == table->mask) ? TABLE_NO_STATE : (unsigned int)field;
+}
+
+#endif
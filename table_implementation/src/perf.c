@@ -0,0 +1,218 @@
+// Author: Kevin Imlay
+
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_LINUX
+#endif
+
+#include "perf.h"
+
+/* ----- Private Variables ----- */
+
+/*
+Names of the events, by index.
+*/
+static const char *event_names[PERF_EVENT_COUNT] = {
+  "cycles", "instructions", "L1D misses", "LLC misses", "branch misses", "dTLB misses", "page faults"
+};
+
+
+/* ----- Private Function Prototypes ----- */
+
+static int openCounter(unsigned int event);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Performance Counters
+Actions:
+  • opens each event's counter on its own, leaving the ones that fail closed
+*/
+unsigned int initPerfCounters(PerfCounters *counters) {
+  counters->open_count = 0;
+  for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++) {
+    counters->fds[event] = openCounter(event);
+    counters->values[event] = 0;
+    counters->counted[event] = 0;
+    if (counters->fds[event] >= 0)
+      counters->open_count++;
+  }
+
+  return counters->open_count;
+}
+
+
+/*
+Free Performance Counters
+Actions:
+  • closes each open counter
+*/
+void freePerfCounters(PerfCounters *counters) {
+  if (counters == NULL)
+    return;
+
+  for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++) {
+#ifdef PERF_LINUX
+    if (counters->fds[event] >= 0)
+      close(counters->fds[event]);
+#endif
+    counters->fds[event] = -1;
+  }
+  counters->open_count = 0;
+}
+
+
+/*
+Start Performance Counters
+Actions:
+  • resets then enables each open counter
+*/
+void startPerfCounters(PerfCounters *counters) {
+#ifdef PERF_LINUX
+  for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++) {
+    if (counters->fds[event] < 0)
+      continue;
+    ioctl(counters->fds[event], PERF_EVENT_IOC_RESET, 0);
+    ioctl(counters->fds[event], PERF_EVENT_IOC_ENABLE, 0);
+  }
+#else
+  (void)counters;
+#endif
+}
+
+
+/*
+Stop Performance Counters
+Actions:
+  • disables each open counter, then reads its count with the time it was enabled and running
+  • scales the count up by enabled over running time, for counters the kernel multiplexed
+  • marks a counter with no running time as not counted, as it has no count to scale
+*/
+void stopPerfCounters(PerfCounters *counters) {
+#ifdef PERF_LINUX
+  for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++)
+    if (counters->fds[event] >= 0)
+      ioctl(counters->fds[event], PERF_EVENT_IOC_DISABLE, 0);
+
+  for (unsigned int event = 0; event < PERF_EVENT_COUNT; event++) {
+    counters->values[event] = 0;
+    counters->counted[event] = 0;
+    unsigned long long read_values[3];
+    if (counters->fds[event] < 0 || read(counters->fds[event], read_values, sizeof(read_values)) != sizeof(read_values))
+      continue;
+    if (read_values[2] == 0)
+      continue;
+    if (read_values[2] < read_values[1])
+      read_values[0] = (unsigned long long)((double)read_values[0] * (double)read_values[1] / (double)read_values[2]);
+    counters->values[event] = read_values[0];
+    counters->counted[event] = 1;
+  }
+#else
+  (void)counters;
+#endif
+}
+
+
+/*
+Performance Counter Open
+Actions:
+  • checks the event's file descriptor
+*/
+int perfCounterOpen(const PerfCounters *counters, unsigned int event) {
+  return event < PERF_EVENT_COUNT && counters->fds[event] >= 0;
+}
+
+
+/*
+Per Symbol
+Actions:
+  • divides the event's count by the symbols, if the event was counted
+*/
+double perfPerSymbol(const PerfCounters *counters, unsigned int event, unsigned long long symbols) {
+  if (!perfCounterOpen(counters, event) || !counters->counted[event] || symbols == 0)
+    return -1.0;
+  return (double)counters->values[event] / (double)symbols;
+}
+
+
+/*
+Event Name
+Actions:
+  • looks up the name by index
+*/
+const char *perfEventName(unsigned int event) {
+  return (event < PERF_EVENT_COUNT) ? event_names[event] : "unknown";
+}
+
+
+/*
+Run Measured
+Actions:
+  • starts the counters, runs the interpreter and stops them
+*/
+INTERP_STATUS runMeasured(Interpreter *interp, PerfCounters *counters, unsigned int *input,
+                          unsigned int input_length) {
+  startPerfCounters(counters);
+  INTERP_STATUS status = runInterpreter(interp, input, input_length);
+  stopPerfCounters(counters);
+
+  return status;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Open Counter
+Actions:
+  • describes the event, counting user space only on the calling thread on any CPU, stopped
+  • opens it close on exec, so programs the caller runs do not inherit it
+  • asks for the enabled and running times with each read, to scale multiplexed counts
+*/
+static int openCounter(unsigned int event) {
+#ifdef PERF_LINUX
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  unsigned long long read_miss = ((unsigned long long)PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 ((unsigned long long)PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  if (event == PERF_CYCLES) {
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+  } else if (event == PERF_INSTRUCTIONS) {
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  } else if (event == PERF_L1D_MISSES) {
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+  } else if (event == PERF_LLC_MISSES) {
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_LL | read_miss;
+  } else if (event == PERF_BRANCH_MISSES) {
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+  } else if (event == PERF_DTLB_MISSES) {
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+  } else {
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+  }
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+#else
+  (void)event;
+  return -1;
+#endif
+}
@@ -0,0 +1,167 @@
+// Author: Kevin Imlay
+
+/*
+Performance counters count hardware events, such as cycles, cache misses and branch mispredicts, while an
+interpreter runs, to tell what limits a slow run without attaching a profiler. They are opened with
+perf_event_open() on Linux, counting only the calling thread in user space, and read around a run, so
+they count the run and nothing else. Rates are given per symbol.
+
+Each counter is opened on its own, so a counter the processor, kernel or permissions do not allow is
+left closed and the rest still count. Virtual machines often expose no hardware counters at all, and the
+page fault counter, counted by the kernel, is then the only one open. On other systems no counter opens.
+*/
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Events counted, indices into a counter set.
+*/
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_L1D_MISSES 2
+#define PERF_LLC_MISSES 3
+#define PERF_BRANCH_MISSES 4
+#define PERF_DTLB_MISSES 5
+#define PERF_PAGE_FAULTS 6
+#define PERF_EVENT_COUNT 7
+
+
+/* ----- Structures ----- */
+
+/*
+Set of counters, one per event.
+*/
+typedef struct {
+  // file descriptor of each counter, -1 if it could not be opened
+  int fds[PERF_EVENT_COUNT];
+
+  // count of each event over the last measured span, scaled up if the counter was not always scheduled
+  unsigned long long values[PERF_EVENT_COUNT];
+
+  // whether each counter was scheduled at all over the last measured span, its value is 0 if not
+  int counted[PERF_EVENT_COUNT];
+
+  // count of counters open
+  unsigned int open_count;
+
+} PerfCounters;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Performance Counters
+Opens a counter for each event on the calling thread, stopped.
+
+Arguments:
+  • counters - pointer to the counter set to initialize.
+      Note: counts only the thread that calls this.
+
+Returns:
+  • count of counters opened, 0 if performance counters are not available.
+*/
+unsigned int initPerfCounters(PerfCounters *counters);
+
+
+/*
+Free Performance Counters
+Closes the counters.
+
+Arguments:
+  • counters - pointer to the counter set.
+      Note: may be null.
+*/
+void freePerfCounters(PerfCounters *counters);
+
+
+/*
+Start Performance Counters
+Zeroes the open counters and starts them.
+
+Arguments:
+  • counters - pointer to the counter set.
+*/
+void startPerfCounters(PerfCounters *counters);
+
+
+/*
+Stop Performance Counters
+Stops the open counters and reads their counts into the set's values.
+A counter the kernel never scheduled in the span, as when more are open than the processor can count at
+once, is marked as not counted rather than read as a count of 0.
+
+Arguments:
+  • counters - pointer to the counter set.
+*/
+void stopPerfCounters(PerfCounters *counters);
+
+
+/*
+Performance Counter Open
+Gets whether an event is counted.
+
+Arguments:
+  • counters - pointer to the counter set.
+  • event - index of the event, PERF_CYCLES to PERF_PAGE_FAULTS.
+
+Returns:
+  • 1 - if the event's counter is open.
+  • 0 - if not.
+*/
+int perfCounterOpen(const PerfCounters *counters, unsigned int event);
+
+
+/*
+Per Symbol
+Gets the count of an event over the last measured span, per symbol.
+
+Arguments:
+  • counters - pointer to the counter set.
+  • event - index of the event.
+  • symbols - count of symbols in the span.
+
+Returns:
+  • the count per symbol.
+  • a negative value - if the event is not counted, was not scheduled in the span, or no symbols were given.
+*/
+double perfPerSymbol(const PerfCounters *counters, unsigned int event, unsigned long long symbols);
+
+
+/*
+Event Name
+Gets a short name of an event, for reports.
+
+Arguments:
+  • event - index of the event.
+
+Returns:
+  • the name, or "unknown".
+*/
+const char *perfEventName(unsigned int event);
+
+
+/*
+Run Measured
+Runs the interpreter on the input, the same as runInterpreter(), with the counters counting only the run.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • counters - pointer to a counter set opened on the calling thread.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+
+Returns:
+  • the status runInterpreter() returns.
+*/
+INTERP_STATUS runMeasured(Interpreter *interp, PerfCounters *counters, unsigned int *input,
+                          unsigned int input_length);
+
+#endif
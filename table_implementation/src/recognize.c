@@ -0,0 +1,114 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+
+#include "recognize.h"
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Recognize Input
+Actions:
+  • walk the table from the start state
+  • check the accepting bitmap for the final state
+*/
+INTERP_STATUS recognizeInput(const StateTable *table, const unsigned int *input, unsigned int input_length) {
+  // validate inputs
+  if (table == NULL || table->next == NULL)
+    return INTERP_NO_MACHINE;
+  if (table->start == TABLE_NO_STATE)
+    return INTERP_MACHINE_NO_START;
+
+  const unsigned int *next = table->next;
+  const unsigned int symbol_count = table->Ec;
+  unsigned int state = table->start;
+
+  for (unsigned int i = 0; i < input_length; i++) {
+    if (input[i] >= symbol_count)
+      return INTERP_SYMB_ERR;
+    state = next[(size_t)state * symbol_count + input[i]];
+    if (state == TABLE_NO_STATE)
+      return INTERP_TRANS_ERR;
+  }
+
+  // check accept state
+  if (isAccepting(table, state))
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/*
+Run Deferred
+Actions:
+  • walk the table from the interpreter's current state, recording each state entered
+  • move the interpreter to the last state entered
+*/
+INTERP_STATUS runDeferred(Interpreter *interp, const StateTable *table, const unsigned int *input,
+                          unsigned int input_length, unsigned int *entered, unsigned int capacity,
+                          unsigned int *entered_count) {
+  INTERP_STATUS interp_status = INTERP_OK;
+
+  // validate inputs
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL || table == NULL || table->next == NULL)
+    return INTERP_NO_MACHINE;
+  if (table->Qc != interp->fsm->Qc || table->Ec != interp->fsm->Ec)
+    return INTERP_NO_MACHINE;
+
+  const unsigned int *next = table->next;
+  const unsigned int symbol_count = table->Ec;
+  unsigned int length = (input_length < capacity) ? input_length : capacity;
+  unsigned int state = interp->current_state->id;
+  unsigned int i = 0;
+
+  for (; i < length; i++) {
+    if (input[i] >= symbol_count) {
+      interp_status = INTERP_SYMB_ERR;
+      break;
+    }
+    unsigned int next_state = next[(size_t)state * symbol_count + input[i]];
+    if (next_state == TABLE_NO_STATE) {
+      interp_status = INTERP_TRANS_ERR;
+      break;
+    }
+    state = next_state;
+    entered[i] = state;
+  }
+
+  *entered_count = i;
+  interp->current_state = &interp->fsm->Q[state];
+  interp->position += i;
+  if (interp_status != INTERP_OK)
+    return interp_status;
+
+  // check accept state
+  if (isAccepting(table, state))
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/*
+Run Deferred Actions
+Actions:
+  • call each recorded state's action, if applicable
+*/
+INTERP_STATUS runDeferredActions(Interpreter *interp, const unsigned int *entered, unsigned int entered_count) {
+  // validate inputs
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL)
+    return INTERP_NO_MACHINE;
+
+  const State *states = interp->fsm->Q;
+  for (unsigned int i = 0; i < entered_count; i++)
+    if (states[entered[i]].action != NULL)
+      (*states[entered[i]].action)();
+
+  // successful
+  return INTERP_OK;
+}
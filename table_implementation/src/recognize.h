@@ -0,0 +1,89 @@
+// Author: Kevin Imlay
+
+/*
+Recognition runs a machine without dispatching actions from the table walk. runInterpreter() calls each
+state's action as soon as the state is entered, which puts an indirect call in the middle of every step.
+Two modes are offered instead:
+  • recognize only - only the accept status of the input is wanted, no actions are run at all and the
+      accepting states are read from the state table's bitmap,
+  • deferred actions - the walk records the ID of every state entered into a buffer, and the actions are
+      run afterwards from the buffer in one batch.
+*/
+
+#ifndef RECOGNIZE_H
+#define RECOGNIZE_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Recognize Input
+Runs the input from the machine's start state without running any actions.
+
+Arguments:
+  • table - pointer to the state table of the machine.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+  • INTERP_NO_MACHINE - if the table provided is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS recognizeInput(const StateTable *table, const unsigned int *input, unsigned int input_length);
+
+
+/*
+Run Deferred
+Runs the input from the interpreter's current state, recording each state entered instead of running
+its action. The interpreter is left in the last state entered.
+Note: the action of the current state is not run or recorded, as with runInterpreter() use runState()
+  first if it is wanted.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • table - pointer to the state table of the interpreter's machine.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+  • entered - [pass back] array of the IDs of the states entered, in order.
+  • capacity - length of the entered array.
+      Note: at most this many symbols are input, call again with the rest of the input to continue.
+  • entered_count - [pass back] count of symbols input and states recorded.
+
+Returns:
+  • INTERP_ACCEPT - if the input so far ends in a final state.
+  • INTERP_NO_ACCEPT - if the input so far does not end in a final state.
+  • INTERP_SYMB_ERR - if a symbol provided is invalid.
+  • INTERP_TRANS_ERR - if a symbol provided does not have a transition out of the current state.
+      Note: on either error the states entered before the failing symbol are recorded.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine or table is null, or the table is not of the machine.
+*/
+INTERP_STATUS runDeferred(Interpreter *interp, const StateTable *table, const unsigned int *input,
+                          unsigned int input_length, unsigned int *entered, unsigned int capacity,
+                          unsigned int *entered_count);
+
+
+/*
+Run Deferred Actions
+Runs the actions of a buffer of entered states, in order.
+
+Arguments:
+  • interp - pointer to the interpreter whose machine the states belong to.
+  • entered - array of state IDs from runDeferred().
+  • entered_count - count of state IDs in the array.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null (not initialized).
+*/
+INTERP_STATUS runDeferredActions(Interpreter *interp, const unsigned int *entered, unsigned int entered_count);
+
+#endif
@@ -0,0 +1,222 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+
+#include "reorder.h"
+
+/* ----- Private Definitions ----- */
+
+#define NO_SUCCESSOR 0xFFFFFFFFu
+
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int pickSuccessor(FSM *fsm, unsigned int state_id, const unsigned long long *counts,
+                                  const unsigned char *placed);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Profile Transitions
+Actions:
+  • walk the input from the start state
+  • count every transition taken
+*/
+FSM_STATUS profileTransitions(FSM *fsm, unsigned int *input, unsigned int input_length,
+                              unsigned long long *counts) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+  if (fsm->Qs == NULL)
+    return FSM_NO_STATE;
+
+  // walk input
+  State *current_state = fsm->Qs;
+  for (unsigned int i = 0; i < input_length; i++) {
+    if (input[i] >= fsm->Ec)
+      break;
+
+    size_t cell = (size_t)current_state->id * fsm->Ec + input[i];
+    if (fsm->D[cell] == NULL)
+      break;
+
+    counts[cell]++;
+    current_state = fsm->D[cell];
+  }
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Order States
+Actions:
+  • place the start state first
+  • traverse the machine, giving each state the next ID when it is first reached
+  • place unreached states last
+*/
+FSM_STATUS orderStates(FSM *fsm, ORDER_METHOD method, const unsigned long long *counts,
+                       unsigned int *old_to_new) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+  if (fsm->Qs == NULL)
+    return FSM_NO_STATE;
+  if (method != ORDER_BFS && method != ORDER_DFS && method != ORDER_FREQUENCY)
+    return FSM_SIZE_ERR;
+  if (method == ORDER_FREQUENCY && counts == NULL)
+    return FSM_SIZE_ERR;
+
+  // allocate (work is the queue for BFS and the stack for DFS)
+  unsigned int *work = malloc(fsm->Qc * sizeof(unsigned int));
+  unsigned char *placed = calloc(fsm->Qc, sizeof(unsigned char));
+  if (work == NULL || placed == NULL) {
+    free(work);
+    free(placed);
+    return FSM_ALLOC_ERR;
+  }
+
+  // place start state
+  unsigned int next_id = 0;
+  unsigned int start_id = fsm->Qs->id;
+  old_to_new[start_id] = next_id++;
+  placed[start_id] = 1;
+
+  if (method == ORDER_BFS) {
+    // states are placed when queued, so every state is queued at most once
+    unsigned int head = 0, tail = 0;
+    work[tail++] = start_id;
+    while (head < tail) {
+      unsigned int state_id = work[head++];
+      for (unsigned int symbol = 0; symbol < fsm->Ec; symbol++) {
+        State *to_state = fsm->D[(size_t)state_id * fsm->Ec + symbol];
+        if (to_state != NULL && !placed[to_state->id]) {
+          old_to_new[to_state->id] = next_id++;
+          placed[to_state->id] = 1;
+          work[tail++] = to_state->id;
+        }
+      }
+    }
+  }
+  else {
+    // a state stays on the stack until all of its successors are placed
+    const unsigned long long *order_counts = (method == ORDER_FREQUENCY) ? counts : NULL;
+    unsigned int depth = 0;
+    work[depth++] = start_id;
+    while (depth > 0) {
+      unsigned int successor = pickSuccessor(fsm, work[depth - 1], order_counts, placed);
+      if (successor == NO_SUCCESSOR) {
+        depth--;
+        continue;
+      }
+      old_to_new[successor] = next_id++;
+      placed[successor] = 1;
+      work[depth++] = successor;
+    }
+  }
+
+  // place unreached states
+  for (unsigned int i = 0; i < fsm->Qc; i++)
+    if (!placed[i])
+      old_to_new[i] = next_id++;
+
+  free(work);
+  free(placed);
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Renumber FSM
+Actions:
+  • check the mapping is a permutation
+  • initialize the new machine, on the same pages, freeing it again if a state can not be copied
+  • copy each state's designation and action to its new ID
+  • copy each transition to the row and field of the new IDs
+*/
+FSM_STATUS renumberFSM(FSM *src, FSM *dst, const unsigned int *old_to_new) {
+  FSM_STATUS fsm_status;
+
+  // validate inputs
+  if (src == NULL || dst == NULL || src->D == NULL)
+    return FSM_NO_MACHINE;
+  if (old_to_new == NULL)
+    return FSM_SIZE_ERR;
+
+  unsigned char *seen = calloc(src->Qc, sizeof(unsigned char));
+  if (seen == NULL)
+    return FSM_ALLOC_ERR;
+  for (unsigned int i = 0; i < src->Qc; i++) {
+    if (old_to_new[i] >= src->Qc || seen[old_to_new[i]]) {
+      free(seen);
+      return FSM_SIZE_ERR;
+    }
+    seen[old_to_new[i]] = 1;
+  }
+  free(seen);
+
+  // instantiate new machine
+  fsm_status = initFSMPages(dst, src->Qc, src->Ec, src->Dpages);
+  if (fsm_status != FSM_OK)
+    return fsm_status;
+
+  // copy states
+  for (unsigned int i = 0; i < src->Qc; i++) {
+    fsm_status = confState(dst, old_to_new[i], src->Q[i].type, src->Q[i].action);
+    if (fsm_status != FSM_OK) {
+      freeFSM(dst);
+      return fsm_status;
+    }
+  }
+
+  // carry sink state
+  if (src->Qsink != NULL)
+    dst->Qsink = &dst->Q[old_to_new[src->Qsink->id]];
+
+  // copy transitions
+  for (unsigned int i = 0; i < src->Qc; i++) {
+    State **src_row = &src->D[(size_t)i * src->Ec];
+    State **dst_row = &dst->D[(size_t)old_to_new[i] * dst->Ec];
+    for (unsigned int symbol = 0; symbol < src->Ec; symbol++)
+      if (src_row[symbol] != NULL)
+        dst_row[symbol] = &dst->Q[old_to_new[src_row[symbol]->id]];
+  }
+
+  // successful
+  return FSM_OK;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Pick Successor
+Actions:
+  • find the not yet placed successor of a state to visit next
+  • without counts, the successor on the lowest symbol is picked
+  • with counts, the successor on the most taken transition is picked, ties going to the lowest symbol
+*/
+static unsigned int pickSuccessor(FSM *fsm, unsigned int state_id, const unsigned long long *counts,
+                                  const unsigned char *placed) {
+  size_t row = (size_t)state_id * fsm->Ec;
+  unsigned int best = NO_SUCCESSOR;
+  unsigned long long best_count = 0;
+
+  for (unsigned int symbol = 0; symbol < fsm->Ec; symbol++) {
+    State *to_state = fsm->D[row + symbol];
+    if (to_state == NULL || placed[to_state->id])
+      continue;
+    if (counts == NULL)
+      return to_state->id;
+    if (best == NO_SUCCESSOR || counts[row + symbol] > best_count) {
+      best = to_state->id;
+      best_count = counts[row + symbol];
+    }
+  }
+
+  return best;
+}
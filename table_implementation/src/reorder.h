@@ -0,0 +1,100 @@
+// Author: Kevin Imlay
+
+/*
+State reordering renumbers the states of a machine so that states which follow each other while the
+machine runs also sit next to each other in the transition table. Each state's row of the transition
+table is Ec fields long, so placing a hot successor in the next row keeps the lookups of a run within
+the same or neighbouring cache lines.
+
+Reordering is done in two steps: an order is computed as a mapping from old state IDs to new state IDs,
+then a renumbered copy of the machine is built with that mapping. The mapping stays with the caller, so
+application code can keep using its own state IDs and translate them with the mapping where needed.
+*/
+
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "fsm.h"
+
+
+/* ----- Enumerations ----- */
+
+/*
+Method used to order the states.
+*/
+typedef enum {
+  ORDER_BFS = 6000, // breadth first from the start state, symbols in increasing order
+  ORDER_DFS,        // depth first from the start state, symbols in increasing order
+  ORDER_FREQUENCY   // depth first from the start state, hottest recorded transition first
+} ORDER_METHOD;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Profile Transitions
+Walks an input sequence through the machine from its start state, without running any actions, and
+counts how often each transition is taken.
+
+Arguments:
+  • fsm - pointer to the fsm to profile.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+  • counts - [pass back] array of Qc * Ec counters, laid out like the transition table.
+      Note: counts are added to, so several inputs can be profiled into the same array.
+      Note: the walk stops at the first invalid symbol or transition.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if the machine has no start state.
+  • FSM_NO_MACHINE - the machine pointer provided was null or the machine is not initialized.
+*/
+FSM_STATUS profileTransitions(FSM *fsm, unsigned int *input, unsigned int input_length,
+                              unsigned long long *counts);
+
+
+/*
+Order States
+Computes a new numbering of the states of the machine.
+States that cannot be reached from the start state are placed last, in their original order.
+
+Arguments:
+  • fsm - pointer to the fsm to order.
+  • method - the ordering method to use.
+  • counts - array of Qc * Ec transition counters from profileTransitions().
+      Note: only used by ORDER_FREQUENCY, may be null otherwise.
+  • old_to_new - [pass back] array of Qc entries, the new ID of every old state ID.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_STATE - if the machine has no start state.
+  • FSM_SIZE_ERR - if the method is unknown, or ORDER_FREQUENCY is used without counts.
+  • FSM_NO_MACHINE - the machine pointer provided was null or the machine is not initialized.
+*/
+FSM_STATUS orderStates(FSM *fsm, ORDER_METHOD method, const unsigned long long *counts,
+                       unsigned int *old_to_new);
+
+
+/*
+Renumber FSM
+Builds a copy of a machine with its states renumbered.
+The states keep their designation and action, and all transitions are kept. A sink state stays the
+sink state.
+
+Arguments:
+  • src - pointer to the fsm to copy.
+  • dst - pointer to the fsm to initialize as the renumbered copy.
+      Note: it is only initialized when FSM_OK is returned.
+  • old_to_new - array of Qc entries, the new ID of every old state ID.
+      Note: must be a permutation of 0 to Qc - 1.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if the mapping is null or not a permutation.
+  • FSM_NO_MACHINE - either machine pointer provided was null or the source is not initialized.
+*/
+FSM_STATUS renumberFSM(FSM *src, FSM *dst, const unsigned int *old_to_new);
+
+#endif
@@ -0,0 +1,259 @@
+// Author: Kevin Imlay
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define REPLICA_LINUX
+#endif
+
+#include "replica.h"
+
+/* ----- Private Definitions ----- */
+
+/*
+Memory policy that only allocates from the nodes given, from the kernel's mempolicy.h.
+*/
+#define REPLICA_MPOL_BIND 2
+
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int systemNodeCount(void);
+static int bindToNode(void *memory, size_t bytes, unsigned int node);
+static int readList(const char *path, unsigned long long *bits, unsigned int bit_count);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Replicas
+Actions:
+  • count the system's nodes, or take the count to simulate
+  • map the states and table of each node's replica together, binding them to the node before they are
+    touched
+  • copy the machine's states into each, then its table with every state pointer moved to the replica's
+    own states, so the pages are allocated on the bound node and no lookup leaves it
+*/
+FSM_STATUS initReplicas(ReplicaSet *set, FSM *fsm, unsigned int simulate_nodes) {
+  // validate inputs
+  if (set == NULL || fsm == NULL || fsm->D == NULL || fsm->Q == NULL)
+    return FSM_NO_MACHINE;
+  if (simulate_nodes > REPLICA_MAX_NODES)
+    return FSM_SIZE_ERR;
+
+  set->simulated = (simulate_nodes > 0);
+  set->node_count = set->simulated ? simulate_nodes : systemNodeCount();
+  size_t state_bytes = (size_t)fsm->Qc * sizeof(State);
+  size_t table_count = (size_t)fsm->Qc * fsm->Ec;
+
+  // states first, then the table, aligned for its pointers
+  size_t table_offset = (state_bytes + sizeof(State*) - 1) / sizeof(State*) * sizeof(State*);
+  size_t bytes = table_offset + table_count * sizeof(State*);
+#ifdef REPLICA_LINUX
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  set->bytes = (bytes + page - 1) / page * page;
+  set->placed = !set->simulated;
+#else
+  set->bytes = bytes;
+  set->placed = 0;
+#endif
+
+  // replicate
+  for (unsigned int node = 0; node < set->node_count; node++) {
+#ifdef REPLICA_LINUX
+    void *memory = mmap(NULL, set->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+      memory = NULL;
+    if (memory != NULL && !set->simulated && !bindToNode(memory, set->bytes, node))
+      set->placed = 0;
+#else
+    void *memory = malloc(set->bytes);
+#endif
+
+    if (memory == NULL) {
+      set->node_count = node;
+      freeReplicas(set);
+      return FSM_ALLOC_ERR;
+    }
+
+    FSM *replica = &set->replicas[node];
+    *replica = *fsm;
+    replica->Q = memory;
+    replica->D = (State **)((char *)memory + table_offset);
+    replica->Dpages = PAGES_SMALL;
+    replica->Dbytes = set->bytes;
+    memcpy(replica->Q, fsm->Q, state_bytes);
+    for (size_t i = 0; i < table_count; i++)
+      replica->D[i] = (fsm->D[i] == NULL) ? NULL : &replica->Q[fsm->D[i] - fsm->Q];
+    replica->Qs = (fsm->Qs == NULL) ? NULL : &replica->Q[fsm->Qs - fsm->Q];
+    replica->Qsink = (fsm->Qsink == NULL) ? NULL : &replica->Q[fsm->Qsink - fsm->Q];
+  }
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Replicas
+Actions:
+  • unmap the states and table of each replica
+*/
+void freeReplicas(ReplicaSet *set) {
+  if (set == NULL)
+    return;
+
+  for (unsigned int node = 0; node < set->node_count; node++) {
+#ifdef REPLICA_LINUX
+    munmap(set->replicas[node].Q, set->bytes);
+#else
+    free(set->replicas[node].Q);
+#endif
+    set->replicas[node].Q = NULL;
+    set->replicas[node].D = NULL;
+    set->replicas[node].Qs = NULL;
+    set->replicas[node].Qsink = NULL;
+  }
+  set->node_count = 0;
+}
+
+
+/*
+Current Node
+Actions:
+  • asks the kernel for the CPU and node the calling thread is running on
+  • simulated nodes are assigned by CPU
+*/
+unsigned int currentNode(const ReplicaSet *set) {
+#ifdef REPLICA_LINUX
+  unsigned int cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+    return 0;
+  if (set->simulated)
+    return cpu % set->node_count;
+  return (node < set->node_count) ? node : 0;
+#else
+  return 0;
+#endif
+}
+
+
+/*
+Bind Thread To Node
+Actions:
+  • reads the node's CPUs and restricts the calling thread to them
+*/
+FSM_STATUS bindThreadToNode(const ReplicaSet *set, unsigned int node) {
+  if (node >= set->node_count)
+    return FSM_NO_STATE;
+  if (set->simulated)
+    return FSM_OK;
+
+#ifdef REPLICA_LINUX
+  char path[64];
+  unsigned long long cpus[CPU_SETSIZE / 64] = {0};
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+  if (!readList(path, cpus, CPU_SETSIZE))
+    return FSM_NO_STATE;
+
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    if ((cpus[cpu >> 6] >> (cpu & 63)) & 1)
+      CPU_SET(cpu, &mask);
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0)
+    return FSM_NO_STATE;
+
+  return FSM_OK;
+#else
+  return FSM_NO_STATE;
+#endif
+}
+
+
+/*
+Initialize Local Interpreter
+Actions:
+  • initializes the interpreter on the replica of the current node
+*/
+INTERP_STATUS initLocalInterpreter(Interpreter *interp, ReplicaSet *set) {
+  if (set == NULL || set->node_count == 0)
+    return INTERP_NO_MACHINE;
+
+  return initInterpreter(interp, &set->replicas[currentNode(set)]);
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+System Node Count
+Actions:
+  • one more than the highest online node, or 1 if the nodes cannot be read
+*/
+static unsigned int systemNodeCount(void) {
+  unsigned long long nodes[REPLICA_MAX_NODES / 64 + 1] = {0};
+  if (!readList("/sys/devices/system/node/online", nodes, REPLICA_MAX_NODES))
+    return 1;
+
+  unsigned int count = 1;
+  for (unsigned int node = 0; node < REPLICA_MAX_NODES; node++)
+    if ((nodes[node >> 6] >> (node & 63)) & 1)
+      count = node + 1;
+  return count;
+}
+
+
+/*
+Bind To Node
+Actions:
+  • sets the memory policy of a mapping to allocate only from one node
+*/
+static int bindToNode(void *memory, size_t bytes, unsigned int node) {
+#if defined(REPLICA_LINUX) && defined(SYS_mbind)
+  unsigned long long mask[REPLICA_MAX_NODES / 64 + 1] = {0};
+  mask[node >> 6] = 1ULL << (node & 63);
+  return syscall(SYS_mbind, memory, bytes, REPLICA_MPOL_BIND, mask, REPLICA_MAX_NODES + 1, 0) == 0;
+#else
+  return 0;
+#endif
+}
+
+
+/*
+Read List
+Actions:
+  • reads a sysfs list such as "0-3,8,10-11" into a bitmap, ignoring entries past bit_count
+*/
+static int readList(const char *path, unsigned long long *bits, unsigned int bit_count) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+    return 0;
+
+  unsigned int first, last;
+  int found = 0;
+  while (fscanf(file, "%u", &first) == 1) {
+    last = first;
+    int separator = fgetc(file);
+    if (separator == '-') {
+      if (fscanf(file, "%u", &last) != 1)
+        break;
+      separator = fgetc(file);
+    }
+    for (unsigned int i = first; i <= last && i < bit_count; i++)
+      bits[i >> 6] |= 1ULL << (i & 63);
+    found = 1;
+    if (separator != ',')
+      break;
+  }
+
+  fclose(file);
+  return found;
+}
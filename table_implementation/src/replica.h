@@ -0,0 +1,142 @@
+// Author: Kevin Imlay
+
+/*
+Replicas copy a machine onto each NUMA node, so interpreters running on any node look up transitions
+and states in memory local to that node. Each replica is a machine of its own, with its own copy of the
+state list and of the transition table pointing into it, placed on its node with mbind().
+initLocalInterpreter() picks the replica of the node the calling thread runs on.
+
+A replica's states and table are one mapping owned by the set, so replicas are read-only. They are
+released only with freeReplicas(), never with freeFSM(), and must not be rebuilt in place by
+totalizeFSM() or any other function that reallocates a machine's states or table. A machine that needs
+a sink state is totalized before it is replicated.
+
+Replicas can be simulated on machines with a single node, or to test placement code: a simulated set
+has as many replicas as asked for, all in local memory, and threads are assigned to the replica of their
+CPU modulo the replica count.
+*/
+
+#ifndef REPLICA_H
+#define REPLICA_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Most NUMA nodes a replica set covers.
+*/
+#define REPLICA_MAX_NODES 64
+
+
+/* ----- Structures ----- */
+
+/*
+Set of per node replicas of a machine.
+*/
+typedef struct {
+  // count of replicas, one per node
+  unsigned int node_count;
+
+  // set if the nodes are simulated rather than the system's
+  int simulated;
+
+  // set if every replica was bound to its node
+  int placed;
+
+  // replica of each node, its states and table in one mapping
+  // Note: read-only, must not be passed to freeFSM(), totalizeFSM() or any other function that frees or
+  // reallocates its states or table, the mapping is released by freeReplicas()
+  FSM replicas[REPLICA_MAX_NODES];
+
+  // bytes mapped for each replica's states and transition table
+  size_t bytes;
+
+} ReplicaSet;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Replicas
+Copies the states and transition table of a machine onto each NUMA node.
+Note: the replicas are copies, the machine may be freed after, and changes to it are not seen by them.
+Note: replicas cannot be totalized, so a machine whose replicas need a sink state must be totalized with
+totalizeFSM() before this is called.
+
+Arguments:
+  • set - pointer to the replica set to initialize.
+  • fsm - pointer to an initialized FSM to replicate.
+      Note: totalized first if the replicas are to run with runTotalized().
+  • simulate_nodes - count of nodes to simulate, or 0 to use the system's nodes.
+      Note: when the system's nodes cannot be read, a single node is used.
+
+Returns:
+  • FSM_OK - if successful.
+      Note: if a replica cannot be bound to its node, it is still made in whatever memory the system
+      gives, and placed is left clear.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if more nodes are simulated than REPLICA_MAX_NODES.
+  • FSM_NO_MACHINE - either the set or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initReplicas(ReplicaSet *set, FSM *fsm, unsigned int simulate_nodes);
+
+
+/*
+Free Replicas
+Releases the states and transition tables of the replicas. The source machine is not freed.
+
+Arguments:
+  • set - pointer to the replica set.
+      Note: may be null.
+*/
+void freeReplicas(ReplicaSet *set);
+
+
+/*
+Current Node
+Finds the node of the replica the calling thread should use.
+
+Arguments:
+  • set - pointer to the replica set.
+
+Returns:
+  • index of the replica of the node the calling thread is running on.
+*/
+unsigned int currentNode(const ReplicaSet *set);
+
+
+/*
+Bind Thread To Node
+Restricts the calling thread to the CPUs of a node, so it stays local to that node's replica.
+
+Arguments:
+  • set - pointer to the replica set.
+  • node - index of the node.
+
+Returns:
+  • FSM_OK - if successful, or if the nodes are simulated.
+  • FSM_NO_STATE - if the node is not in the set, or its CPUs cannot be read or bound.
+*/
+FSM_STATUS bindThreadToNode(const ReplicaSet *set, unsigned int node);
+
+
+/*
+Initialize Local Interpreter
+Initializes an interpreter on the replica of the node the calling thread is running on.
+Note: a thread that may move between nodes should be bound with bindThreadToNode() first.
+
+Arguments:
+  • interp - pointer to the interpreter to be initialized.
+  • set - pointer to the replica set.
+
+Returns:
+  • same as initInterpreter().
+*/
+INTERP_STATUS initLocalInterpreter(Interpreter *interp, ReplicaSet *set);
+
+#endif
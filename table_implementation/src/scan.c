@@ -0,0 +1,220 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+
+#include "scan.h"
+
+/* ----- Private Function Prototypes ----- */
+
+static FSM_STATUS classifyStates(Scanner *scanner);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Scanner
+Actions:
+  • freeze the machine into a state table
+  • classify every state
+*/
+FSM_STATUS initScanner(Scanner *scanner, FSM *fsm) {
+  FSM_STATUS fsm_status;
+
+  // validate inputs
+  if (scanner == NULL || fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+
+  fsm_status = initStateTable(&scanner->table, fsm);
+  if (fsm_status != FSM_OK)
+    return fsm_status;
+
+  scanner->class = malloc(fsm->Qc * sizeof(unsigned char));
+  if (scanner->class == NULL) {
+    freeStateTable(&scanner->table);
+    return FSM_ALLOC_ERR;
+  }
+
+  fsm_status = classifyStates(scanner);
+  if (fsm_status != FSM_OK)
+    freeScanner(scanner);
+
+  return fsm_status;
+}
+
+
+/*
+Free Scanner
+Actions:
+  • free the state table and classes
+*/
+void freeScanner(Scanner *scanner) {
+  if (scanner == NULL)
+    return;
+
+  freeStateTable(&scanner->table);
+  free(scanner->class);
+  scanner->class = NULL;
+}
+
+
+/*
+Scan Input
+Actions:
+  • walk the input from the start state while the current state is live
+  • record the first and last accepting positions on the way
+  • stop on a dead or always accepting state, or on a missing transition
+*/
+INTERP_STATUS scanInput(const Scanner *scanner, const unsigned int *input, unsigned int input_length,
+                        ScanResult *result) {
+  // validate inputs
+  if (scanner == NULL || scanner->class == NULL)
+    return INTERP_NO_MACHINE;
+  if (scanner->table.start == TABLE_NO_STATE)
+    return INTERP_MACHINE_NO_START;
+
+  const StateTable *table = &scanner->table;
+  const unsigned char *class = scanner->class;
+  unsigned int state = table->start;
+  unsigned int first_accept = SCAN_NO_MATCH;
+  unsigned int last_accept = SCAN_NO_MATCH;
+  unsigned int i = 0;
+
+  if (isAccepting(table, state))
+    first_accept = last_accept = 0;
+
+  // walk while undecided
+  while (i < input_length && class[state] == SCAN_LIVE) {
+    unsigned int symbol = input[i];
+    if (symbol >= table->Ec) {
+      result->first_accept = first_accept;
+      result->last_accept = last_accept;
+      result->consumed = i;
+      return INTERP_SYMB_ERR;
+    }
+
+    state = table->next[(size_t)state * table->Ec + symbol];
+    i++;
+    if (state == TABLE_NO_STATE)
+      break;
+
+    if (isAccepting(table, state)) {
+      if (first_accept == SCAN_NO_MATCH)
+        first_accept = i;
+      last_accept = i;
+    }
+  }
+
+  result->first_accept = first_accept;
+  result->last_accept = last_accept;
+  result->consumed = i;
+
+  // missing transition or dead state
+  if (state == TABLE_NO_STATE || class[state] == SCAN_DEAD)
+    return INTERP_NO_ACCEPT;
+
+  // every later position accepts
+  if (class[state] == SCAN_ALWAYS_ACCEPT) {
+    result->last_accept = input_length;
+    return INTERP_ACCEPT;
+  }
+
+  // input ran out while live
+  if (isAccepting(table, state))
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Classify States
+Actions:
+  • build the reverse transition graph
+  • mark states that reach an accepting state as live, walking back from the accepting states, the
+      rest are dead
+  • start from the accepting states with a transition on every symbol, and repeatedly drop any state
+      with a transition into a state not in the set, the rest are always accepting
+*/
+static FSM_STATUS classifyStates(Scanner *scanner) {
+  const StateTable *table = &scanner->table;
+  unsigned char *class = scanner->class;
+  size_t cells = (size_t)table->Qc * table->Ec;
+
+  // allocate
+  size_t *offset = calloc((size_t)table->Qc + 1, sizeof(size_t));
+  unsigned int *from = malloc((cells > 0 ? cells : 1) * sizeof(unsigned int));
+  unsigned int *work = malloc(table->Qc * sizeof(unsigned int));
+  unsigned char *always = malloc(table->Qc * sizeof(unsigned char));
+  if (offset == NULL || from == NULL || work == NULL || always == NULL) {
+    free(offset);
+    free(from);
+    free(work);
+    free(always);
+    return FSM_ALLOC_ERR;
+  }
+
+  // reverse edges, grouped by the state they lead to
+  for (size_t i = 0; i < cells; i++)
+    if (table->next[i] != TABLE_NO_STATE)
+      offset[table->next[i] + 1]++;
+  for (unsigned int i = 0; i < table->Qc; i++)
+    offset[i + 1] += offset[i];
+  for (size_t i = 0; i < cells; i++)
+    if (table->next[i] != TABLE_NO_STATE)
+      from[offset[table->next[i]]++] = (unsigned int)(i / table->Ec);
+  for (unsigned int i = table->Qc; i > 0; i--)
+    offset[i] = offset[i - 1];
+  offset[0] = 0;
+
+  // live or dead
+  unsigned int head = 0, tail = 0;
+  for (unsigned int i = 0; i < table->Qc; i++) {
+    class[i] = SCAN_DEAD;
+    if (isAccepting(table, i)) {
+      class[i] = SCAN_LIVE;
+      work[tail++] = i;
+    }
+  }
+  while (head < tail) {
+    unsigned int state = work[head++];
+    for (size_t j = offset[state]; j < offset[state + 1]; j++) {
+      if (class[from[j]] == SCAN_DEAD) {
+        class[from[j]] = SCAN_LIVE;
+        work[tail++] = from[j];
+      }
+    }
+  }
+
+  // always accepting
+  head = tail = 0;
+  for (unsigned int i = 0; i < table->Qc; i++) {
+    always[i] = (unsigned char)isAccepting(table, i);
+    for (unsigned int symbol = 0; always[i] && symbol < table->Ec; symbol++)
+      if (table->next[(size_t)i * table->Ec + symbol] == TABLE_NO_STATE)
+        always[i] = 0;
+    if (!always[i])
+      work[tail++] = i;
+  }
+  while (head < tail) {
+    unsigned int state = work[head++];
+    for (size_t j = offset[state]; j < offset[state + 1]; j++) {
+      if (always[from[j]]) {
+        always[from[j]] = 0;
+        work[tail++] = from[j];
+      }
+    }
+  }
+  for (unsigned int i = 0; i < table->Qc; i++)
+    if (always[i])
+      class[i] = SCAN_ALWAYS_ACCEPT;
+
+  free(offset);
+  free(from);
+  free(work);
+  free(always);
+
+  // successful
+  return FSM_OK;
+}
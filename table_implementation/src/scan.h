@@ -0,0 +1,122 @@
+// Author: Kevin Imlay
+
+/*
+The scanner runs a machine over an input only as far as needed to decide whether the input is accepted.
+Before scanning, every state of the machine is classified:
+  • dead - no accepting state can be reached from the state, so the input can no longer be accepted,
+  • always accepting - the state is accepting and every symbol leads to an always accepting state, so
+      the input can no longer be rejected,
+  • live - anything else.
+Scanning stops as soon as a dead or always accepting state is entered. A missing transition is treated
+the same as entering a dead state, so filter machines do not need to spell out a reject state. No
+actions are run while scanning.
+*/
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "interpreter.h"
+#include "table.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Classes of a state.
+*/
+#define SCAN_LIVE 0
+#define SCAN_DEAD 1
+#define SCAN_ALWAYS_ACCEPT 2
+
+/*
+Marker for an accept position that was not found.
+*/
+#define SCAN_NO_MATCH 0xFFFFFFFFu
+
+
+/* ----- Structures ----- */
+
+/*
+Scanner for a machine.
+*/
+typedef struct {
+  // frozen transition table of the machine
+  StateTable table;
+
+  // class of each state (SCAN_LIVE, SCAN_DEAD or SCAN_ALWAYS_ACCEPT)
+  unsigned char *class;
+
+} Scanner;
+
+
+/*
+Result of a scan.
+Positions are counts of symbols consumed, so a position of 0 is the start state before any input.
+*/
+typedef struct {
+  // first position at which the machine is in an accepting state, or SCAN_NO_MATCH
+  unsigned int first_accept;
+
+  // last position at which the machine is in an accepting state, or SCAN_NO_MATCH
+  unsigned int last_accept;
+
+  // count of symbols read before the outcome was decided
+  unsigned int consumed;
+
+} ScanResult;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Scanner
+Freezes a machine's transition table and classifies its states.
+
+Arguments:
+  • scanner - pointer to the scanner to initialize.
+  • fsm - pointer to an initialized FSM.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either the scanner or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initScanner(Scanner *scanner, FSM *fsm);
+
+
+/*
+Free Scanner
+Releases the memory held by a scanner.
+
+Arguments:
+  • scanner - pointer to the scanner.
+      Note: may be null.
+*/
+void freeScanner(Scanner *scanner);
+
+
+/*
+Scan Input
+Runs the input from the machine's start state until the outcome is decided.
+Note: symbols after the outcome is decided are not read, so they are not checked either.
+
+Arguments:
+  • scanner - pointer to the scanner.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - unsigned integer length of the input array.
+  • result - [pass back] accept positions and count of symbols read.
+      Note: if the input is decided by an always accepting state, every later position accepts, so the
+      last accept position is the input length.
+
+Returns:
+  • INTERP_ACCEPT - if the input is accepted.
+  • INTERP_NO_ACCEPT - if the input is not accepted, including by a missing transition.
+  • INTERP_SYMB_ERR - if a symbol read is invalid, result->consumed is its index.
+  • INTERP_NO_MACHINE - if the scanner provided is null or not initialized.
+  • INTERP_MACHINE_NO_START - if the machine has no start state.
+*/
+INTERP_STATUS scanInput(const Scanner *scanner, const unsigned int *input, unsigned int input_length,
+                        ScanResult *result);
+
+#endif
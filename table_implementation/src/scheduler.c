@@ -0,0 +1,460 @@
+// Author: Kevin Imlay
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scheduler.h"
+
+/* ----- Private Variables ----- */
+
+/*
+Worker running on the calling thread, null on threads that are not workers.
+*/
+static _Thread_local Worker *current_worker = NULL;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static int initDeque(InstanceDeque *deque, size_t capacity);
+static void pushDeque(InstanceDeque *deque, Instance *instance);
+static Instance *popDeque(InstanceDeque *deque);
+static Instance *stealDeque(InstanceDeque *deque);
+static Instance *takeInjected(Scheduler *scheduler);
+static Instance *stealInstance(Worker *worker);
+static void runInstance(Worker *worker, Instance *instance);
+static void *workerMain(void *argument);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Scheduler
+Actions:
+  • allocate each worker's deque and symbol buffer, deques hold every instance that may be runnable
+  • allocate the injection list
+*/
+INTERP_STATUS initScheduler(Scheduler *scheduler, unsigned int thread_count, unsigned int budget,
+                            size_t max_instances) {
+  // validate inputs
+  if (scheduler == NULL)
+    return INTERP_NO_INTERP;
+  if (thread_count == 0 || thread_count > SCHEDULER_MAX_THREADS || budget == 0 || max_instances == 0)
+    return INTERP_SYMB_ERR;
+
+  scheduler->thread_count = thread_count;
+  scheduler->budget = budget;
+  scheduler->max_instances = max_instances;
+  atomic_init(&scheduler->runnable, 0);
+  atomic_init(&scheduler->injected_count, 0);
+  pthread_mutex_init(&scheduler->inject_lock, NULL);
+
+  // allocate
+  int ok = 1;
+  scheduler->injected = malloc(max_instances * sizeof(Instance *));
+  ok &= (scheduler->injected != NULL);
+  for (unsigned int i = 0; i < thread_count; i++) {
+    Worker *worker = &scheduler->workers[i];
+    worker->scheduler = scheduler;
+    worker->index = i;
+    worker->seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+    worker->runs = 0;
+    worker->steals = 0;
+    worker->buffer = malloc(budget * sizeof(unsigned int));
+    ok &= (worker->buffer != NULL);
+    ok &= initDeque(&worker->deque, max_instances);
+  }
+  if (!ok) {
+    freeScheduler(scheduler);
+    return INTERP_ALLOC_ERR;
+  }
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Free Scheduler
+Actions:
+  • free each worker's deque and buffer, and the injection list
+*/
+void freeScheduler(Scheduler *scheduler) {
+  if (scheduler == NULL)
+    return;
+
+  for (unsigned int i = 0; i < scheduler->thread_count; i++) {
+    free(scheduler->workers[i].deque.slots);
+    free(scheduler->workers[i].buffer);
+    scheduler->workers[i].deque.slots = NULL;
+    scheduler->workers[i].buffer = NULL;
+  }
+  free(scheduler->injected);
+  scheduler->injected = NULL;
+  pthread_mutex_destroy(&scheduler->inject_lock);
+}
+
+
+/*
+Initialize Instance
+Actions:
+  • initialize the interpreter and begin its stream
+  • allocate the backlog
+*/
+INTERP_STATUS initInstance(Instance *instance, FSM *machine) {
+  INTERP_STATUS interp_status;
+
+  // validate inputs
+  if (instance == NULL)
+    return INTERP_NO_INTERP;
+
+  interp_status = initInterpreter(&instance->interp, machine);
+  if (interp_status != INTERP_OK)
+    return interp_status;
+
+  // allocate
+  instance->pending = malloc(INSTANCE_INITIAL_BACKLOG * sizeof(unsigned int));
+  if (instance->pending == NULL)
+    return INTERP_ALLOC_ERR;
+  instance->capacity = INSTANCE_INITIAL_BACKLOG;
+  instance->head = 0;
+  instance->count = 0;
+  instance->queued = 0;
+  instance->status = INTERP_OK;
+  pthread_mutex_init(&instance->lock, NULL);
+
+  return beginInterpreter(&instance->interp);
+}
+
+
+/*
+Free Instance
+Actions:
+  • free the backlog
+*/
+void freeInstance(Instance *instance) {
+  if (instance == NULL)
+    return;
+
+  free(instance->pending);
+  instance->pending = NULL;
+  pthread_mutex_destroy(&instance->lock);
+}
+
+
+/*
+Post Symbols
+Actions:
+  • if the instance is not runnable, take one of the scheduler's max_instances runnable places for it,
+      so the deques and injection list never hold more than they were allocated for
+  • grow the backlog if needed, straightening the ring
+  • append the symbols
+  • if the instance was not runnable, mark it runnable and push it on the calling worker's deque, or
+      on the injection list from other threads
+*/
+INTERP_STATUS postSymbols(Scheduler *scheduler, Instance *instance, const unsigned int *symbols,
+                          unsigned int count) {
+  // validate inputs
+  if (scheduler == NULL || instance == NULL)
+    return INTERP_NO_INTERP;
+
+  pthread_mutex_lock(&instance->lock);
+  if (instance->status != INTERP_OK) {
+    pthread_mutex_unlock(&instance->lock);
+    return instance->status;
+  }
+
+  // take a runnable place
+  int wake = (!instance->queued && instance->count + count > 0);
+  if (wake) {
+    size_t runnable = atomic_load(&scheduler->runnable);
+    do {
+      if (runnable >= scheduler->max_instances) {
+        pthread_mutex_unlock(&instance->lock);
+        return INTERP_ALLOC_ERR;
+      }
+    } while (!atomic_compare_exchange_weak(&scheduler->runnable, &runnable, runnable + 1));
+  }
+
+  // grow
+  if (instance->count + count > instance->capacity) {
+    size_t capacity = instance->capacity;
+    while (capacity < instance->count + count)
+      capacity *= 2;
+    unsigned int *pending = malloc(capacity * sizeof(unsigned int));
+    if (pending == NULL) {
+      if (wake)
+        atomic_fetch_sub(&scheduler->runnable, 1);
+      pthread_mutex_unlock(&instance->lock);
+      return INTERP_ALLOC_ERR;
+    }
+    for (size_t i = 0; i < instance->count; i++)
+      pending[i] = instance->pending[(instance->head + i) % instance->capacity];
+    free(instance->pending);
+    instance->pending = pending;
+    instance->capacity = capacity;
+    instance->head = 0;
+  }
+
+  // append
+  for (unsigned int i = 0; i < count; i++)
+    instance->pending[(instance->head + instance->count + i) % instance->capacity] = symbols[i];
+  instance->count += count;
+
+  if (wake)
+    instance->queued = 1;
+  pthread_mutex_unlock(&instance->lock);
+
+  // make runnable
+  if (wake) {
+    if (current_worker != NULL && current_worker->scheduler == scheduler)
+      pushDeque(&current_worker->deque, instance);
+    else {
+      pthread_mutex_lock(&scheduler->inject_lock);
+      size_t injected = atomic_load(&scheduler->injected_count);
+      scheduler->injected[injected] = instance;
+      atomic_store(&scheduler->injected_count, injected + 1);
+      pthread_mutex_unlock(&scheduler->inject_lock);
+    }
+  }
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Run Scheduler
+Actions:
+  • deal the injected instances out to the workers' deques, as no worker is running yet
+  • start a thread for every worker but the first, and run the first on the calling thread
+  • wait for the threads to finish
+*/
+INTERP_STATUS runScheduler(Scheduler *scheduler) {
+  // validate inputs
+  if (scheduler == NULL)
+    return INTERP_NO_INTERP;
+
+  // deal injected instances
+  size_t injected = atomic_load(&scheduler->injected_count);
+  for (size_t i = 0; i < injected; i++)
+    pushDeque(&scheduler->workers[i % scheduler->thread_count].deque, scheduler->injected[i]);
+  atomic_store(&scheduler->injected_count, 0);
+
+  // run workers, a worker whose thread does not start has its deque stolen from
+  pthread_t threads[SCHEDULER_MAX_THREADS];
+  int started[SCHEDULER_MAX_THREADS];
+  for (unsigned int i = 1; i < scheduler->thread_count; i++)
+    started[i] = (pthread_create(&threads[i], NULL, workerMain, &scheduler->workers[i]) == 0);
+  workerMain(&scheduler->workers[0]);
+  for (unsigned int i = 1; i < scheduler->thread_count; i++)
+    if (started[i])
+      pthread_join(threads[i], NULL);
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Initialize Deque
+Actions:
+  • allocate a power of two slots, at least the capacity
+*/
+static int initDeque(InstanceDeque *deque, size_t capacity) {
+  size_t slots = 1;
+  while (slots < capacity)
+    slots *= 2;
+
+  deque->slots = malloc(slots * sizeof(deque->slots[0]));
+  deque->mask = slots - 1;
+  atomic_init(&deque->top, 0);
+  atomic_init(&deque->bottom, 0);
+  return deque->slots != NULL;
+}
+
+
+/*
+Push Deque
+Actions:
+  • store the instance at the bottom, then publish the new bottom
+*/
+static void pushDeque(InstanceDeque *deque, Instance *instance) {
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  atomic_store_explicit(&deque->slots[bottom & deque->mask], instance, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+
+/*
+Pop Deque
+Actions:
+  • claim the bottom slot, then check a thief has not taken it
+  • the last instance is raced for with thieves on the top index
+*/
+static Instance *popDeque(InstanceDeque *deque) {
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+  if (top > bottom) {
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return NULL;
+  }
+
+  Instance *instance = atomic_load_explicit(&deque->slots[bottom & deque->mask], memory_order_relaxed);
+  if (top == bottom) {
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed))
+      instance = NULL;
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+  }
+  return instance;
+}
+
+
+/*
+Steal Deque
+Actions:
+  • take the top instance if the deque is not empty and no other thread takes it first
+*/
+static Instance *stealDeque(InstanceDeque *deque) {
+  long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+  if (top >= bottom)
+    return NULL;
+
+  Instance *instance = atomic_load_explicit(&deque->slots[top & deque->mask], memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                               memory_order_relaxed))
+    return NULL;
+  return instance;
+}
+
+
+/*
+Take Injected
+Actions:
+  • take the most recently injected instance, if any
+*/
+static Instance *takeInjected(Scheduler *scheduler) {
+  if (atomic_load_explicit(&scheduler->injected_count, memory_order_relaxed) == 0)
+    return NULL;
+
+  Instance *instance = NULL;
+  pthread_mutex_lock(&scheduler->inject_lock);
+  size_t injected = atomic_load(&scheduler->injected_count);
+  if (injected > 0) {
+    instance = scheduler->injected[injected - 1];
+    atomic_store(&scheduler->injected_count, injected - 1);
+  }
+  pthread_mutex_unlock(&scheduler->inject_lock);
+  return instance;
+}
+
+
+/*
+Steal Instance
+Actions:
+  • try the deques of a few randomly picked other workers
+*/
+static Instance *stealInstance(Worker *worker) {
+  Scheduler *scheduler = worker->scheduler;
+  if (scheduler->thread_count < 2)
+    return NULL;
+
+  for (unsigned int attempt = 0; attempt < 2 * scheduler->thread_count; attempt++) {
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 7;
+    worker->seed ^= worker->seed << 17;
+    unsigned int victim = (unsigned int)(worker->seed % (scheduler->thread_count - 1));
+    if (victim >= worker->index)
+      victim++;
+
+    Instance *instance = stealDeque(&scheduler->workers[victim].deque);
+    if (instance != NULL) {
+      worker->steals++;
+      return instance;
+    }
+  }
+  return NULL;
+}
+
+
+/*
+Run Instance
+Actions:
+  • take up to a budget of symbols from the front of the backlog
+  • feed them to the instance's interpreter, outside the lock so posting is not held up
+  • put the instance back on the worker's deque if it has more symbols, otherwise mark it not runnable
+  • an instance that fails drops its backlog and is not run again
+*/
+static void runInstance(Worker *worker, Instance *instance) {
+  Scheduler *scheduler = worker->scheduler;
+
+  // take symbols
+  pthread_mutex_lock(&instance->lock);
+  unsigned int count = (instance->count < scheduler->budget) ? (unsigned int)instance->count : scheduler->budget;
+  for (unsigned int i = 0; i < count; i++)
+    worker->buffer[i] = instance->pending[(instance->head + i) % instance->capacity];
+  instance->head = (instance->head + count) % instance->capacity;
+  instance->count -= count;
+  pthread_mutex_unlock(&instance->lock);
+
+  // run
+  INTERP_STATUS interp_status = feedInterpreter(&instance->interp, worker->buffer, count);
+  worker->runs++;
+
+  // requeue
+  pthread_mutex_lock(&instance->lock);
+  if (interp_status != INTERP_ACCEPT && interp_status != INTERP_NO_ACCEPT) {
+    instance->status = interp_status;
+    instance->count = 0;
+  }
+  // its runnable place is given back under the lock, before a post can take another for it
+  int requeue = (instance->count > 0);
+  if (!requeue) {
+    instance->queued = 0;
+    atomic_fetch_sub(&scheduler->runnable, 1);
+  }
+  pthread_mutex_unlock(&instance->lock);
+
+  if (requeue)
+    pushDeque(&worker->deque, instance);
+}
+
+
+/*
+Worker Main
+Actions:
+  • run instances from the worker's own deque, then injected instances, then stolen instances
+  • stop once no instance is runnable
+*/
+static void *workerMain(void *argument) {
+  Worker *worker = argument;
+  Scheduler *scheduler = worker->scheduler;
+  current_worker = worker;
+
+  for (;;) {
+    Instance *instance = popDeque(&worker->deque);
+    if (instance == NULL)
+      instance = takeInjected(scheduler);
+    if (instance == NULL)
+      instance = stealInstance(worker);
+
+    if (instance != NULL)
+      runInstance(worker, instance);
+    else if (atomic_load(&scheduler->runnable) == 0)
+      break;
+    else
+      sched_yield();
+  }
+
+  current_worker = NULL;
+  return NULL;
+}
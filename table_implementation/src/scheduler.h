@@ -0,0 +1,218 @@
+// Author: Kevin Imlay
+
+/*
+The scheduler runs many independent instances of machines across a pool of worker threads. Each
+instance is an interpreter with its own backlog of pending symbols. Posting symbols to an instance that
+has none pending makes it runnable, and runnable instances are kept in a work-stealing deque per worker.
+A worker takes the newest instance from its own deque, runs up to a budget of its pending symbols, and
+puts it back if it has more. A worker with an empty deque steals the oldest instance from another
+worker's deque.
+
+An instance is only ever in one deque and run by one worker at a time, and its backlog is first in first
+out, so each instance sees its symbols in the order they were posted.
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Most worker threads a scheduler runs.
+*/
+#define SCHEDULER_MAX_THREADS 64
+
+/*
+Symbols an instance's backlog holds before it first grows.
+*/
+#define INSTANCE_INITIAL_BACKLOG 64
+
+
+/* ----- Structures ----- */
+
+/*
+Machine instance run by a scheduler.
+*/
+typedef struct {
+  // interpreter of the instance, streaming
+  Interpreter interp;
+
+  // guards the backlog and queued flag
+  pthread_mutex_t lock;
+
+  // pending symbols, a ring of capacity entries starting at head
+  unsigned int *pending;
+  size_t capacity;
+  size_t head;
+  size_t count;
+
+  // set while the instance is runnable, in a deque or being run
+  int queued;
+
+  // INTERP_OK, or the error the instance stopped on, after which posted symbols are dropped
+  INTERP_STATUS status;
+
+} Instance;
+
+
+/*
+Work-stealing deque of runnable instances. The owning worker pushes and pops at the bottom, other
+workers steal from the top.
+*/
+typedef struct {
+  atomic_long top;
+  atomic_long bottom;
+  _Atomic(Instance *) *slots;
+  size_t mask;
+} InstanceDeque;
+
+
+/*
+Worker of a scheduler.
+*/
+typedef struct {
+  struct Scheduler *scheduler;
+  unsigned int index;
+  InstanceDeque deque;
+
+  // symbols taken from the backlog of the instance being run, budget entries
+  unsigned int *buffer;
+
+  // xorshift state for picking steal victims
+  unsigned long long seed;
+
+  // count of times an instance was run, and of instances stolen
+  unsigned long long runs;
+  unsigned long long steals;
+} Worker;
+
+
+/*
+Scheduler.
+*/
+typedef struct Scheduler {
+  // count of worker threads
+  unsigned int thread_count;
+
+  // most symbols an instance runs before it yields
+  unsigned int budget;
+
+  // most instances that may be runnable at once
+  size_t max_instances;
+
+  Worker workers[SCHEDULER_MAX_THREADS];
+
+  // runnable instances posted to from outside the workers, taken by workers with empty deques
+  pthread_mutex_t inject_lock;
+  Instance **injected;
+  atomic_size_t injected_count;
+
+  // count of runnable instances, the workers stop when it reaches 0
+  atomic_size_t runnable;
+
+} Scheduler;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Scheduler
+Initializes a scheduler and its workers' deques.
+
+Arguments:
+  • scheduler - pointer to the scheduler to initialize.
+  • thread_count - count of worker threads, from 1 to SCHEDULER_MAX_THREADS.
+  • budget - most symbols an instance runs before it yields to other instances, at least 1.
+  • max_instances - most instances that may be runnable at once.
+      Note: an instance is runnable from when symbols are posted to it until its backlog is run empty.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_ALLOC_ERR - if needed memory was not able to be allocated.
+  • INTERP_SYMB_ERR - if the thread count, budget or instance count is out of range.
+  • INTERP_NO_INTERP - if the scheduler pointer provided was null.
+*/
+INTERP_STATUS initScheduler(Scheduler *scheduler, unsigned int thread_count, unsigned int budget,
+                            size_t max_instances);
+
+
+/*
+Free Scheduler
+Releases the memory held by a scheduler. The instances are not freed.
+
+Arguments:
+  • scheduler - pointer to the scheduler.
+      Note: may be null.
+*/
+void freeScheduler(Scheduler *scheduler);
+
+
+/*
+Initialize Instance
+Initializes an instance of a machine, and begins its interpreter's stream, running the start state's
+action on the calling thread.
+
+Arguments:
+  • instance - pointer to the instance to initialize.
+  • machine - pointer to the FSM to run.
+
+Returns:
+  • same as initInterpreter(), or INTERP_ALLOC_ERR if the backlog was not able to be allocated.
+*/
+INTERP_STATUS initInstance(Instance *instance, FSM *machine);
+
+
+/*
+Free Instance
+Releases the memory held by an instance.
+
+Arguments:
+  • instance - pointer to the instance.
+      Note: may be null.
+*/
+void freeInstance(Instance *instance);
+
+
+/*
+Post Symbols
+Appends symbols to an instance's backlog, making the instance runnable if it was not.
+May be called from any thread, including from actions run by the scheduler's workers.
+
+Arguments:
+  • scheduler - pointer to the scheduler to run the instance on.
+  • instance - pointer to the instance.
+  • symbols - array of symbols.
+  • count - count of symbols.
+
+Returns:
+  • INTERP_OK - if successful.
+  • INTERP_ALLOC_ERR - if the backlog was not able to grow, or the instance was not runnable and
+      max_instances instances already are, no symbols are posted.
+  • any error the instance has stopped on, in which case the symbols are dropped.
+*/
+INTERP_STATUS postSymbols(Scheduler *scheduler, Instance *instance, const unsigned int *symbols,
+                          unsigned int count);
+
+
+/*
+Run Scheduler
+Runs the worker threads until no instance has pending symbols, the calling thread being the first
+worker.
+
+Arguments:
+  • scheduler - pointer to the scheduler.
+
+Returns:
+  • INTERP_OK - once every backlog is empty.
+  • INTERP_NO_INTERP - if the scheduler pointer provided was null.
+*/
+INTERP_STATUS runScheduler(Scheduler *scheduler);
+
+#endif
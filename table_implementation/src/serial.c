@@ -0,0 +1,173 @@
+// Author: Kevin Imlay
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "serial.h"
+
+/* ----- Private Definitions ----- */
+
+/*
+Words in the header.
+*/
+#define SERIAL_HEADER_WORDS 6
+
+
+/* ----- Private Function Prototypes ----- */
+
+static uint32_t stateWord(const FSM *fsm, const State *state);
+static FSM_STATUS readMachine(FSM *fsm, FILE *file);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Save Machine
+Actions:
+  • writes the header, the designation of each state, then the table a row at a time
+*/
+FSM_STATUS saveMachine(const FSM *fsm, const char *path) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL || fsm->Q == NULL)
+    return FSM_NO_MACHINE;
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+    return FSM_IO_ERR;
+
+  uint32_t header[SERIAL_HEADER_WORDS] = {SERIAL_MAGIC, SERIAL_VERSION, fsm->Qc, fsm->Ec,
+                                          stateWord(fsm, fsm->Qs), stateWord(fsm, fsm->Qsink)};
+  int written = (fwrite(header, sizeof(uint32_t), SERIAL_HEADER_WORDS, file) == SERIAL_HEADER_WORDS);
+
+  // designations, as offsets from the first
+  for (unsigned int state = 0; state < fsm->Qc && written; state++)
+    written = (fputc((int)(fsm->Q[state].type - START_STATE), file) != EOF);
+
+  // table
+  uint32_t *row = malloc(fsm->Ec * sizeof(uint32_t));
+  written = written && (row != NULL);
+  for (unsigned int state = 0; state < fsm->Qc && written; state++) {
+    for (unsigned int symbol = 0; symbol < fsm->Ec; symbol++)
+      row[symbol] = stateWord(fsm, fsm->D[(size_t)state * fsm->Ec + symbol]);
+    written = (fwrite(row, sizeof(uint32_t), fsm->Ec, file) == fsm->Ec);
+  }
+  free(row);
+
+  if (fclose(file) != 0 || !written) {
+    remove(path);
+    return FSM_IO_ERR;
+  }
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Load Machine
+Actions:
+  • reads and checks the header, then initializes the machine and fills it from the file
+*/
+FSM_STATUS loadMachine(FSM *fsm, const char *path) {
+  // validate inputs
+  if (fsm == NULL)
+    return FSM_NO_MACHINE;
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+    return FSM_IO_ERR;
+
+  FSM_STATUS status = readMachine(fsm, file);
+  fclose(file);
+  return status;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+State Word
+Actions:
+  • the ID of the state, or SERIAL_NO_STATE for none
+*/
+static uint32_t stateWord(const FSM *fsm, const State *state) {
+  return (state == NULL) ? SERIAL_NO_STATE : (uint32_t)(state - fsm->Q);
+}
+
+
+/*
+Read Machine
+Actions:
+  • checks the magic number, version, that the file is the size the header gives, and that every ID read
+    is a state of the machine
+  • frees the machine again if the rest of the file is not valid
+*/
+static FSM_STATUS readMachine(FSM *fsm, FILE *file) {
+  uint32_t header[SERIAL_HEADER_WORDS];
+  if (fread(header, sizeof(uint32_t), SERIAL_HEADER_WORDS, file) != SERIAL_HEADER_WORDS)
+    return FSM_IO_ERR;
+  if (header[0] != SERIAL_MAGIC || header[1] != SERIAL_VERSION)
+    return FSM_IO_ERR;
+  unsigned int state_count = header[2], symbol_count = header[3];
+  if ((header[4] != SERIAL_NO_STATE && header[4] >= state_count) ||
+      (header[5] != SERIAL_NO_STATE && header[5] >= state_count))
+    return FSM_IO_ERR;
+
+  // the file must hold exactly the header, designations and table, checked before allocating for them
+  struct stat file_stat;
+  if (fstat(fileno(file), &file_stat) != 0 || file_stat.st_size < 0)
+    return FSM_IO_ERR;
+  unsigned long long table_bytes = (unsigned long long)state_count * symbol_count * sizeof(uint32_t);
+  if (symbol_count != 0 && table_bytes / symbol_count / sizeof(uint32_t) != state_count)
+    return FSM_IO_ERR;
+  unsigned long long expected = SERIAL_HEADER_WORDS * sizeof(uint32_t) + (unsigned long long)state_count;
+  if (table_bytes > 0xFFFFFFFFFFFFFFFFULL - expected ||
+      (unsigned long long)file_stat.st_size != expected + table_bytes)
+    return FSM_IO_ERR;
+
+  FSM_STATUS status = initFSM(fsm, state_count, symbol_count);
+  if (status == FSM_SIZE_ERR)
+    return FSM_IO_ERR;
+  if (status != FSM_OK)
+    return status;
+
+  // designations
+  for (unsigned int state = 0; state < state_count && status == FSM_OK; state++) {
+    int type = fgetc(file);
+    if (type < 0 || type > NORMAL_STATE - START_STATE)
+      status = FSM_IO_ERR;
+    else
+      fsm->Q[state].type = (STATE_TYPE)(START_STATE + type);
+  }
+
+  // table
+  uint32_t *row = malloc(symbol_count * sizeof(uint32_t));
+  if (row == NULL && status == FSM_OK)
+    status = FSM_ALLOC_ERR;
+  for (unsigned int state = 0; state < state_count && status == FSM_OK; state++) {
+    if (fread(row, sizeof(uint32_t), symbol_count, file) != symbol_count) {
+      status = FSM_IO_ERR;
+      break;
+    }
+    for (unsigned int symbol = 0; symbol < symbol_count; symbol++) {
+      if (row[symbol] != SERIAL_NO_STATE && row[symbol] >= state_count) {
+        status = FSM_IO_ERR;
+        break;
+      }
+      fsm->D[(size_t)state * symbol_count + symbol] = (row[symbol] == SERIAL_NO_STATE) ? NULL : &fsm->Q[row[symbol]];
+    }
+  }
+  free(row);
+
+  if (status != FSM_OK) {
+    freeFSM(fsm);
+    return status;
+  }
+  fsm->Qs = (header[4] == SERIAL_NO_STATE) ? NULL : &fsm->Q[header[4]];
+  fsm->Qsink = (header[5] == SERIAL_NO_STATE) ? NULL : &fsm->Q[header[5]];
+
+  // successful
+  return FSM_OK;
+}
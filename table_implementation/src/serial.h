@@ -0,0 +1,74 @@
+// Author: Kevin Imlay
+
+/*
+Serialized machines are files holding a machine's states and transition table, so a machine built once
+can be loaded by other programs, such as the corpus scanner. Actions are functions of the program that
+built the machine and are not saved, a loaded machine has none.
+
+The file is a header of 32 bit words, the magic number, format version, state count, symbol count, start
+state ID and sink state ID, then a byte per state for its designation and a 32 bit word per field of the
+transition table for the next state ID. Words are in the byte order of the program that saved the file,
+a file saved in the other byte order is rejected by its magic number.
+*/
+
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include "fsm.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+First word of a serialized machine, "FSMT" in little endian order.
+*/
+#define SERIAL_MAGIC 0x544D5346u
+
+/*
+Version of the format written.
+*/
+#define SERIAL_VERSION 1u
+
+/*
+ID written for a missing transition, or for a start or sink state that is not set.
+*/
+#define SERIAL_NO_STATE 0xFFFFFFFFu
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Save Machine
+Writes a machine to a file, replacing the file if it exists.
+
+Arguments:
+  • fsm - pointer to an initialized FSM.
+  • path - path of the file to write.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_IO_ERR - if the file could not be written.
+  • FSM_NO_MACHINE - if the machine is null or not initialized.
+*/
+FSM_STATUS saveMachine(const FSM *fsm, const char *path);
+
+
+/*
+Load Machine
+Reads a machine from a file written by saveMachine().
+
+Arguments:
+  • fsm - pointer to the fsm to initialize from the file.
+      Note: must not be initialized, it is only initialized when FSM_OK is returned.
+  • path - path of the file to read.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_IO_ERR - if the file could not be read, is not a serialized machine of this version, or is not the
+      size its header gives.
+  • FSM_NO_MACHINE - if the machine pointer provided was null.
+*/
+FSM_STATUS loadMachine(FSM *fsm, const char *path);
+
+#endif
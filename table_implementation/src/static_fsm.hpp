@@ -0,0 +1,274 @@
+// Author: Kevin Imlay
+
+/*
+Header-only C++17 front end for machines that are fully known at compile time. States, transitions and
+actions are declared as types, and the transition table is built by the compiler into a constexpr array
+that ends up in read-only data. Nothing is allocated or configured at startup, a bad declaration (a
+state or symbol out of range, a state or transition declared twice, no start state) fails to compile,
+and each step is an array read that can be inlined into the caller. Actions are dispatched by compare
+and call code generated for the states that have one, rather than through a function pointer in a table.
+
+The state designations and status codes are the same as those of the table implementation in C. As the
+C State structure is global, the declarations here are best used qualified by their namespace.
+
+Example:
+  using Boot = static_fsm::Machine<3, 2,
+    static_fsm::States<static_fsm::State<0, START_STATE, boot>,
+                       static_fsm::State<1, NORMAL_STATE, run>,
+                       static_fsm::State<2, ACCEPT_STATE>>,
+    static_fsm::Transitions<static_fsm::Trans<0, 0, 1>,
+                            static_fsm::Trans<1, 1, 2>>>;
+
+  static_assert(Boot::next_v<0, 0> == 1);
+  Boot::Runner runner;
+  runner.run(input, input_length);
+*/
+
+#ifndef STATIC_FSM_HPP
+#define STATIC_FSM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+extern "C" {
+#include "interpreter.h"
+}
+
+namespace static_fsm {
+
+
+/* ----- Declarations ----- */
+
+/*
+State declaration.
+  • Id - unsigned integer ID of the state, less than the machine's state count.
+  • Type - designation of the state.
+  • Action - function run when the state is entered, may be null.
+*/
+template <unsigned int Id, STATE_TYPE Type = NORMAL_STATE, void (*Action)(void) = nullptr>
+struct State {
+  static constexpr unsigned int id = Id;
+  static constexpr STATE_TYPE type = Type;
+  static constexpr void (*action)(void) = Action;
+};
+
+
+/*
+Transition declaration, from a state to a state on a symbol.
+*/
+template <unsigned int From, unsigned int Symbol, unsigned int To>
+struct Trans {
+  static constexpr unsigned int from = From;
+  static constexpr unsigned int symbol = Symbol;
+  static constexpr unsigned int to = To;
+};
+
+
+/*
+Lists of declarations.
+*/
+template <typename... StateDecls>
+struct States {};
+
+template <typename... TransDecls>
+struct Transitions {};
+
+
+/* ----- Compile Time Checks ----- */
+
+namespace detail {
+
+template <unsigned int StateCount, typename... StateDecls>
+constexpr bool statesInRange() {
+  return ((StateDecls::id < StateCount) && ... && true);
+}
+
+template <typename... StateDecls>
+constexpr bool statesUnique() {
+  constexpr unsigned int ids[] = {StateDecls::id..., 0u};
+  for (std::size_t i = 0; i < sizeof...(StateDecls); i++)
+    for (std::size_t j = i + 1; j < sizeof...(StateDecls); j++)
+      if (ids[i] == ids[j])
+        return false;
+  return true;
+}
+
+template <typename... StateDecls>
+constexpr unsigned int startCount() {
+  return (0u + ... + (StateDecls::type == START_STATE ? 1u : 0u));
+}
+
+template <unsigned int StateCount, unsigned int SymbolCount, typename... TransDecls>
+constexpr bool transitionsInRange() {
+  return ((TransDecls::from < StateCount && TransDecls::to < StateCount &&
+           TransDecls::symbol < SymbolCount) && ... && true);
+}
+
+template <unsigned int SymbolCount, typename... TransDecls>
+constexpr bool transitionsUnique() {
+  constexpr std::size_t cells[] = {(static_cast<std::size_t>(TransDecls::from) * SymbolCount +
+                                    TransDecls::symbol)..., 0u};
+  for (std::size_t i = 0; i < sizeof...(TransDecls); i++)
+    for (std::size_t j = i + 1; j < sizeof...(TransDecls); j++)
+      if (cells[i] == cells[j])
+        return false;
+  return true;
+}
+
+template <typename StateType, unsigned int StateCount, unsigned int SymbolCount, typename... TransDecls>
+constexpr std::array<StateType, static_cast<std::size_t>(StateCount) * SymbolCount> buildTable() {
+  std::array<StateType, static_cast<std::size_t>(StateCount) * SymbolCount> table{};
+  for (auto &field : table)
+    field = static_cast<StateType>(StateCount);
+  ((table[static_cast<std::size_t>(TransDecls::from) * SymbolCount + TransDecls::symbol] =
+      static_cast<StateType>(TransDecls::to)), ...);
+  return table;
+}
+
+template <unsigned int StateCount, typename... StateDecls>
+constexpr std::array<bool, StateCount> buildAccepting() {
+  std::array<bool, StateCount> accepting{};
+  ((accepting[StateDecls::id] = (StateDecls::type == ACCEPT_STATE)), ...);
+  return accepting;
+}
+
+template <typename StateType, unsigned int StateCount, typename... StateDecls>
+constexpr StateType findStart() {
+  StateType start = static_cast<StateType>(StateCount);
+  ((start = (StateDecls::type == START_STATE) ? static_cast<StateType>(StateDecls::id) : start), ...);
+  return start;
+}
+
+}  // namespace detail
+
+
+/* ----- Machine ----- */
+
+template <unsigned int StateCount, unsigned int SymbolCount, typename StateList, typename TransList>
+class Machine;
+
+template <unsigned int StateCount, unsigned int SymbolCount, typename... StateDecls, typename... TransDecls>
+class Machine<StateCount, SymbolCount, States<StateDecls...>, Transitions<TransDecls...>> {
+  static_assert(StateCount > 0, "machine cannot be empty");
+  static_assert(SymbolCount > 0, "machine needs to accept input");
+  static_assert(detail::statesInRange<StateCount, StateDecls...>(), "state ID is not less than the state count");
+  static_assert(detail::statesUnique<StateDecls...>(), "state declared more than once");
+  static_assert(detail::startCount<StateDecls...>() == 1, "machine needs exactly one start state");
+  static_assert(detail::transitionsInRange<StateCount, SymbolCount, TransDecls...>(),
+                "transition state or symbol out of range");
+  static_assert(detail::transitionsUnique<SymbolCount, TransDecls...>(),
+                "transition declared more than once for a state and symbol");
+
+public:
+  // smallest unsigned type that holds every state ID and the no-state marker
+  using state_type = std::conditional_t<(StateCount < 0xFFu), std::uint8_t,
+                       std::conditional_t<(StateCount < 0xFFFFu), std::uint16_t, std::uint32_t>>;
+
+  // marker for a field of the table that has no transition
+  static constexpr state_type no_state = static_cast<state_type>(StateCount);
+
+  static constexpr unsigned int state_count = StateCount;
+  static constexpr unsigned int symbol_count = SymbolCount;
+
+  // transition table (continuous array for 2d array)
+  static constexpr std::array<state_type, static_cast<std::size_t>(StateCount) * SymbolCount> table =
+    detail::buildTable<state_type, StateCount, SymbolCount, TransDecls...>();
+
+  // accepting flag of each state
+  static constexpr std::array<bool, StateCount> accepting =
+    detail::buildAccepting<StateCount, StateDecls...>();
+
+  // starting state
+  static constexpr state_type start = detail::findStart<state_type, StateCount, StateDecls...>();
+
+  /*
+  Next State (compile time)
+  The state transitioned to from a state on a symbol, fails to compile if there is no such transition.
+  */
+  template <unsigned int From, unsigned int Symbol>
+  static constexpr state_type next_v = [] {
+    static_assert(From < StateCount, "state out of range");
+    static_assert(Symbol < SymbolCount, "symbol out of range");
+    static_assert(table[static_cast<std::size_t>(From) * SymbolCount + Symbol] != no_state,
+                  "no transition out of state on symbol");
+    return table[static_cast<std::size_t>(From) * SymbolCount + Symbol];
+  }();
+
+  /*
+  Next State
+  The state transitioned to from a state on a symbol, or no_state.
+  Note: the symbol must be less than the symbol count.
+  */
+  static constexpr state_type next(state_type from, unsigned int symbol) {
+    return table[static_cast<std::size_t>(from) * SymbolCount + symbol];
+  }
+
+  /*
+  Run Action
+  Calls the action of a state, if it has one.
+  */
+  static void runAction(state_type state) {
+    (runActionOf<StateDecls>(state), ...);
+  }
+
+  /*
+  Runner
+  Interpreter for the machine, starting in the start state.
+  */
+  class Runner {
+  public:
+    constexpr Runner() : current_state(start) {}
+
+    constexpr state_type state() const { return current_state; }
+
+    constexpr bool isAccepting() const { return accepting[current_state]; }
+
+    /*
+    Transition
+    Same as transition() of the C interpreter, without running the new state's action.
+    */
+    INTERP_STATUS transition(unsigned int symbol) {
+      if (symbol >= SymbolCount)
+        return INTERP_SYMB_ERR;
+      state_type next_state = next(current_state, symbol);
+      if (next_state == no_state)
+        return INTERP_TRANS_ERR;
+      current_state = next_state;
+      return INTERP_OK;
+    }
+
+    /*
+    Run
+    Same as runInterpreter() of the C interpreter: runs the current state's action, then transitions on
+    each symbol and runs each new state's action.
+    */
+    INTERP_STATUS run(const unsigned int *input, unsigned int input_length) {
+      runAction(current_state);
+      for (unsigned int i = 0; i < input_length; i++) {
+        INTERP_STATUS interp_status = transition(input[i]);
+        if (interp_status != INTERP_OK)
+          return interp_status;
+        runAction(current_state);
+      }
+      return isAccepting() ? INTERP_ACCEPT : INTERP_NO_ACCEPT;
+    }
+
+  private:
+    state_type current_state;
+  };
+
+private:
+  template <typename StateDecl>
+  static void runActionOf(state_type state) {
+    if constexpr (StateDecl::action != nullptr) {
+      if (state == StateDecl::id)
+        StateDecl::action();
+    }
+  }
+};
+
+}  // namespace static_fsm
+
+#endif
@@ -0,0 +1,69 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+
+#include "table.h"
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize State Table
+Actions:
+  • allocate the transition table and accepting bitmap
+  • translate each State pointer of the machine's table into its ID
+  • mark accepting states in the bitmap
+*/
+FSM_STATUS initStateTable(StateTable *table, FSM *fsm) {
+  // validate inputs
+  if (table == NULL || fsm == NULL || fsm->D == NULL)
+    return FSM_NO_MACHINE;
+
+  // allocate
+  size_t cells = (size_t)fsm->Qc * fsm->Ec;
+  size_t words = ((size_t)fsm->Qc + 63) / 64;
+  table->next = malloc(cells * sizeof(unsigned int));
+  table->accept = calloc(words, sizeof(unsigned long long));
+
+  // check if allocation was successful
+  if (table->next == NULL || table->accept == NULL) {
+    free(table->next);
+    free(table->accept);
+    table->next = NULL;
+    table->accept = NULL;
+    return FSM_ALLOC_ERR;
+  }
+
+  // copy transitions
+  for (size_t i = 0; i < cells; i++)
+    table->next[i] = (fsm->D[i] == NULL) ? TABLE_NO_STATE : fsm->D[i]->id;
+
+  // copy accepting states
+  for (unsigned int i = 0; i < fsm->Qc; i++)
+    if (fsm->Q[i].type == ACCEPT_STATE)
+      table->accept[i >> 6] |= 1ULL << (i & 63);
+
+  table->Qc = fsm->Qc;
+  table->Ec = fsm->Ec;
+  table->start = (fsm->Qs == NULL) ? TABLE_NO_STATE : fsm->Qs->id;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free State Table
+Actions:
+  • free the transition table and accepting bitmap
+*/
+void freeStateTable(StateTable *table) {
+  if (table == NULL)
+    return;
+
+  free(table->next);
+  free(table->accept);
+  table->next = NULL;
+  table->accept = NULL;
+  table->Qc = 0;
+  table->Ec = 0;
+}
@@ -0,0 +1,97 @@
+// Author: Kevin Imlay
+
+/*
+The state table is a frozen, integer-only copy of a FSM's transition table. The FSM's own table stores a
+State pointer in every field, which is convenient for building and editing a machine but wide and
+indirect to run. The state table instead stores the ID of the next state in every field and keeps the
+accepting states in a bitmap, so it can be walked without touching the list of states at all.
+
+The state table is a snapshot: changes made to the FSM after the table has been created are not seen
+by the table.
+*/
+
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "fsm.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Marker for a field of the table that has no transition, or a start state that is not set.
+*/
+#define TABLE_NO_STATE 0xFFFFFFFFu
+
+
+/* ----- Structures ----- */
+
+/*
+Integer transition table.
+*/
+typedef struct {
+  // count of states in the machine
+  unsigned int Qc;
+
+  // count of input alphabet symbols
+  unsigned int Ec;
+
+  // transition table of next state IDs (continuous array for 2d array)
+  unsigned int *next;
+
+  // bitmap of accepting states, one bit per state ID
+  unsigned long long *accept;
+
+  // ID of the starting state
+  unsigned int start;
+
+} StateTable;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize State Table
+Allocates a state table and fills it from a FSM.
+
+Arguments:
+  • table - pointer to the state table to initialize.
+  • fsm - pointer to an initialized FSM to copy the transitions of.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either the table or machine pointer provided was null, or the machine is not
+      initialized.
+*/
+FSM_STATUS initStateTable(StateTable *table, FSM *fsm);
+
+
+/*
+Free State Table
+Releases the memory held by a state table.
+
+Arguments:
+  • table - pointer to the state table.
+      Note: may be null.
+*/
+void freeStateTable(StateTable *table);
+
+
+/*
+Is Accepting
+Checks the accepting bitmap for a state ID.
+
+Arguments:
+  • table - pointer to the state table.
+  • state_id - ID of the state, must be less than the table's state count.
+
+Returns:
+  • 1 - if the state is an accepting state.
+  • 0 - if not.
+*/
+static inline int isAccepting(const StateTable *table, unsigned int state_id) {
+  return (int)((table->accept[state_id >> 6] >> (state_id & 63)) & 1);
+}
+
+#endif
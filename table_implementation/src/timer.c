@@ -0,0 +1,364 @@
+// Author: Kevin Imlay
+
+#include <stddef.h>
+
+#include "timer.h"
+
+/* ----- Private Definitions ----- */
+
+/*
+Slot index mask, and the furthest a timer can be armed from the next tick.
+*/
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+#define TIMER_MAX_TICKS ((1ULL << (TIMER_SLOT_BITS * TIMER_LEVELS)) - 1)
+
+/*
+Offset from a timer node to the timed interpreter it is part of.
+*/
+#define TIMED_OF(timer) ((TimedInterpreter *)((char *)(timer) - offsetof(TimedInterpreter, timer)))
+
+
+/* ----- Private Function Prototypes ----- */
+
+static void linkTimer(TimerWheel *wheel, Timer *timer);
+static void unlinkTimer(Timer *timer);
+static unsigned int cascade(TimerWheel *wheel, unsigned int level);
+static void armStateTimeout(TimedInterpreter *timed);
+static void expireTimeout(Timer *timer);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Wheel
+Actions:
+  • points every slot's list head at itself
+*/
+void initWheel(TimerWheel *wheel, unsigned long long now) {
+  wheel->now = now;
+  wheel->armed = 0;
+  for (unsigned int level = 0; level < TIMER_LEVELS; level++)
+    for (unsigned int slot = 0; slot < TIMER_SLOTS; slot++) {
+      wheel->slots[level][slot].next = &wheel->slots[level][slot];
+      wheel->slots[level][slot].prev = &wheel->slots[level][slot];
+    }
+}
+
+
+/*
+Initialize Timer
+Actions:
+  • clears the links, and sets the expire function
+*/
+void initTimer(Timer *timer, void (*expire)(Timer *timer)) {
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->expires = 0;
+  timer->expire = expire;
+}
+
+
+/*
+Arm Timer
+Actions:
+  • unlinks the timer if it is armed
+  • sets its expiry, clamped to the span of the wheel, and links it into its slot
+*/
+void armTimer(TimerWheel *wheel, Timer *timer, unsigned long long ticks) {
+  if (timerArmed(timer))
+    unlinkTimer(timer);
+  else
+    wheel->armed++;
+
+  // a timer armed for 1 tick expires on the next tick processed
+  if (ticks == 0)
+    ticks = 1;
+  if (ticks - 1 > TIMER_MAX_TICKS)
+    ticks = TIMER_MAX_TICKS + 1;
+  timer->expires = wheel->now + ticks - 1;
+  linkTimer(wheel, timer);
+}
+
+
+/*
+Cancel Timer
+Actions:
+  • unlinks the timer if it is armed
+*/
+void cancelTimer(TimerWheel *wheel, Timer *timer) {
+  if (!timerArmed(timer))
+    return;
+  unlinkTimer(timer);
+  wheel->armed--;
+}
+
+
+/*
+Timer Armed
+Actions:
+  • an unlinked timer has no next node
+*/
+int timerArmed(const Timer *timer) {
+  return timer->next != NULL;
+}
+
+
+/*
+Advance Wheel
+Actions:
+  • for each tick, cascades the higher levels down when the level below wraps around
+  • moves the tick's slot onto a local list and moves time past the tick, so timers armed by expire
+    functions land in later ticks
+  • unlinks and expires each timer on the local list
+*/
+unsigned long long advanceWheel(TimerWheel *wheel, unsigned long long ticks) {
+  unsigned long long expired = 0;
+
+  for (unsigned long long step = 0; step < ticks; step++) {
+    unsigned int slot = wheel->now & TIMER_SLOT_MASK;
+    for (unsigned int level = 1; level < TIMER_LEVELS && slot == 0; level++)
+      slot = cascade(wheel, level);
+
+    Timer *head = &wheel->slots[0][wheel->now & TIMER_SLOT_MASK];
+    wheel->now++;
+    if (head->next != head) {
+      Timer due;
+      due.next = head->next;
+      due.prev = head->prev;
+      due.next->prev = &due;
+      due.prev->next = &due;
+      head->next = head;
+      head->prev = head;
+
+      while (due.next != &due) {
+        Timer *timer = due.next;
+        unlinkTimer(timer);
+        wheel->armed--;
+        expired++;
+        timer->expire(timer);
+      }
+    }
+  }
+
+  return expired;
+}
+
+
+/*
+Initialize Timeouts
+Actions:
+  • allocates a timeout per state, all cleared
+*/
+FSM_STATUS initTimeouts(Timeouts *timeouts, FSM *fsm) {
+  // validate inputs
+  if (timeouts == NULL || fsm == NULL || fsm->Q == NULL)
+    return FSM_NO_MACHINE;
+
+  // allocate
+  timeouts->ticks = calloc(fsm->Qc, sizeof(unsigned long long));
+  timeouts->symbol = calloc(fsm->Qc, sizeof(unsigned int));
+  if (timeouts->ticks == NULL || timeouts->symbol == NULL) {
+    free(timeouts->ticks);
+    free(timeouts->symbol);
+    timeouts->ticks = NULL;
+    timeouts->symbol = NULL;
+    return FSM_ALLOC_ERR;
+  }
+  timeouts->Qc = fsm->Qc;
+  timeouts->Ec = fsm->Ec;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Timeouts
+Actions:
+  • frees the per state arrays
+*/
+void freeTimeouts(Timeouts *timeouts) {
+  if (timeouts == NULL)
+    return;
+
+  free(timeouts->ticks);
+  free(timeouts->symbol);
+  timeouts->ticks = NULL;
+  timeouts->symbol = NULL;
+  timeouts->Qc = 0;
+}
+
+
+/*
+Set Timeout
+Actions:
+  • validates the state and symbol
+  • records the state's timeout
+*/
+FSM_STATUS setTimeout(Timeouts *timeouts, unsigned int state_id, unsigned long long ticks, unsigned int symbol) {
+  // validate inputs
+  if (timeouts == NULL || timeouts->ticks == NULL)
+    return FSM_NO_MACHINE;
+  if (state_id >= timeouts->Qc)
+    return FSM_NO_STATE;
+  if (symbol >= timeouts->Ec)
+    return FSM_SIZE_ERR;
+
+  timeouts->ticks[state_id] = ticks;
+  timeouts->symbol[state_id] = symbol;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Initialize Timed Interpreter
+Actions:
+  • validates the timeouts are of the machine
+  • initializes the interpreter
+  • arms the start state's timeout
+*/
+INTERP_STATUS initTimedInterpreter(TimedInterpreter *timed, FSM *machine, const Timeouts *timeouts,
+                                   TimerWheel *wheel) {
+  // validate inputs
+  if (timed == NULL)
+    return INTERP_NO_INTERP;
+  if (machine == NULL || timeouts == NULL || wheel == NULL || timeouts->Qc != machine->Qc)
+    return INTERP_NO_MACHINE;
+
+  INTERP_STATUS status = initInterpreter(&timed->interp, machine);
+  if (status != INTERP_OK)
+    return status;
+
+  timed->timeouts = timeouts;
+  timed->wheel = wheel;
+  initTimer(&timed->timer, expireTimeout);
+  timed->status = INTERP_OK;
+  armStateTimeout(timed);
+
+  // successful
+  return INTERP_OK;
+}
+
+
+/*
+Timed Transition
+Actions:
+  • performs the transition and runs the new state's action
+  • re-arms the timeout of the new state, or cancels it if the state has none
+*/
+INTERP_STATUS timedTransition(TimedInterpreter *timed, unsigned int symbol) {
+  if (timed == NULL)
+    return INTERP_NO_INTERP;
+
+  State *new_state = NULL;
+  timed->status = transition(&timed->interp, symbol, &new_state);
+  if (timed->status != INTERP_OK)
+    return timed->status;
+
+  runState(&timed->interp);
+  armStateTimeout(timed);
+
+  return INTERP_OK;
+}
+
+
+/*
+Stop Timed Interpreter
+Actions:
+  • cancels the timeout
+*/
+void stopTimedInterpreter(TimedInterpreter *timed) {
+  cancelTimer(timed->wheel, &timed->timer);
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Link Timer
+Actions:
+  • finds the lowest level whose span covers the time left until expiry
+  • links the timer at the tail of the slot its expiry falls in on that level
+  • timers already due go in the slot of the next tick
+*/
+static void linkTimer(TimerWheel *wheel, Timer *timer) {
+  unsigned long long left = timer->expires - wheel->now;
+  Timer *head;
+
+  if ((long long)left < 0) {
+    head = &wheel->slots[0][wheel->now & TIMER_SLOT_MASK];
+  } else {
+    unsigned int level = 0;
+    while (level < TIMER_LEVELS - 1 && left >= (1ULL << (TIMER_SLOT_BITS * (level + 1))))
+      level++;
+    head = &wheel->slots[level][(timer->expires >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK];
+  }
+
+  timer->next = head;
+  timer->prev = head->prev;
+  head->prev->next = timer;
+  head->prev = timer;
+}
+
+
+/*
+Unlink Timer
+Actions:
+  • removes the timer from its slot, and marks it not armed
+*/
+static void unlinkTimer(Timer *timer) {
+  timer->prev->next = timer->next;
+  timer->next->prev = timer->prev;
+  timer->next = NULL;
+  timer->prev = NULL;
+}
+
+
+/*
+Cascade
+Actions:
+  • empties the level's slot for the current time, and relinks each of its timers into a lower level
+  • returns the slot index, 0 meaning this level wrapped around too and the next level is due
+*/
+static unsigned int cascade(TimerWheel *wheel, unsigned int level) {
+  unsigned int slot = (wheel->now >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK;
+  Timer *head = &wheel->slots[level][slot];
+
+  Timer *timer = head->next;
+  head->next = head;
+  head->prev = head;
+  while (timer != head) {
+    Timer *next = timer->next;
+    linkTimer(wheel, timer);
+    timer = next;
+  }
+
+  return slot;
+}
+
+
+/*
+Arm State Timeout
+Actions:
+  • arms the timer for the current state's timeout, or cancels it if the state has none
+*/
+static void armStateTimeout(TimedInterpreter *timed) {
+  unsigned long long ticks = timed->timeouts->ticks[timed->interp.current_state->id];
+  if (ticks == TIMER_NONE)
+    cancelTimer(timed->wheel, &timed->timer);
+  else
+    armTimer(timed->wheel, &timed->timer, ticks);
+}
+
+
+/*
+Expire Timeout
+Actions:
+  • inputs the timed out state's symbol to its interpreter
+*/
+static void expireTimeout(Timer *timer) {
+  TimedInterpreter *timed = TIMED_OF(timer);
+  timedTransition(timed, timed->timeouts->symbol[timed->interp.current_state->id]);
+}
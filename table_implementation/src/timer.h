@@ -0,0 +1,275 @@
+// Author: Kevin Imlay
+
+/*
+Timeouts let a state take a transition when no symbol arrives within a time: each state may be given a
+timeout in ticks and a symbol, and an interpreter that stays in the state for that many ticks is sent
+the symbol, the same as any other symbol.
+
+Timers are kept in a hierarchical timing wheel. The wheel has TIMER_LEVELS levels of TIMER_SLOTS slots,
+each level's slots spanning TIMER_SLOTS times the ticks of the level below. A timer is put in the slot
+of the lowest level that covers its expiry, and when the lower levels wrap around, the next slot up is
+cascaded down into them. Arming and cancelling are O(1), and each timer is cascaded at most once per
+level, so expiring is O(1) amortized. Timers are linked into the wheel through a node kept in the
+timer's owner, so arming never allocates.
+
+The wheel has no clock of its own: time only moves when advanceWheel() is called, so it can be driven
+from a real clock, or from a virtual clock in tests.
+*/
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Slots per level are 1 << TIMER_SLOT_BITS.
+*/
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1u << TIMER_SLOT_BITS)
+
+/*
+Levels of the wheel, timers further out than the top level covers are clamped to it.
+*/
+#define TIMER_LEVELS 6
+
+/*
+Marker for a state without a timeout.
+*/
+#define TIMER_NONE 0
+
+
+/* ----- Structures ----- */
+
+/*
+Timer, linked into a slot of the wheel while armed.
+*/
+typedef struct Timer {
+  struct Timer *next;
+  struct Timer *prev;
+
+  // tick the timer expires on
+  unsigned long long expires;
+
+  // called when the timer expires, after it has been unlinked
+  void (*expire)(struct Timer *timer);
+
+} Timer;
+
+
+/*
+Hierarchical timing wheel.
+*/
+typedef struct {
+  // next tick to be processed, every earlier tick has been
+  unsigned long long now;
+
+  // list head of each slot
+  Timer slots[TIMER_LEVELS][TIMER_SLOTS];
+
+  // count of armed timers
+  unsigned long long armed;
+
+} TimerWheel;
+
+
+/*
+Timeout of each state of a machine.
+*/
+typedef struct {
+  unsigned int Qc;
+  unsigned int Ec;
+
+  // ticks of each state's timeout, or TIMER_NONE
+  unsigned long long *ticks;
+
+  // symbol sent when each state's timeout expires
+  unsigned int *symbol;
+
+} Timeouts;
+
+
+/*
+Interpreter whose states may time out.
+*/
+typedef struct {
+  Interpreter interp;
+  Timer timer;
+  const Timeouts *timeouts;
+  TimerWheel *wheel;
+
+  // status of the last transition, including transitions on timeouts
+  INTERP_STATUS status;
+
+} TimedInterpreter;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Wheel
+Initializes an empty timing wheel.
+
+Arguments:
+  • wheel - pointer to the wheel.
+  • now - tick to start the wheel at.
+*/
+void initWheel(TimerWheel *wheel, unsigned long long now);
+
+
+/*
+Initialize Timer
+Initializes a timer that is not armed.
+
+Arguments:
+  • timer - pointer to the timer.
+  • expire - function called with the timer when it expires.
+*/
+void initTimer(Timer *timer, void (*expire)(Timer *timer));
+
+
+/*
+Arm Timer
+Arms a timer to expire a number of ticks from now. An armed timer is re-armed.
+
+Arguments:
+  • wheel - pointer to the wheel.
+  • timer - pointer to a timer initialized with initTimer().
+  • ticks - ticks from now, at least 1.
+*/
+void armTimer(TimerWheel *wheel, Timer *timer, unsigned long long ticks);
+
+
+/*
+Cancel Timer
+Disarms a timer. Cancelling a timer that is not armed does nothing.
+
+Arguments:
+  • wheel - pointer to the wheel.
+  • timer - pointer to the timer.
+*/
+void cancelTimer(TimerWheel *wheel, Timer *timer);
+
+
+/*
+Timer Armed
+Checks if a timer is armed.
+
+Arguments:
+  • timer - pointer to the timer.
+
+Returns:
+  • 1 - if armed.
+  • 0 - if not.
+*/
+int timerArmed(const Timer *timer);
+
+
+/*
+Advance Wheel
+Moves the wheel's time forward, expiring every timer due on the way in order of tick. Expire functions
+may arm and cancel timers.
+
+Arguments:
+  • wheel - pointer to the wheel.
+  • ticks - ticks to move forward.
+
+Returns:
+  • count of timers expired.
+*/
+unsigned long long advanceWheel(TimerWheel *wheel, unsigned long long ticks);
+
+
+/*
+Initialize Timeouts
+Allocates the timeouts of a machine, with no state timing out.
+
+Arguments:
+  • timeouts - pointer to the timeouts to initialize.
+  • fsm - pointer to an initialized FSM.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either pointer provided was null, or the machine is not initialized.
+*/
+FSM_STATUS initTimeouts(Timeouts *timeouts, FSM *fsm);
+
+
+/*
+Free Timeouts
+Releases the memory held by timeouts.
+
+Arguments:
+  • timeouts - pointer to the timeouts.
+      Note: may be null.
+*/
+void freeTimeouts(Timeouts *timeouts);
+
+
+/*
+Set Timeout
+Sets the timeout of a state.
+
+Arguments:
+  • timeouts - pointer to the timeouts.
+  • state_id - unsigned integer ID of the state.
+  • ticks - ticks the state times out after, or TIMER_NONE to not time out.
+  • symbol - symbol sent to the interpreter when the state times out.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_NO_STATE - if the state ID is not in the machine.
+  • FSM_SIZE_ERR - if the symbol is larger than the number of symbols set in the machine.
+  • FSM_NO_MACHINE - the timeouts pointer provided was null.
+*/
+FSM_STATUS setTimeout(Timeouts *timeouts, unsigned int state_id, unsigned long long ticks, unsigned int symbol);
+
+
+/*
+Initialize Timed Interpreter
+Initializes an interpreter that times out, and arms the start state's timeout.
+
+Arguments:
+  • timed - pointer to the timed interpreter.
+  • machine - pointer to the FSM to run.
+  • timeouts - pointer to the timeouts of the machine.
+  • wheel - pointer to the wheel to arm timeouts on.
+
+Returns:
+  • same as initInterpreter().
+  • INTERP_NO_MACHINE - also if the timeouts or wheel provided are null, or the timeouts are not of the
+      machine.
+*/
+INTERP_STATUS initTimedInterpreter(TimedInterpreter *timed, FSM *machine, const Timeouts *timeouts,
+                                   TimerWheel *wheel);
+
+
+/*
+Timed Transition
+Inputs a symbol to a timed interpreter, runs the new state's action, and re-arms the timeout for the new
+state, so a timeout is counted from the last symbol.
+
+Arguments:
+  • timed - pointer to the timed interpreter.
+  • symbol - unsigned integer symbol.
+
+Returns:
+  • same as transition().
+      Note: on an error the state and its timeout are left as they were.
+*/
+INTERP_STATUS timedTransition(TimedInterpreter *timed, unsigned int symbol);
+
+
+/*
+Stop Timed Interpreter
+Cancels the timed interpreter's timeout.
+
+Arguments:
+  • timed - pointer to the timed interpreter.
+*/
+void stopTimedInterpreter(TimedInterpreter *timed);
+
+#endif
@@ -0,0 +1,288 @@
+// Author: Kevin Imlay
+
+#include <string.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define TRACE_MMAP
+#endif
+
+#include "trace.h"
+
+/* ----- Private Function Prototypes ----- */
+
+static const unsigned char *readVarint(const unsigned char *p, const unsigned char *end, uint32_t *value);
+static int startBlock(TraceReader *reader);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Trace Log
+Actions:
+  • rounds the size up to whole blocks
+  • maps the file, sized to the log, or allocates zeroed memory
+  • starts the first block
+*/
+FSM_STATUS initTraceLog(TraceLog *log, size_t bytes, const char *path) {
+  // validate inputs
+  if (log == NULL)
+    return FSM_NO_MACHINE;
+
+  log->block_count = (bytes + TRACE_BLOCK_SIZE - 1) / TRACE_BLOCK_SIZE;
+  if (log->block_count < 2)
+    log->block_count = 2;
+  size_t total = log->block_count * TRACE_BLOCK_SIZE;
+  log->data = NULL;
+  log->mapped = 0;
+
+  // allocate
+  if (path != NULL) {
+#ifdef TRACE_MMAP
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return FSM_ALLOC_ERR;
+    if (ftruncate(fd, (off_t)total) == 0) {
+      void *memory = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (memory != MAP_FAILED) {
+        log->data = memory;
+        log->mapped = total;
+      }
+    }
+    close(fd);
+#endif
+  } else {
+    log->data = calloc(log->block_count, TRACE_BLOCK_SIZE);
+  }
+  if (log->data == NULL)
+    return FSM_ALLOC_ERR;
+
+  // first block
+  log->block = NULL;
+  log->records = 0;
+  nextTraceBlock(log);
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Trace Log
+Actions:
+  • unmaps or frees the ring
+*/
+void freeTraceLog(TraceLog *log) {
+  if (log == NULL)
+    return;
+
+#ifdef TRACE_MMAP
+  if (log->mapped > 0)
+    munmap(log->data, log->mapped);
+  else
+#endif
+    free(log->data);
+  log->data = NULL;
+  log->block = NULL;
+  log->mapped = 0;
+}
+
+
+/*
+Trace Bytes
+Actions:
+  • the ring is a whole number of blocks
+*/
+size_t traceBytes(const TraceLog *log) {
+  return log->block_count * TRACE_BLOCK_SIZE;
+}
+
+
+/*
+Next Trace Block
+Actions:
+  • moves to the block after the current one in the ring, overwriting it
+  • writes its header, clears the previous record so the block decodes on its own
+*/
+void nextTraceBlock(TraceLog *log) {
+  uint64_t sequence = (log->block == NULL) ? 1 : log->block->sequence + 1;
+  unsigned char *start = log->data + (size_t)((sequence - 1) % log->block_count) * TRACE_BLOCK_SIZE;
+
+  log->block = (TraceBlock *)start;
+  log->block->bytes = 0;
+  log->block->magic = TRACE_MAGIC;
+  log->block->sequence = sequence;
+  log->cursor = start + sizeof(TraceBlock);
+  log->end = start + TRACE_BLOCK_SIZE;
+  log->prev_instance = 0;
+  log->prev_state = 0;
+}
+
+
+/*
+Traced Transition
+Actions:
+  • performs the transition
+  • records it if it succeeded
+*/
+INTERP_STATUS tracedTransition(Interpreter *interp, TraceLog *log, unsigned int instance, unsigned int symbol) {
+  State *new_state = NULL;
+  INTERP_STATUS status = transition(interp, symbol, &new_state);
+  if (status == INTERP_OK)
+    traceRecord(log, instance, symbol, new_state->id);
+  return status;
+}
+
+
+/*
+Open Trace
+Actions:
+  • finds the newest block, the ring holds up to block count blocks before it
+  • starts at the oldest block still in the ring
+*/
+void openTrace(TraceReader *reader, const unsigned char *data, size_t bytes) {
+  reader->data = data;
+  reader->block_count = bytes / TRACE_BLOCK_SIZE;
+  reader->last_sequence = 0;
+  reader->cursor = NULL;
+  reader->end = NULL;
+
+  for (size_t i = 0; i < reader->block_count; i++) {
+    TraceBlock header;
+    memcpy(&header, data + i * TRACE_BLOCK_SIZE, sizeof(header));
+    if (header.magic == TRACE_MAGIC && header.sequence > reader->last_sequence)
+      reader->last_sequence = header.sequence;
+  }
+
+  reader->sequence = (reader->last_sequence > reader->block_count) ?
+                     reader->last_sequence - reader->block_count + 1 : 1;
+}
+
+
+/*
+Next Trace Record
+Actions:
+  • moves to the next block in order when the current one is done
+  • decodes the three varints, undoing the zigzag changes
+  • stops early at a truncated record, which only a crash while writing leaves
+*/
+int nextTraceRecord(TraceReader *reader, TraceRecord *record) {
+  uint32_t fields[3];
+  const unsigned char *p = NULL;
+  while (p == NULL) {
+    while (reader->cursor == reader->end)
+      if (!startBlock(reader))
+        return 0;
+
+    p = reader->cursor;
+    for (int i = 0; i < 3 && p != NULL; i++)
+      p = readVarint(p, reader->end, &fields[i]);
+    reader->cursor = (p != NULL) ? p : reader->end;
+  }
+
+  reader->prev_instance += (fields[0] >> 1) ^ (0u - (fields[0] & 1));
+  reader->prev_state += (fields[2] >> 1) ^ (0u - (fields[2] & 1));
+  record->instance = reader->prev_instance;
+  record->symbol = fields[1];
+  record->state = reader->prev_state;
+  return 1;
+}
+
+
+/*
+Replay Trace
+Actions:
+  • takes the state of each instance from its first record
+  • steps each later record through the transition table from the instance's state, checking the
+    recorded state is reached
+  • runs the entered state's action if asked
+*/
+INTERP_STATUS replayTrace(TraceReader *reader, FSM *fsm, unsigned int instance_count, int run_actions,
+                          unsigned long long *replayed) {
+  // validate inputs
+  if (fsm == NULL || fsm->D == NULL)
+    return INTERP_NO_MACHINE;
+
+  State **current = calloc(instance_count ? instance_count : 1, sizeof(State*));
+  if (current == NULL)
+    return INTERP_ALLOC_ERR;
+
+  INTERP_STATUS status = INTERP_OK;
+  unsigned long long count = 0;
+  TraceRecord record;
+  while (nextTraceRecord(reader, &record)) {
+    if (record.instance >= instance_count || record.symbol >= fsm->Ec || record.state >= fsm->Qc) {
+      status = INTERP_SYMB_ERR;
+      break;
+    }
+
+    State *next = &fsm->Q[record.state];
+    if (current[record.instance] != NULL &&
+        fsm->D[(size_t)current[record.instance]->id * fsm->Ec + record.symbol] != next) {
+      status = INTERP_TRANS_ERR;
+      break;
+    }
+    current[record.instance] = next;
+    if (run_actions && next->action != NULL)
+      next->action();
+    count++;
+  }
+
+  *replayed = count;
+  free(current);
+  return status;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Read Varint
+Actions:
+  • reads 7 bits per byte, low first, while the high bit is set
+  • returns the byte after the varint, or null if it runs past the end or past 32 bits
+*/
+static const unsigned char *readVarint(const unsigned char *p, const unsigned char *end, uint32_t *value) {
+  uint32_t result = 0;
+  for (unsigned int shift = 0; shift < 35; shift += 7) {
+    if (p == end)
+      return NULL;
+    unsigned char byte = *p++;
+    result |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+
+/*
+Start Block
+Actions:
+  • moves to the next sequence, skipping blocks that do not hold it
+  • sets the records to read and clears the previous record
+  • returns 0 once past the newest block
+*/
+static int startBlock(TraceReader *reader) {
+  while (reader->sequence <= reader->last_sequence) {
+    uint64_t sequence = reader->sequence++;
+    const unsigned char *start = reader->data + (size_t)((sequence - 1) % reader->block_count) * TRACE_BLOCK_SIZE;
+    TraceBlock header;
+    memcpy(&header, start, sizeof(header));
+    if (header.magic != TRACE_MAGIC || header.sequence != sequence ||
+        header.bytes > TRACE_BLOCK_SIZE - sizeof(TraceBlock))
+      continue;
+
+    reader->cursor = start + sizeof(TraceBlock);
+    reader->end = reader->cursor + header.bytes;
+    reader->prev_instance = 0;
+    reader->prev_state = 0;
+    return 1;
+  }
+
+  return 0;
+}
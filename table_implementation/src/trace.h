@@ -0,0 +1,289 @@
+// Author: Kevin Imlay
+
+/*
+Traces record the transitions an interpreter takes, as (instance, symbol, new state) records, so the path
+a misbehaving instance went through can be read back and replayed against the machine.
+
+A trace log is a ring of TRACE_BLOCK_SIZE byte blocks. Records are appended to the current block and when
+it is full the next block of the ring is started, overwriting the oldest, so the log always holds the
+latest transitions. Within a block each record is three varints: the change of instance from the last
+record, the symbol, and the change of state from the last record, with changes zigzag encoded so small
+steps either way take one byte. Each block starts from zero, so blocks decode on their own once older ones
+are overwritten.
+
+A log has a single writer and takes no locks: give each thread its own log. A log can be backed by a
+file mapped into memory, so the trace outlives a crash of the process writing it. A log is read after its
+writer has stopped.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Bytes per block of a trace log, including its header.
+*/
+#define TRACE_BLOCK_SIZE 4096
+
+/*
+Largest encoded record, three 32 bit varints.
+*/
+#define TRACE_RECORD_MAX 15
+
+/*
+Marks a block as part of a trace log.
+*/
+#define TRACE_MAGIC 0x54524345u
+
+
+/* ----- Structures ----- */
+
+/*
+Header at the start of each block.
+*/
+typedef struct {
+  // position of the block in the log, from 1, 0 if the block was never written
+  uint64_t sequence;
+
+  // bytes of records after the header
+  uint32_t bytes;
+
+  uint32_t magic;
+
+} TraceBlock;
+
+
+/*
+Trace log, written by one thread.
+*/
+typedef struct {
+  // blocks of the ring
+  unsigned char *data;
+  size_t block_count;
+
+  // block being written, and where the next record goes
+  TraceBlock *block;
+  unsigned char *cursor;
+  unsigned char *end;
+
+  // last record written in the block, changes are encoded from it
+  unsigned int prev_instance;
+  unsigned int prev_state;
+
+  // count of records written
+  unsigned long long records;
+
+  // bytes mapped, 0 if heap allocated
+  size_t mapped;
+
+} TraceLog;
+
+
+/*
+Decoded trace record.
+*/
+typedef struct {
+  unsigned int instance;
+  unsigned int symbol;
+  unsigned int state;
+} TraceRecord;
+
+
+/*
+Reads the records of a trace log, oldest first.
+*/
+typedef struct {
+  const unsigned char *data;
+  size_t block_count;
+
+  // next block to read, and the last
+  uint64_t sequence;
+  uint64_t last_sequence;
+
+  // records left in the current block
+  const unsigned char *cursor;
+  const unsigned char *end;
+  unsigned int prev_instance;
+  unsigned int prev_state;
+
+} TraceReader;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Trace Log
+Allocates an empty trace log, in memory or backed by a file.
+
+Arguments:
+  • log - pointer to the trace log to initialize.
+  • bytes - size of the log, rounded up to whole blocks, at least 2.
+  • path - file to back the log with, created or truncated, or null to keep the log in memory.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if the memory or file was not able to be allocated or mapped.
+  • FSM_NO_MACHINE - the log pointer provided was null.
+*/
+FSM_STATUS initTraceLog(TraceLog *log, size_t bytes, const char *path);
+
+
+/*
+Free Trace Log
+Releases a trace log, leaving the file backing it, if any, with the trace.
+
+Arguments:
+  • log - pointer to the trace log.
+      Note: may be null.
+*/
+void freeTraceLog(TraceLog *log);
+
+
+/*
+Trace Bytes
+Gets the size of a trace log's ring, for reading it with openTrace().
+
+Arguments:
+  • log - pointer to the trace log.
+
+Returns:
+  • size of the ring in bytes.
+*/
+size_t traceBytes(const TraceLog *log);
+
+
+/*
+Next Trace Block
+Starts the next block of the ring. Called by traceRecord() when the current block is full.
+
+Arguments:
+  • log - pointer to the trace log.
+*/
+void nextTraceBlock(TraceLog *log);
+
+
+/*
+Traced Transition
+Inputs a symbol to the interpreter as transition() does, and records the transition.
+
+Arguments:
+  • interp - pointer to the interpreter.
+  • log - pointer to the trace log.
+  • instance - unsigned integer ID of the interpreter in the trace.
+  • symbol - unsigned integer symbol.
+
+Returns:
+  • same as transition().
+      Note: failed transitions are not recorded.
+*/
+INTERP_STATUS tracedTransition(Interpreter *interp, TraceLog *log, unsigned int instance, unsigned int symbol);
+
+
+/*
+Open Trace
+Starts reading a trace log from its oldest record.
+
+Arguments:
+  • reader - pointer to the reader to initialize.
+  • data - the ring of a trace log, or the contents of a file that backed one.
+  • bytes - size of the ring in bytes.
+*/
+void openTrace(TraceReader *reader, const unsigned char *data, size_t bytes);
+
+
+/*
+Next Trace Record
+Reads the next record of a trace.
+
+Arguments:
+  • reader - pointer to the reader.
+  • record - [pass back] the record read.
+
+Returns:
+  • 1 - if a record was read.
+  • 0 - if there are no more records.
+*/
+int nextTraceRecord(TraceReader *reader, TraceRecord *record);
+
+
+/*
+Replay Trace
+Re-runs a trace against a machine, checking every recorded transition is the one the machine takes.
+The first record of each instance gives its state, as the trace may start partway through its run.
+
+Arguments:
+  • reader - pointer to a reader opened with openTrace().
+  • fsm - pointer to the fsm the trace was recorded from.
+  • instance_count - unsigned integer count of instances, one more than the largest instance ID.
+  • run_actions - if set, the action of every state entered is run, reproducing the side effects.
+  • replayed - [pass back] count of records replayed, the index of the first bad record on an error.
+
+Returns:
+  • INTERP_OK - if every transition was reproduced.
+  • INTERP_TRANS_ERR - if the machine takes a different transition than recorded.
+  • INTERP_SYMB_ERR - if a record has an instance, symbol or state not in the machine.
+  • INTERP_ALLOC_ERR - if needed memory was not able to be allocated.
+  • INTERP_NO_MACHINE - if the machine is null or not initialized.
+*/
+INTERP_STATUS replayTrace(TraceReader *reader, FSM *fsm, unsigned int instance_count, int run_actions,
+                          unsigned long long *replayed);
+
+
+/*
+Trace Varint
+Writes a varint, 7 bits per byte, low bits first, the high bit set on every byte but the last.
+
+Arguments:
+  • p - where to write the varint.
+  • value - unsigned 32 bit value.
+
+Returns:
+  • pointer to the byte after the varint.
+*/
+static inline unsigned char *traceVarint(unsigned char *p, uint32_t value) {
+  while (value >= 0x80) {
+    *p++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *p++ = (unsigned char)value;
+  return p;
+}
+
+
+/*
+Trace Record
+Appends a record to a trace log.
+
+Arguments:
+  • log - pointer to the trace log.
+  • instance - unsigned integer ID of the instance.
+  • symbol - unsigned integer symbol.
+  • state - unsigned integer ID of the state transitioned to.
+*/
+static inline void traceRecord(TraceLog *log, unsigned int instance, unsigned int symbol, unsigned int state) {
+  if (log->end - log->cursor < TRACE_RECORD_MAX)
+    nextTraceBlock(log);
+
+  // changes are zigzag encoded, so small steps back are small too
+  uint32_t instance_step = instance - log->prev_instance;
+  uint32_t state_step = state - log->prev_state;
+  unsigned char *p = log->cursor;
+  p = traceVarint(p, (instance_step << 1) ^ (0u - (instance_step >> 31)));
+  p = traceVarint(p, symbol);
+  p = traceVarint(p, (state_step << 1) ^ (0u - (state_step >> 31)));
+
+  log->cursor = p;
+  log->block->bytes = (uint32_t)(p - (unsigned char *)(log->block + 1));
+  log->prev_instance = instance;
+  log->prev_state = state;
+  log->records++;
+}
+
+#endif
@@ -0,0 +1,346 @@
+// Author: Kevin Imlay
+
+#include <string.h>
+
+#include "transducer.h"
+
+/* ----- Private Structures ----- */
+
+/*
+Tables read by each step of transduce().
+*/
+typedef struct {
+  State **table;
+  size_t symbol_count;
+  const OutputSpan *trans;
+  const OutputSpan *moore;
+  const unsigned int *pool;
+} StepTables;
+
+
+/* ----- Private Function Prototypes ----- */
+
+static int storeOutput(Transducer *transducer, const unsigned int *output, unsigned int output_length,
+                       OutputSpan *span);
+static unsigned int copyWidth(unsigned int output_max);
+static inline INTERP_STATUS stepFixed(const StepTables *tables, const unsigned int *input, size_t *position,
+                                      size_t end, unsigned int *output, size_t *out, State **state,
+                                      unsigned int mealy_width, unsigned int moore_width);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Transducer
+Actions:
+  • allocates an empty output per transition and per state
+*/
+FSM_STATUS initTransducer(Transducer *transducer, FSM *fsm) {
+  // validate inputs
+  if (transducer == NULL || fsm == NULL || fsm->D == NULL || fsm->Q == NULL)
+    return FSM_NO_MACHINE;
+
+  // allocate
+  transducer->trans = calloc((size_t)fsm->Qc * fsm->Ec, sizeof(OutputSpan));
+  transducer->state = calloc(fsm->Qc, sizeof(OutputSpan));
+  if (transducer->trans == NULL || transducer->state == NULL) {
+    free(transducer->trans);
+    free(transducer->state);
+    transducer->trans = NULL;
+    transducer->state = NULL;
+    return FSM_ALLOC_ERR;
+  }
+  transducer->fsm = fsm;
+  transducer->pool = NULL;
+  transducer->pool_count = 0;
+  transducer->pool_capacity = 0;
+  transducer->trans_max = 0;
+  transducer->state_max = 0;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Transducer
+Actions:
+  • frees the output tables and pool
+*/
+void freeTransducer(Transducer *transducer) {
+  if (transducer == NULL)
+    return;
+
+  free(transducer->trans);
+  free(transducer->state);
+  free(transducer->pool);
+  transducer->trans = NULL;
+  transducer->state = NULL;
+  transducer->pool = NULL;
+  transducer->pool_count = 0;
+  transducer->pool_capacity = 0;
+}
+
+
+/*
+Set Transition Output
+Actions:
+  • validates the state and symbol
+  • copies the output into the pool and points the transition at it
+*/
+FSM_STATUS setTransOutput(Transducer *transducer, unsigned int from_state_id, unsigned int symbol,
+                          const unsigned int *output, unsigned int output_length) {
+  // validate inputs
+  if (transducer == NULL || transducer->trans == NULL)
+    return FSM_NO_MACHINE;
+  if (from_state_id >= transducer->fsm->Qc)
+    return FSM_NO_STATE;
+  if (symbol >= transducer->fsm->Ec)
+    return FSM_SIZE_ERR;
+
+  OutputSpan *span = &transducer->trans[(size_t)from_state_id * transducer->fsm->Ec + symbol];
+  if (!storeOutput(transducer, output, output_length, span))
+    return FSM_ALLOC_ERR;
+  if (output_length > transducer->trans_max)
+    transducer->trans_max = output_length;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Set State Output
+Actions:
+  • validates the state
+  • copies the output into the pool and points the state at it
+*/
+FSM_STATUS setStateOutput(Transducer *transducer, unsigned int state_id, const unsigned int *output,
+                          unsigned int output_length) {
+  // validate inputs
+  if (transducer == NULL || transducer->state == NULL)
+    return FSM_NO_MACHINE;
+  if (state_id >= transducer->fsm->Qc)
+    return FSM_NO_STATE;
+
+  if (!storeOutput(transducer, output, output_length, &transducer->state[state_id]))
+    return FSM_ALLOC_ERR;
+  if (output_length > transducer->state_max)
+    transducer->state_max = output_length;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Transduce
+Actions:
+  • works out how many steps are sure to fit in the room left, from the longest output of a step
+  • runs that many steps writing outputs with no checks, then one checked step, and repeats
+  • in the unchecked steps, each kind of output is copied at a fixed width of 0, 1 or TRANSDUCER_WIDE from
+    its longest, so copying does not branch on length and a kind never written is not looked up
+  • a checked step that does not fit stops before it
+*/
+INTERP_STATUS transduce(Interpreter *interp, const Transducer *transducer, const unsigned int *input,
+                        size_t input_length, unsigned int *output, size_t capacity, size_t *written,
+                        size_t *consumed) {
+  // validate inputs
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL || transducer == NULL || transducer->fsm != interp->fsm)
+    return INTERP_NO_MACHINE;
+
+  StepTables tables = {interp->fsm->D, interp->fsm->Ec, transducer->trans, transducer->state, transducer->pool};
+  size_t step_max = (size_t)transducer->trans_max + transducer->state_max;
+
+  // copy widths, or 0 for both if an output is too long to copy at a fixed width
+  unsigned int mealy_width = copyWidth(transducer->trans_max);
+  unsigned int moore_width = copyWidth(transducer->state_max);
+  if (transducer->trans_max > TRANSDUCER_WIDE || transducer->state_max > TRANSDUCER_WIDE) {
+    mealy_width = 0;
+    moore_width = 0;
+  } else if (mealy_width > 0 && moore_width > 0 && mealy_width != moore_width) {
+    mealy_width = TRANSDUCER_WIDE;
+    moore_width = TRANSDUCER_WIDE;
+  }
+  int fixed = (step_max > 0 && (mealy_width > 0 || moore_width > 0));
+  size_t slack = (mealy_width > moore_width) ? mealy_width : moore_width;
+
+  State *state = interp->current_state;
+  INTERP_STATUS status = INTERP_OK;
+  size_t i = 0, out = 0;
+  while (i < input_length) {
+    // steps sure to fit, leaving room for a last fixed width copy, or else one step to be checked
+    size_t run = input_length - i;
+    if (step_max > 0) {
+      size_t room = capacity - out;
+      size_t fit = (room > slack) ? (room - slack) / step_max : 0;
+      if (fit < run)
+        run = fit;
+    }
+    int checked = (run == 0);
+    if (checked)
+      run = 1;
+
+    size_t end = i + run;
+    if (fixed && !checked) {
+      // each pair of widths gets its own loop, with the widths constant in it
+      if (mealy_width == 0 && moore_width == 1)
+        status = stepFixed(&tables, input, &i, end, output, &out, &state, 0, 1);
+      else if (mealy_width == 1 && moore_width == 0)
+        status = stepFixed(&tables, input, &i, end, output, &out, &state, 1, 0);
+      else if (mealy_width == 1)
+        status = stepFixed(&tables, input, &i, end, output, &out, &state, 1, 1);
+      else if (mealy_width == 0)
+        status = stepFixed(&tables, input, &i, end, output, &out, &state, 0, TRANSDUCER_WIDE);
+      else if (moore_width == 0)
+        status = stepFixed(&tables, input, &i, end, output, &out, &state, TRANSDUCER_WIDE, 0);
+      else
+        status = stepFixed(&tables, input, &i, end, output, &out, &state, TRANSDUCER_WIDE, TRANSDUCER_WIDE);
+    } else {
+      for (; i < end; i++) {
+        unsigned int symbol = input[i];
+        if (symbol >= tables.symbol_count) {
+          status = INTERP_SYMB_ERR;
+          break;
+        }
+        size_t index = (size_t)state->id * tables.symbol_count + symbol;
+        State *next = tables.table[index];
+        if (next == NULL) {
+          status = INTERP_TRANS_ERR;
+          break;
+        }
+        OutputSpan mealy = tables.trans[index];
+        OutputSpan entered = tables.moore[next->id];
+        if (checked && capacity - out < (size_t)mealy.length + entered.length)
+          break;
+
+        for (unsigned int k = 0; k < mealy.length; k++)
+          output[out + k] = tables.pool[mealy.first + k];
+        out += mealy.length;
+        for (unsigned int k = 0; k < entered.length; k++)
+          output[out + k] = tables.pool[entered.first + k];
+        out += entered.length;
+        state = next;
+      }
+    }
+    if (i < end)
+      break;
+  }
+
+  interp->current_state = state;
+  interp->position += i;
+  *written = out;
+  *consumed = i;
+
+  if (status != INTERP_OK || i < input_length)
+    return status;
+  return (state->type == ACCEPT_STATE) ? INTERP_ACCEPT : INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Store Output
+Actions:
+  • appends the output to the pool, doubling it when full, with the extra zeroed
+  • points the span at the copy
+*/
+static int storeOutput(Transducer *transducer, const unsigned int *output, unsigned int output_length,
+                       OutputSpan *span) {
+  if (output_length == 0) {
+    span->first = 0;
+    span->length = 0;
+    return 1;
+  }
+  if (output == NULL || transducer->pool_count + output_length > 0xFFFFFFFFu)
+    return 0;
+
+  // kept TRANSDUCER_WIDE longer than used, so wide copies stay within it
+  size_t needed = transducer->pool_count + output_length + TRANSDUCER_WIDE;
+  if (needed > transducer->pool_capacity) {
+    size_t capacity = transducer->pool_capacity ? transducer->pool_capacity * 2 : 256;
+    while (capacity < needed)
+      capacity *= 2;
+    unsigned int *grown = realloc(transducer->pool, capacity * sizeof(unsigned int));
+    if (grown == NULL)
+      return 0;
+    memset(&grown[transducer->pool_capacity], 0, (capacity - transducer->pool_capacity) * sizeof(unsigned int));
+    transducer->pool = grown;
+    transducer->pool_capacity = capacity;
+  }
+
+  memcpy(&transducer->pool[transducer->pool_count], output, output_length * sizeof(unsigned int));
+  span->first = (unsigned int)transducer->pool_count;
+  span->length = output_length;
+  transducer->pool_count += output_length;
+  return 1;
+}
+
+
+/*
+Copy Width
+Actions:
+  • 0 for outputs that are all empty, 1 for outputs of at most one symbol, else TRANSDUCER_WIDE
+*/
+static unsigned int copyWidth(unsigned int output_max) {
+  if (output_max <= 1)
+    return output_max;
+  return TRANSDUCER_WIDE;
+}
+
+
+/*
+Step Fixed
+Actions:
+  • steps from the position to the end, copying each transition's output then the entered state's output
+    at their width and advancing the output by their length
+  • skips looking up an output whose width is 0
+  • stops at an invalid symbol or a missing transition, leaving the position on it
+*/
+static inline INTERP_STATUS stepFixed(const StepTables *tables, const unsigned int *input, size_t *position,
+                                      size_t end, unsigned int *output, size_t *out, State **state,
+                                      unsigned int mealy_width, unsigned int moore_width) {
+  State **table = tables->table;
+  size_t symbol_count = tables->symbol_count;
+  const OutputSpan *trans = tables->trans;
+  const OutputSpan *moore = tables->moore;
+  const unsigned int *pool = tables->pool;
+  State *current = *state;
+  size_t i = *position, o = *out;
+  INTERP_STATUS status = INTERP_OK;
+
+  for (; i < end; i++) {
+    unsigned int symbol = input[i];
+    if (symbol >= symbol_count) {
+      status = INTERP_SYMB_ERR;
+      break;
+    }
+    size_t index = (size_t)current->id * symbol_count + symbol;
+    State *next = table[index];
+    if (next == NULL) {
+      status = INTERP_TRANS_ERR;
+      break;
+    }
+    if (mealy_width > 0) {
+      OutputSpan mealy = trans[index];
+      for (unsigned int k = 0; k < mealy_width; k++)
+        output[o + k] = pool[mealy.first + k];
+      o += mealy.length;
+    }
+    if (moore_width > 0) {
+      OutputSpan entered = moore[next->id];
+      for (unsigned int k = 0; k < moore_width; k++)
+        output[o + k] = pool[entered.first + k];
+      o += entered.length;
+    }
+    current = next;
+  }
+
+  *state = current;
+  *position = i;
+  *out = o;
+  return status;
+}
@@ -0,0 +1,171 @@
+// Author: Kevin Imlay
+
+/*
+A transducer writes output symbols as a machine runs, instead of calling an action per state. Each
+transition may carry an output string (Mealy), and each state an output string written whenever it is
+entered (Moore). The strings are kept in one pool and found through tables parallel to the transition
+table and the state array. On each transition, the transition's output is written and then the new
+state's.
+
+transduce() writes the outputs straight into a caller's buffer with no calls per symbol. The longest
+output of one step is known, so the room left in the buffer is checked once for as many steps as are
+sure to fit, and only near the end of the buffer is each step checked. When every output is short, each
+is copied at a fixed width and the output advanced by its length, so copying does not branch on it.
+*/
+
+#ifndef TRANSDUCER_H
+#define TRANSDUCER_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Outputs no longer than this are copied at this width by transduce(), when all of them are. Outputs of at
+most one symbol are copied one symbol at a time, and a kind of output that is always empty is not read.
+*/
+#define TRANSDUCER_WIDE 4
+
+
+/* ----- Structures ----- */
+
+/*
+Output string in a transducer's pool.
+*/
+typedef struct {
+  unsigned int first;
+  unsigned int length;
+} OutputSpan;
+
+
+/*
+Outputs of a machine's transitions and states.
+*/
+typedef struct {
+  FSM *fsm;
+
+  // output of each transition, indexed as the transition table, and of entering each state
+  OutputSpan *trans;
+  OutputSpan *state;
+
+  // output strings
+  unsigned int *pool;
+  size_t pool_count;
+  size_t pool_capacity;
+
+  // longest output of a transition and of a state
+  unsigned int trans_max;
+  unsigned int state_max;
+
+} Transducer;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Transducer
+Allocates the output tables of a machine, with every output empty.
+
+Arguments:
+  • transducer - pointer to the transducer to initialize.
+  • fsm - pointer to an initialized FSM.
+      Note: its size must not be changed while the transducer is in use.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - either pointer provided was null, or the machine is not initialized.
+*/
+FSM_STATUS initTransducer(Transducer *transducer, FSM *fsm);
+
+
+/*
+Free Transducer
+Releases the memory held by a transducer.
+
+Arguments:
+  • transducer - pointer to the transducer.
+      Note: may be null.
+*/
+void freeTransducer(Transducer *transducer);
+
+
+/*
+Set Transition Output
+Sets the output written when a transition is taken.
+
+Arguments:
+  • transducer - pointer to the transducer.
+  • from_state_id - ID of the state the transition leaves.
+  • symbol - symbol of the transition.
+  • output - array of output symbols, copied into the transducer.
+  • output_length - length of the output array, 0 for no output.
+      Note: a replaced output's space in the pool is not reused.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_STATE - if the state does not exist.
+  • FSM_SIZE_ERR - if the symbol is not in the machine's alphabet.
+  • FSM_NO_MACHINE - if the transducer is null or not initialized.
+*/
+FSM_STATUS setTransOutput(Transducer *transducer, unsigned int from_state_id, unsigned int symbol,
+                          const unsigned int *output, unsigned int output_length);
+
+
+/*
+Set State Output
+Sets the output written when a state is entered.
+
+Arguments:
+  • transducer - pointer to the transducer.
+  • state_id - ID of the state.
+  • output - array of output symbols, copied into the transducer.
+  • output_length - length of the output array, 0 for no output.
+      Note: a replaced output's space in the pool is not reused.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_STATE - if the state does not exist.
+  • FSM_NO_MACHINE - if the transducer is null or not initialized.
+*/
+FSM_STATUS setStateOutput(Transducer *transducer, unsigned int state_id, const unsigned int *output,
+                          unsigned int output_length);
+
+
+/*
+Transduce
+Steps an interpreter over an input, writing the output of each transition and of each state entered.
+Stops before a step whose output does not fit, so a full buffer can be emptied and the rest of the input
+continued with the same interpreter. No actions are run, and the output of the state the input starts
+in is not written again.
+
+Arguments:
+  • interp - pointer to an interpreter on the transducer's machine.
+  • transducer - pointer to the transducer.
+  • input - array of unsigned integers as symbol inputs.
+  • input_length - length of the input array.
+  • output - [pass back] array the output symbols are written to.
+  • capacity - length of the output array.
+  • written - [pass back] count of output symbols written.
+  • consumed - [pass back] count of input symbols stepped.
+
+Returns:
+  • INTERP_ACCEPT - if the whole input was stepped and ends in a final state.
+  • INTERP_NO_ACCEPT - if the whole input was stepped and does not end in a final state.
+  • INTERP_OK - if the output array filled up first.
+  • INTERP_SYMB_ERR - if a symbol is invalid.
+  • INTERP_TRANS_ERR - if a symbol does not have a transition out of the current state.
+      Note: on any of these the interpreter is left after the last symbol stepped.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null, or not the transducer's.
+*/
+INTERP_STATUS transduce(Interpreter *interp, const Transducer *transducer, const unsigned int *input,
+                        size_t input_length, unsigned int *output, size_t capacity, size_t *written,
+                        size_t *consumed);
+
+#endif
@@ -0,0 +1,311 @@
+// Author: Kevin Imlay
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unicode.h"
+
+/* ----- Private Definitions ----- */
+
+#define CLASS_PAGE_SIZE (1u << CLASS_PAGE_BITS)
+
+/*
+Slots of the hash table used to find equal pages while freezing, a power of two over CLASS_PAGE_COUNT.
+*/
+#define CLASS_HASH_SLOTS 8192u
+
+
+/* ----- Private Function Prototypes ----- */
+
+static unsigned int hashPage(const unsigned short *page);
+static inline int stepClass(Interpreter *interp, State **table, unsigned int symbol_count,
+                            unsigned int symbol_class);
+
+
+/* ----- Public Function Definitions ----- */
+
+/*
+Initialize Class Map
+Actions:
+  • allocate the class of every code point for building, all in class 0
+*/
+FSM_STATUS initClassMap(ClassMap *map, unsigned int class_count) {
+  // validate inputs
+  if (map == NULL)
+    return FSM_NO_MACHINE;
+  if (class_count == 0 || class_count > CLASS_MAX)
+    return FSM_SIZE_ERR;
+
+  // allocate
+  map->index = NULL;
+  map->pages = NULL;
+  map->page_count = 0;
+  map->building = calloc(UNICODE_CODE_POINTS, sizeof(unsigned short));
+  if (map->building == NULL)
+    return FSM_ALLOC_ERR;
+
+  map->class_count = class_count;
+  memset(map->ascii, 0, sizeof(map->ascii));
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Set Class Range
+Actions:
+  • set the class of each code point in the range
+*/
+FSM_STATUS setClassRange(ClassMap *map, unsigned int first, unsigned int last, unsigned int symbol_class) {
+  // validate inputs
+  if (map == NULL || map->building == NULL)
+    return FSM_NO_MACHINE;
+  if (first > last || last >= UNICODE_CODE_POINTS || symbol_class >= map->class_count)
+    return FSM_SIZE_ERR;
+
+  for (unsigned int code_point = first; code_point <= last; code_point++)
+    map->building[code_point] = (unsigned short)symbol_class;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Freeze Class Map
+Actions:
+  • copy the ASCII classes to their direct table
+  • keep the first of each set of equal pages, found through a hash of the page
+  • point each page of the index at its kept page, and free the building classes
+*/
+FSM_STATUS freezeClassMap(ClassMap *map) {
+  // validate inputs
+  if (map == NULL || map->building == NULL)
+    return FSM_NO_MACHINE;
+
+  // allocate
+  map->index = malloc(CLASS_PAGE_COUNT * sizeof(unsigned short));
+  unsigned short *first_page = malloc(CLASS_PAGE_COUNT * sizeof(unsigned short));
+  unsigned int *slots = malloc(CLASS_HASH_SLOTS * sizeof(unsigned int));
+  if (map->index == NULL || first_page == NULL || slots == NULL) {
+    free(map->index);
+    free(first_page);
+    free(slots);
+    map->index = NULL;
+    return FSM_ALLOC_ERR;
+  }
+  for (unsigned int i = 0; i < CLASS_HASH_SLOTS; i++)
+    slots[i] = CLASS_PAGE_COUNT;
+
+  // find distinct pages, slots hold the page number of the first page with each content
+  unsigned int page_count = 0;
+  for (unsigned int page = 0; page < CLASS_PAGE_COUNT; page++) {
+    const unsigned short *classes = map->building + (size_t)page * CLASS_PAGE_SIZE;
+    unsigned int slot = hashPage(classes) & (CLASS_HASH_SLOTS - 1);
+
+    while (slots[slot] != CLASS_PAGE_COUNT &&
+           memcmp(map->building + (size_t)slots[slot] * CLASS_PAGE_SIZE, classes,
+                  CLASS_PAGE_SIZE * sizeof(unsigned short)) != 0)
+      slot = (slot + 1) & (CLASS_HASH_SLOTS - 1);
+
+    if (slots[slot] == CLASS_PAGE_COUNT) {
+      slots[slot] = page;
+      first_page[page_count] = (unsigned short)page;
+      map->index[page] = (unsigned short)page_count++;
+    }
+    else
+      map->index[page] = map->index[slots[slot]];
+  }
+  free(slots);
+
+  // copy distinct pages
+  map->pages = malloc((size_t)page_count * CLASS_PAGE_SIZE * sizeof(unsigned short));
+  if (map->pages == NULL) {
+    free(map->index);
+    free(first_page);
+    map->index = NULL;
+    return FSM_ALLOC_ERR;
+  }
+  for (unsigned int i = 0; i < page_count; i++)
+    memcpy(map->pages + (size_t)i * CLASS_PAGE_SIZE, map->building + (size_t)first_page[i] * CLASS_PAGE_SIZE,
+           CLASS_PAGE_SIZE * sizeof(unsigned short));
+  free(first_page);
+
+  memcpy(map->ascii, map->building, sizeof(map->ascii));
+  map->page_count = page_count;
+  free(map->building);
+  map->building = NULL;
+
+  // successful
+  return FSM_OK;
+}
+
+
+/*
+Free Class Map
+Actions:
+  • free the index, pages and building classes
+*/
+void freeClassMap(ClassMap *map) {
+  if (map == NULL)
+    return;
+
+  free(map->index);
+  free(map->pages);
+  free(map->building);
+  map->index = NULL;
+  map->pages = NULL;
+  map->building = NULL;
+  map->page_count = 0;
+}
+
+
+/*
+Run UTF-8
+Actions:
+  • runs the action in the start state
+  • steps eight ASCII bytes at a time while the text is ASCII
+  • otherwise decodes one code point, checking its continuation bytes and range
+  • steps on the class of each code point, running the action of each state
+  • failing transitions are handed to transition() to report the error
+*/
+INTERP_STATUS runUTF8(Interpreter *interp, const ClassMap *map, const unsigned char *text, size_t length,
+                      size_t *error_offset) {
+  INTERP_STATUS interp_status;
+
+  // validate input
+  if (interp == NULL)
+    return INTERP_NO_INTERP;
+  if (interp->fsm == NULL || map == NULL || map->index == NULL)
+    return INTERP_NO_MACHINE;
+  if (map->class_count > interp->fsm->Ec) {
+    *error_offset = 0;
+    return INTERP_SYMB_ERR;
+  }
+
+  // run action in start state
+  interp_status = runState(interp);
+  if (interp_status != INTERP_OK)
+    return interp_status;
+
+  State **table = interp->fsm->D;
+  unsigned int symbol_count = interp->fsm->Ec;
+  size_t i = 0;
+
+  while (i < length) {
+    // ASCII run
+    unsigned long long word;
+    if (i + 8 <= length) {
+      memcpy(&word, text + i, sizeof(word));
+      if ((word & 0x8080808080808080ULL) == 0) {
+        for (unsigned int k = 0; k < 8; k++) {
+          if (!stepClass(interp, table, symbol_count, map->ascii[text[i + k]])) {
+            *error_offset = i + k;
+            State *new_state;
+            return transition(interp, map->ascii[text[i + k]], &new_state);
+          }
+        }
+        i += 8;
+        continue;
+      }
+    }
+
+    // decode one code point
+    unsigned int lead = text[i];
+    unsigned int code_point, count, smallest;
+    if (lead < 0x80) {
+      code_point = lead;
+      count = 1;
+      smallest = 0;
+    }
+    else if ((lead & 0xE0) == 0xC0) {
+      code_point = lead & 0x1F;
+      count = 2;
+      smallest = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+      code_point = lead & 0x0F;
+      count = 3;
+      smallest = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+      code_point = lead & 0x07;
+      count = 4;
+      smallest = 0x10000;
+    }
+    else {
+      *error_offset = i;
+      return INTERP_ENCODING_ERR;
+    }
+
+    if (count > length - i) {
+      *error_offset = i;
+      return INTERP_ENCODING_ERR;
+    }
+    for (unsigned int k = 1; k < count; k++) {
+      if ((text[i + k] & 0xC0) != 0x80) {
+        *error_offset = i;
+        return INTERP_ENCODING_ERR;
+      }
+      code_point = (code_point << 6) | (text[i + k] & 0x3F);
+    }
+    if (code_point < smallest || code_point >= UNICODE_CODE_POINTS ||
+        (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+      *error_offset = i;
+      return INTERP_ENCODING_ERR;
+    }
+
+    // step
+    unsigned int symbol_class = classOf(map, code_point);
+    if (!stepClass(interp, table, symbol_count, symbol_class)) {
+      *error_offset = i;
+      State *new_state;
+      return transition(interp, symbol_class, &new_state);
+    }
+    i += count;
+  }
+
+  // check accept state
+  if (interp->current_state->type == ACCEPT_STATE)
+    return INTERP_ACCEPT;
+  else
+    return INTERP_NO_ACCEPT;
+}
+
+
+/* ----- Private Function Definitions ----- */
+
+/*
+Hash Page
+Actions:
+  • FNV-1a over the classes of a page
+*/
+static unsigned int hashPage(const unsigned short *page) {
+  unsigned int hash = 2166136261u;
+  for (unsigned int i = 0; i < CLASS_PAGE_SIZE; i++) {
+    hash ^= page[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+
+/*
+Step Class
+Actions:
+  • transitions on a class and runs the new state's action
+  • returns 0 without moving if there is no transition
+*/
+static inline int stepClass(Interpreter *interp, State **table, unsigned int symbol_count,
+                            unsigned int symbol_class) {
+  State *next_state = table[(size_t)interp->current_state->id * symbol_count + symbol_class];
+  if (next_state == NULL)
+    return 0;
+
+  interp->current_state = next_state;
+  interp->position++;
+  if (next_state->action != NULL)
+    (*next_state->action)();
+  return 1;
+}
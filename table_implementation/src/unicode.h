@@ -0,0 +1,186 @@
+// Author: Kevin Imlay
+
+/*
+Machines over large alphabets, such as Unicode code points, do not use the code points as symbols
+directly, as every state's row of the transition table would need over a million fields. Instead, code
+points are mapped to a small number of symbol classes, and the machine's symbols are the classes. Code
+points the machine treats the same share a class.
+
+The class map is built with a class for every code point, then frozen into a two-level table: code
+points are split into pages of 256, and each page's classes are stored once however many pages share
+them. A lookup is one read of the page index and one of the page, ASCII is looked up directly.
+
+runUTF8() decodes UTF-8 text and runs each code point's class through the interpreter, without first
+converting the text to an array of symbols.
+*/
+
+#ifndef UNICODE_H
+#define UNICODE_H
+
+#include <stddef.h>
+
+#include "interpreter.h"
+
+
+/* ----- Definitions ----- */
+
+/*
+Count of Unicode code points, U+0000 to U+10FFFF.
+*/
+#define UNICODE_CODE_POINTS 0x110000u
+
+/*
+Code points per page of the class map are 1 << CLASS_PAGE_BITS.
+*/
+#define CLASS_PAGE_BITS 8
+
+/*
+Count of pages covering every code point.
+*/
+#define CLASS_PAGE_COUNT (UNICODE_CODE_POINTS >> CLASS_PAGE_BITS)
+
+/*
+Most classes a class map can hold.
+*/
+#define CLASS_MAX 65536u
+
+
+/* ----- Structures ----- */
+
+/*
+Map from code points to symbol classes.
+*/
+typedef struct {
+  // count of classes, the symbol count of the machines the map is used with
+  unsigned int class_count;
+
+  // class of each ASCII code point
+  unsigned short ascii[128];
+
+  // page of each 1 << CLASS_PAGE_BITS code points, CLASS_PAGE_COUNT entries, once frozen
+  unsigned short *index;
+
+  // classes of each distinct page, once frozen
+  unsigned short *pages;
+
+  // count of distinct pages
+  unsigned int page_count;
+
+  // class of every code point while the map is built, null once frozen
+  unsigned short *building;
+
+} ClassMap;
+
+
+/* ----- Public Function Prototypes ----- */
+
+/*
+Initialize Class Map
+Starts building a class map with every code point in class 0.
+
+Arguments:
+  • map - pointer to the class map to initialize.
+  • class_count - count of classes.
+      Note: must be from 1 to CLASS_MAX.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_SIZE_ERR - if the class count is out of range.
+  • FSM_NO_MACHINE - if the map pointer provided was null.
+*/
+FSM_STATUS initClassMap(ClassMap *map, unsigned int class_count);
+
+
+/*
+Set Class Range
+Puts a range of code points in a class.
+
+Arguments:
+  • map - pointer to the class map, not yet frozen.
+  • first - first code point of the range.
+  • last - last code point of the range, inclusive.
+  • symbol_class - class to put the code points in.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_SIZE_ERR - if the range is not within the code points, or the class is not in the map.
+  • FSM_NO_MACHINE - if the map pointer provided was null, or the map is frozen.
+*/
+FSM_STATUS setClassRange(ClassMap *map, unsigned int first, unsigned int last, unsigned int symbol_class);
+
+
+/*
+Freeze Class Map
+Compacts the class map into its two-level table. The map can be looked up once frozen, and can no longer
+be changed.
+
+Arguments:
+  • map - pointer to the class map.
+
+Returns:
+  • FSM_OK - if successful.
+  • FSM_ALLOC_ERR - if needed memory was not able to be allocated.
+  • FSM_NO_MACHINE - if the map pointer provided was null, or the map is already frozen.
+*/
+FSM_STATUS freezeClassMap(ClassMap *map);
+
+
+/*
+Free Class Map
+Releases the memory held by a class map.
+
+Arguments:
+  • map - pointer to the class map.
+      Note: may be null.
+*/
+void freeClassMap(ClassMap *map);
+
+
+/*
+Run UTF-8
+Runs the interpreter on UTF-8 text, the same as runInterpreter() on the class of each code point.
+Decoding is strict: overlong forms, surrogates and code points past U+10FFFF are encoding errors.
+
+Arguments:
+  • interp - pointer to the interpreter.
+      Note: the machine's symbol count must be the map's class count.
+  • map - pointer to a frozen class map.
+  • text - UTF-8 bytes.
+  • length - count of bytes.
+  • error_offset - [pass back] offset of the first byte of the code point that failed.
+      Note: only written when INTERP_ENCODING_ERR, INTERP_SYMB_ERR or INTERP_TRANS_ERR is returned.
+
+Returns:
+  • INTERP_ACCEPT - if ends in a final state.
+  • INTERP_NO_ACCEPT - if does not end in a final state.
+  • INTERP_ENCODING_ERR - if the text is not valid UTF-8, including text that ends part way through a
+      code point.
+  • INTERP_SYMB_ERR - if the machine has fewer symbols than the map has classes.
+  • INTERP_TRANS_ERR - if a code point's class does not have a transition out of the current state.
+  • INTERP_NO_INTERP - if the interpreter provided is null.
+  • INTERP_NO_MACHINE - if the machine is null (not initialized), or the map is null or not frozen.
+*/
+INTERP_STATUS runUTF8(Interpreter *interp, const ClassMap *map, const unsigned char *text, size_t length,
+                      size_t *error_offset);
+
+
+/*
+Class Of
+Looks up the class of a code point.
+
+Arguments:
+  • map - pointer to a frozen class map.
+  • code_point - code point, must be less than UNICODE_CODE_POINTS.
+
+Returns:
+  • class of the code point.
+*/
+static inline unsigned int classOf(const ClassMap *map, unsigned int code_point) {
+  if (code_point < 128)
+    return map->ascii[code_point];
+  return map->pages[((size_t)map->index[code_point >> CLASS_PAGE_BITS] << CLASS_PAGE_BITS) |
+                    (code_point & ((1u << CLASS_PAGE_BITS) - 1))];
+}
+
+#endif